@@ -0,0 +1,192 @@
+#ifndef AGGREGATE_ARRAY_H
+#define AGGREGATE_ARRAY_H
+
+#include "figure.h"
+#include "array.h"
+#include "figure_kind.h"
+#include "bounding_box.h"
+#include "summation.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Куча с ленивым удалением: удаленные значения копятся во второй куче
+// и выбрасываются, когда оказываются на вершине. Если удаленных становится
+// больше, чем живых, обе кучи перестраиваются без них, так что память
+// пропорциональна числу живых значений, а удаление остается O(log n) амортизированно.
+template<typename V, typename Compare>
+class LazyHeap {
+private:
+    mutable std::vector<V> values;
+    mutable std::vector<V> removed;
+
+    void compact() {
+        // Разность мультимножеств: каждое удаленное значение убирает ровно одну копию.
+        std::sort(values.begin(), values.end(), Compare());
+        std::sort(removed.begin(), removed.end(), Compare());
+        std::vector<V> live;
+        live.reserve(values.size() - removed.size());
+        std::set_difference(values.begin(), values.end(), removed.begin(), removed.end(),
+                            std::back_inserter(live), Compare());
+        values = std::move(live);
+        std::make_heap(values.begin(), values.end(), Compare());
+        removed.clear();
+    }
+
+public:
+    void push(V value) {
+        values.push_back(value);
+        std::push_heap(values.begin(), values.end(), Compare());
+    }
+
+    // value обязано быть ранее добавлено через push
+    void erase(V value) {
+        removed.push_back(value);
+        std::push_heap(removed.begin(), removed.end(), Compare());
+        if (removed.size() > values.size() - removed.size()) {
+            compact();
+        }
+    }
+
+    V top() const {
+        while (!removed.empty() && values.front() == removed.front()) {
+            std::pop_heap(values.begin(), values.end(), Compare());
+            values.pop_back();
+            std::pop_heap(removed.begin(), removed.end(), Compare());
+            removed.pop_back();
+        }
+        return values.front();
+    }
+
+    // Число хранимых значений, включая еще не выброшенные удаленные.
+    size_t getStoredCount() const { return values.size() + removed.size(); }
+
+    void clear() {
+        values.clear();
+        removed.clear();
+    }
+};
+
+// Массив фигур, который поддерживает агрегаты при каждом изменении:
+// общая площадь (компенсированная сумма), число фигур каждого типа — O(1),
+// минимальная/максимальная площадь и общий ограничивающий прямоугольник —
+// O(log n) амортизированно.
+template<Scalar T>
+class AggregateArray {
+private:
+    struct Stats {
+        T area;
+        BoundingBox<T> box;
+        FigureKind kind;
+    };
+
+    Array<std::shared_ptr<Figure<T>>> figures;
+    Array<Stats> stats;
+    NeumaierSum total;
+    size_t kindCounts[FigureKindCount];
+    LazyHeap<T, std::greater<T>> minAreas;
+    LazyHeap<T, std::less<T>> maxAreas;
+    LazyHeap<T, std::greater<T>> minXs;
+    LazyHeap<T, std::greater<T>> minYs;
+    LazyHeap<T, std::less<T>> maxXs;
+    LazyHeap<T, std::less<T>> maxYs;
+
+    void checkNotEmpty() const {
+        if (figures.isEmpty()) {
+            throw std::logic_error("Массив пуст");
+        }
+    }
+
+public:
+    AggregateArray() : kindCounts{} {}
+
+    AggregateArray(const AggregateArray&) = delete;
+    AggregateArray& operator=(const AggregateArray&) = delete;
+    AggregateArray(AggregateArray&&) noexcept = default;
+    AggregateArray& operator=(AggregateArray&&) noexcept = default;
+
+    void pushBack(std::shared_ptr<Figure<T>> figure) {
+        if (!figure) {
+            throw std::invalid_argument("пустой указатель на фигуру");
+        }
+        Stats s{figure->area(), ::boundingBox(*figure), figureKind(*figure)};
+        figures.pushBack(std::move(figure));
+        stats.pushBack(s);
+
+        total.add(static_cast<double>(s.area));
+        ++kindCounts[static_cast<size_t>(s.kind)];
+        minAreas.push(s.area);
+        maxAreas.push(s.area);
+        minXs.push(s.box.minX);
+        minYs.push(s.box.minY);
+        maxXs.push(s.box.maxX);
+        maxYs.push(s.box.maxY);
+    }
+
+    void remove(size_t index) {
+        if (index >= figures.getSize()) {
+            throw std::out_of_range("Index out of range");
+        }
+        Stats s = stats[index];
+        figures.remove(index);
+        stats.remove(index);
+
+        total.add(-static_cast<double>(s.area));
+        --kindCounts[static_cast<size_t>(s.kind)];
+        minAreas.erase(s.area);
+        maxAreas.erase(s.area);
+        minXs.erase(s.box.minX);
+        minYs.erase(s.box.minY);
+        maxXs.erase(s.box.maxX);
+        maxYs.erase(s.box.maxY);
+    }
+
+    void clear() {
+        figures.clear();
+        stats.clear();
+        total.reset();
+        for (size_t& count : kindCounts) {
+            count = 0;
+        }
+        minAreas.clear();
+        maxAreas.clear();
+        minXs.clear();
+        minYs.clear();
+        maxXs.clear();
+        maxYs.clear();
+    }
+
+    const std::shared_ptr<Figure<T>>& operator[](size_t index) const {
+        return figures[index];
+    }
+
+    const Array<std::shared_ptr<Figure<T>>>& getFigures() const { return figures; }
+
+    double totalArea() const { return figures.isEmpty() ? 0.0 : total.value(); }
+
+    size_t count(FigureKind kind) const { return kindCounts[static_cast<size_t>(kind)]; }
+
+    T minArea() const {
+        checkNotEmpty();
+        return minAreas.top();
+    }
+
+    T maxArea() const {
+        checkNotEmpty();
+        return maxAreas.top();
+    }
+
+    BoundingBox<T> boundingBox() const {
+        checkNotEmpty();
+        return BoundingBox<T>{minXs.top(), minYs.top(), maxXs.top(), maxYs.top()};
+    }
+
+    size_t getSize() const { return figures.getSize(); }
+    bool isEmpty() const { return figures.isEmpty(); }
+};
+
+#endif
\ No newline at end of file
@@ -1,107 +1,196 @@
-#ifndef ARRAY_H
-#define ARRAY_H
-
-#include <memory>
-#include <stdexcept>
-#include <utility>
-
-template<typename T>
-class Array {
-private:
-    std::unique_ptr<T[]> data;
-    size_t size;
-    size_t capacity;
-
-    void resize(size_t newCapacity) {
-        auto newData = std::make_unique<T[]>(newCapacity);
-        for (size_t i = 0; i < size; ++i) {
-            newData[i] = std::move(data[i]);
-        }
-
-        data = std::move(newData);
-        capacity = newCapacity;
-    }
-
-public:
-    Array() : data(nullptr), size(0), capacity(0) {}
-
-    explicit Array(size_t initialCapacity)
-        : data(std::make_unique<T[]>(initialCapacity)),
-          size(0),
-          capacity(initialCapacity) {}
-
-    Array(const Array&) = delete;
-    Array& operator=(const Array&) = delete;
-
-    Array(Array&& other) noexcept
-        : data(std::move(other.data)),
-          size(other.size),
-          capacity(other.capacity) {
-        other.size = 0;
-        other.capacity = 0;
-    }
-
-    Array& operator=(Array&& other) noexcept {
-        if (this != &other) {
-            data = std::move(other.data);
-            size = other.size;
-            capacity = other.capacity;
-            other.size = 0;
-            other.capacity = 0;
-        }
-        return *this;
-    }
-
-    void pushBack(T&& value) {
-        if (size >= capacity) {
-            size_t newCapacity = (capacity == 0) ? 1 : capacity * 2;
-            resize(newCapacity);
-        }
-        data[size++] = std::move(value);
-    }
-
-    void pushBack(const T& value) {
-        if (size >= capacity) {
-            size_t newCapacity = (capacity == 0) ? 1 : capacity * 2;
-            resize(newCapacity);
-        }
-        data[size++] = value;
-    }
-
-    void remove(size_t index) {
-        if (index >= size) {
-            throw std::out_of_range("Index out of range");
-        }
-
-        for (size_t i = index; i < size - 1; ++i) {
-            data[i] = std::move(data[i + 1]);
-        }
-        --size;
-    }
-
-    void clear() {
-        size = 0;
-    }
-
-    T& operator[](size_t index) {
-        if (index >= size) {
-            throw std::out_of_range("Index out of range");
-        }
-        return data[index];
-    }
-
-    const T& operator[](size_t index) const {
-        if (index >= size) {
-            throw std::out_of_range("Index out of range");
-        }
-        return data[index];
-    }
-
-    size_t getSize() const { return size; }
-    size_t getCapacity() const { return capacity; }
-    bool isEmpty() const { return size == 0; }
-
-    ~Array() = default;
-};
-
+#ifndef ARRAY_H
+#define ARRAY_H
+
+#include <cassert>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+template<typename T>
+class Array {
+private:
+    std::unique_ptr<T[]> data;
+    size_t size;
+    size_t capacity;
+
+    void resize(size_t newCapacity) {
+        auto newData = std::make_unique<T[]>(newCapacity);
+        for (size_t i = 0; i < size; ++i) {
+            newData[i] = std::move(data[i]);
+        }
+
+        data = std::move(newData);
+        capacity = newCapacity;
+    }
+
+public:
+    Array() : data(nullptr), size(0), capacity(0) {}
+
+    explicit Array(size_t initialCapacity)
+        : data(std::make_unique<T[]>(initialCapacity)),
+          size(0),
+          capacity(initialCapacity) {}
+
+    Array(const Array&) = delete;
+    Array& operator=(const Array&) = delete;
+
+    Array(Array&& other) noexcept
+        : data(std::move(other.data)),
+          size(other.size),
+          capacity(other.capacity) {
+        other.size = 0;
+        other.capacity = 0;
+    }
+
+    Array& operator=(Array&& other) noexcept {
+        if (this != &other) {
+            data = std::move(other.data);
+            size = other.size;
+            capacity = other.capacity;
+            other.size = 0;
+            other.capacity = 0;
+        }
+        return *this;
+    }
+
+    void reserve(size_t newCapacity) {
+        if (newCapacity > capacity) {
+            resize(newCapacity);
+        }
+    }
+
+    void pushBack(T&& value) {
+        if (size >= capacity) {
+            size_t newCapacity = (capacity == 0) ? 1 : capacity * 2;
+            resize(newCapacity);
+        }
+        data[size++] = std::move(value);
+    }
+
+    void pushBack(const T& value) {
+        if (size >= capacity) {
+            size_t newCapacity = (capacity == 0) ? 1 : capacity * 2;
+            resize(newCapacity);
+        }
+        data[size++] = value;
+    }
+
+    // Вставка со сдвигом хвоста вправо, index == size добавляет в конец.
+    void insert(size_t index, T value) {
+        if (index > size) {
+            throw std::out_of_range("Index out of range");
+        }
+        if (size >= capacity) {
+            size_t newCapacity = (capacity == 0) ? 1 : capacity * 2;
+            resize(newCapacity);
+        }
+
+        for (size_t i = size; i > index; --i) {
+            data[i] = std::move(data[i - 1]);
+        }
+        data[index] = std::move(value);
+        ++size;
+    }
+
+    void remove(size_t index) {
+        if (index >= size) {
+            throw std::out_of_range("Index out of range");
+        }
+
+        for (size_t i = index; i < size - 1; ++i) {
+            data[i] = std::move(data[i + 1]);
+        }
+        --size;
+    }
+
+    void clear() {
+        size = 0;
+    }
+
+    T& operator[](size_t index) {
+        if (index >= size) {
+            throw std::out_of_range("Index out of range");
+        }
+        return data[index];
+    }
+
+    const T& operator[](size_t index) const {
+        if (index >= size) {
+            throw std::out_of_range("Index out of range");
+        }
+        return data[index];
+    }
+
+    // Доступ без проверки для горячих циклов, где индекс уже ограничен размером.
+    // В отладочной сборке (без NDEBUG) индекс проверяется assert.
+    T& atUnchecked(size_t index) {
+        assert(index < size);
+        return data[index];
+    }
+
+    const T& atUnchecked(size_t index) const {
+        assert(index < size);
+        return data[index];
+    }
+
+    // Элементы лежат подряд, поэтому итераторами служат указатели,
+    // а range-for и алгоритмы std проходят массив без проверок индекса.
+    T* begin() { return data.get(); }
+    T* end() { return data.get() + size; }
+    const T* begin() const { return data.get(); }
+    const T* end() const { return data.get() + size; }
+
+    std::span<T> span() { return std::span<T>(data.get(), size); }
+    std::span<const T> span() const { return std::span<const T>(data.get(), size); }
+
+    template<typename F>
+    void forEach(F&& body) {
+        for (T& value : *this) {
+            body(value);
+        }
+    }
+
+    template<typename F>
+    void forEach(F&& body) const {
+        for (const T& value : *this) {
+            body(value);
+        }
+    }
+
+    // Свертка reduce(init, transform(x0), transform(x1), ...) в четыре независимые
+    // полосы, как у std::transform_reduce: reduce должна быть ассоциативной и коммутативной.
+    // Полосы не ждут друг друга, и для чисел цикл векторизуется.
+    template<typename R, typename Reduce, typename Transform>
+    R transformReduce(R init, Reduce reduce, Transform transform) const {
+        const T* v = data.get();
+        if (size < 4) {
+            for (size_t i = 0; i < size; ++i) {
+                init = reduce(init, transform(v[i]));
+            }
+            return init;
+        }
+        size_t full = size - size % 4;
+        R lanes[4] = {transform(v[0]), transform(v[1]), transform(v[2]), transform(v[3])};
+        for (size_t i = 4; i < full; i += 4) {
+            for (size_t l = 0; l < 4; ++l) {
+                lanes[l] = reduce(lanes[l], transform(v[i + l]));
+            }
+        }
+        for (size_t i = full; i < size; ++i) {
+            lanes[0] = reduce(lanes[0], transform(v[i]));
+        }
+        return reduce(init, reduce(reduce(lanes[0], lanes[1]), reduce(lanes[2], lanes[3])));
+    }
+
+    size_t getSize() const { return size; }
+    size_t getCapacity() const { return capacity; }
+    bool isEmpty() const { return size == 0; }
+
+    // Байты, занятые самим массивом и его буфером (без памяти, на которую ссылаются элементы).
+    size_t memoryUsage() const { return sizeof(*this) + capacity * sizeof(T); }
+
+    ~Array() = default;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,473 @@
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include "figure.h"
+#include "array.h"
+#include "bounding_box.h"
+#include "figure_io.h"
+#include "summation.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Пул потоков, на котором возобновляются корутины: co_await pool.schedule().
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::coroutine_handle<>> queue;
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool stopping;
+
+    void run() {
+        for (;;) {
+            std::coroutine_handle<> handle;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                handle = queue.front();
+                queue.pop_front();
+            }
+            handle.resume();
+        }
+    }
+
+public:
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency()) : stopping(false) {
+        threads = std::max<size_t>(threads, 1);
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([this] { run(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void enqueue(std::coroutine_handle<> handle) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(handle);
+        }
+        ready.notify_one();
+    }
+
+    auto schedule() {
+        struct Awaiter {
+            ThreadPool& pool;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { pool.enqueue(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    size_t getSize() const { return workers.size(); }
+};
+
+// Жадная задача: начинает выполняться сразу при вызове корутины.
+// Результат забирается через co_await или syncWait; деструктор дожидается завершения.
+template<typename T>
+class Task {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+private:
+    static constexpr uintptr_t Running = 0;
+    static constexpr uintptr_t Done = 1;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(Handle handle) noexcept {
+            // После exchange кадр может быть уничтожен другим потоком, поэтому
+            // дальше используем только локальные значения.
+            uintptr_t continuation = handle.promise().state.exchange(Done, std::memory_order_acq_rel);
+            if (continuation != Running) {
+                return std::coroutine_handle<>::from_address(reinterpret_cast<void*>(continuation));
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::atomic<uintptr_t> state{Running};
+
+        Task get_return_object() { return Task(Handle::from_promise(*this)); }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_value(T result) { value.emplace(std::move(result)); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+private:
+    Handle handle;
+
+    explicit Task(Handle h) : handle(h) {}
+
+public:
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task() { reset(); }
+
+    void reset() {
+        if (handle) {
+            while (handle.promise().state.load(std::memory_order_acquire) != Done) {
+                std::this_thread::yield();
+            }
+            handle.destroy();
+            handle = nullptr;
+        }
+    }
+
+    bool isReady() const {
+        return handle && handle.promise().state.load(std::memory_order_acquire) == Done;
+    }
+
+    auto operator co_await() {
+        struct Awaiter {
+            Handle handle;
+
+            bool await_ready() const noexcept {
+                return handle.promise().state.load(std::memory_order_acquire) == Done;
+            }
+
+            bool await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                uintptr_t expected = Running;
+                uintptr_t continuation = reinterpret_cast<uintptr_t>(awaiting.address());
+                return handle.promise().state.compare_exchange_strong(
+                    expected, continuation, std::memory_order_acq_rel);
+            }
+
+            T await_resume() {
+                if (handle.promise().error) {
+                    std::rethrow_exception(handle.promise().error);
+                }
+                return std::move(*handle.promise().value);
+            }
+        };
+        return Awaiter{handle};
+    }
+};
+
+namespace detail {
+
+struct SyncWaitState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+};
+
+struct SyncWaitTask {
+    struct promise_type {
+        SyncWaitState* state = nullptr;
+
+        SyncWaitTask get_return_object() {
+            return SyncWaitTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+
+        auto final_suspend() const noexcept {
+            struct Notify {
+                bool await_ready() const noexcept { return false; }
+
+                void await_suspend(std::coroutine_handle<promise_type> handle) const noexcept {
+                    SyncWaitState* s = handle.promise().state;
+                    std::lock_guard<std::mutex> lock(s->mutex);
+                    s->done = true;
+                    s->cv.notify_one();
+                }
+
+                void await_resume() const noexcept {}
+            };
+            return Notify{};
+        }
+
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+template<typename T>
+SyncWaitTask awaitInto(Task<T>& task, std::optional<T>& result, std::exception_ptr& error) {
+    try {
+        result.emplace(co_await task);
+    } catch (...) {
+        error = std::current_exception();
+    }
+}
+
+}
+
+// Блокирует вызывающий поток до завершения задачи и возвращает ее результат.
+template<typename T>
+T syncWait(Task<T>& task) {
+    std::optional<T> result;
+    std::exception_ptr error;
+    detail::SyncWaitState state;
+    detail::SyncWaitTask waiter = detail::awaitInto(task, result, error);
+    waiter.handle.promise().state = &state;
+    waiter.handle.resume();
+    {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.cv.wait(lock, [&state] { return state.done; });
+    }
+    waiter.handle.destroy();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return std::move(*result);
+}
+
+template<typename T>
+T syncWait(Task<T>&& task) {
+    return syncWait(task);
+}
+
+// Ленивый синхронный генератор значений для co_yield.
+template<typename T>
+class Generator {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type {
+        std::optional<T> current;
+        std::exception_ptr error;
+
+        Generator get_return_object() { return Generator(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        std::suspend_always final_suspend() const noexcept { return {}; }
+
+        std::suspend_always yield_value(T value) {
+            current.emplace(std::move(value));
+            return {};
+        }
+
+        void return_void() const noexcept {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    struct Sentinel {};
+
+    class Iterator {
+    private:
+        Handle handle;
+
+    public:
+        explicit Iterator(Handle h) : handle(h) {}
+
+        T& operator*() const { return *handle.promise().current; }
+
+        Iterator& operator++() {
+            handle.promise().current.reset();
+            handle.resume();
+            rethrowIfFailed(handle);
+            return *this;
+        }
+
+        bool operator==(Sentinel) const { return handle.done(); }
+    };
+
+private:
+    Handle handle;
+
+    explicit Generator(Handle h) : handle(h) {}
+
+    static void rethrowIfFailed(Handle h) {
+        if (h.promise().error) {
+            std::rethrow_exception(h.promise().error);
+        }
+    }
+
+public:
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+
+    Generator(Generator&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    ~Generator() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    Iterator begin() {
+        handle.resume();
+        rethrowIfFailed(handle);
+        return Iterator(handle);
+    }
+
+    Sentinel end() const { return {}; }
+};
+
+// Делит поток на текстовые блоки примерно по blockBytes байт, не разрывая строки.
+inline Generator<std::string> readLineBlocks(std::istream& inpS, size_t blockBytes = 1 << 20) {
+    std::string carry;
+    std::string buffer(blockBytes, '\0');
+    while (inpS) {
+        inpS.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        size_t got = static_cast<size_t>(inpS.gcount());
+        if (got == 0) {
+            break;
+        }
+        size_t lastNewline = buffer.rfind('\n', got - 1);
+        if (lastNewline == std::string::npos) {
+            carry.append(buffer, 0, got);
+            continue;
+        }
+        std::string block = std::move(carry);
+        block.append(buffer, 0, lastNewline + 1);
+        carry.assign(buffer, lastNewline + 1, got - lastNewline - 1);
+        co_yield std::move(block);
+    }
+    if (!carry.empty()) {
+        co_yield std::move(carry);
+    }
+}
+
+// blockOffset — смещение блока в потоке: позиция в ParseError отсчитывается от начала потока.
+template<Scalar T>
+Task<Array<std::shared_ptr<Figure<T>>>> parseFiguresAsync(ThreadPool& pool, std::string block, size_t blockOffset = 0) {
+    co_await pool.schedule();
+    TraceSpan span("parseFigures");
+    try {
+        co_return parseFigures<T>(block);
+    } catch (const ParseError& err) {
+        throw ParseError(err.reason(), blockOffset + err.position());
+    }
+}
+
+// Выдает батчи разобранных фигур в порядке файла. Пока пул разбирает до inFlight
+// прочитанных блоков, вызывающий поток читает следующие, так что ввод-вывод
+// перекрывается с разбором.
+template<Scalar T>
+Generator<Array<std::shared_ptr<Figure<T>>>> readFigureBatches(
+        ThreadPool& pool, std::istream& inpS, size_t blockBytes = 1 << 20, size_t inFlight = 0) {
+    if (inFlight == 0) {
+        inFlight = 2 * pool.getSize();
+    }
+    std::deque<Task<Array<std::shared_ptr<Figure<T>>>>> pending;
+    size_t offset = 0;
+    for (std::string& block : readLineBlocks(inpS, blockBytes)) {
+        size_t length = block.size();
+        pending.push_back(parseFiguresAsync<T>(pool, std::move(block), offset));
+        offset += length;
+        if (pending.size() >= inFlight) {
+            co_yield syncWait(pending.front());
+            pending.pop_front();
+        }
+    }
+    while (!pending.empty()) {
+        co_yield syncWait(pending.front());
+        pending.pop_front();
+    }
+}
+
+namespace detail {
+
+template<Scalar T>
+Task<double> chunkArea(ThreadPool& pool, const Array<std::shared_ptr<Figure<T>>>& figures,
+                       size_t begin, size_t end) {
+    co_await pool.schedule();
+    NeumaierSum sum;
+    for (size_t i = begin; i < end; ++i) {
+        sum.add(static_cast<double>(*figures[i]));
+    }
+    co_return sum.value();
+}
+
+template<Scalar T>
+Task<std::vector<size_t>> chunkRange(ThreadPool& pool, const Array<std::shared_ptr<Figure<T>>>& figures,
+                                     size_t begin, size_t end, BoundingBox<T> box) {
+    co_await pool.schedule();
+    std::vector<size_t> found;
+    for (size_t i = begin; i < end; ++i) {
+        if (boundingBox(*figures[i]).intersects(box)) {
+            found.push_back(i);
+        }
+    }
+    co_return found;
+}
+
+}
+
+// Общая площадь, посчитанная кусками по chunk фигур на пуле.
+// Коллекция не должна изменяться до завершения задачи.
+template<Scalar T>
+Task<double> totalAreaAsync(ThreadPool& pool, const Array<std::shared_ptr<Figure<T>>>& figures,
+                            size_t chunk = 1 << 14) {
+    std::vector<Task<double>> parts;
+    for (size_t begin = 0; begin < figures.getSize(); begin += chunk) {
+        parts.push_back(detail::chunkArea(pool, figures, begin, std::min(figures.getSize(), begin + chunk)));
+    }
+    NeumaierSum total;
+    for (Task<double>& part : parts) {
+        total.add(co_await part);
+    }
+    co_return total.value();
+}
+
+// Индексы (по возрастанию) фигур, чей ограничивающий прямоугольник пересекает box.
+template<Scalar T>
+Task<std::vector<size_t>> rangeQueryAsync(ThreadPool& pool, const Array<std::shared_ptr<Figure<T>>>& figures,
+                                          BoundingBox<T> box, size_t chunk = 1 << 14) {
+    std::vector<Task<std::vector<size_t>>> parts;
+    for (size_t begin = 0; begin < figures.getSize(); begin += chunk) {
+        parts.push_back(detail::chunkRange(pool, figures, begin, std::min(figures.getSize(), begin + chunk), box));
+    }
+    std::vector<size_t> found;
+    for (Task<std::vector<size_t>>& part : parts) {
+        std::vector<size_t> indices = co_await part;
+        found.insert(found.end(), indices.begin(), indices.end());
+    }
+    co_return found;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,1244 @@
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../point.h"
+#include "../figure.h"
+#include "../array.h"
+#include "../square.h"
+#include "../rectangle.h"
+#include "../trapez.h"
+#include "../figure_index.h"
+#include "../figure_kind.h"
+#include "../memory_usage.h"
+#include "../compact_store.h"
+#include "../aggregate_array.h"
+#include "../async.h"
+#include "../intersection.h"
+#include "../union_area.h"
+#include "../convex_hull.h"
+#include "../figure_io.h"
+#include "../figure_parser.h"
+#include "../figure_journal.h"
+#include "../durable_store.h"
+#include "../partitioned_array.h"
+#include "../tile_pyramid.h"
+#include "../polygon.h"
+#include "../summation.h"
+#include "../workload.h"
+#include "../figure_server.h"
+#include "../chunked_array.h"
+#include "../figure_batch.h"
+#include "../figure_query.h"
+#include "../slot_map.h"
+#include "../shm_store.h"
+#include "../trace.h"
+
+using Figures = Array<std::shared_ptr<Figure<double>>>;
+
+template<typename F>
+double measureMs(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+std::shared_ptr<Figure<double>> makeFigure(int kind, double x, double y, double w, double h) {
+    Point<double> a(x, y), b(x + w, y), c(x + w, y + h), d(x, y + h);
+    switch (kind % 3) {
+        case 0:
+            return std::make_shared<Square<double>>(a, b, Point<double>(x + w, y + w), Point<double>(x, y + w));
+        case 1:
+            return std::make_shared<Rectangle<double>>(a, b, c, d);
+        default:
+            return std::make_shared<Trapezoid<double>>(a, b, Point<double>(x + 0.75 * w, y + h), Point<double>(x + 0.25 * w, y + h));
+    }
+}
+
+// Набор из n фигур, в котором примерно duplicateRate из них повторяют ранее добавленные.
+Figures makeFigures(size_t n, double duplicateRate, unsigned seed = 42, double extent = 1000.0) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> coord(-extent, extent);
+    std::uniform_real_distribution<double> side(0.1, 10.0);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+    Figures figures(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (i > 0 && coin(rng) < duplicateRate) {
+            figures.pushBack(figures[rng() % i]->clone());
+        } else {
+            figures.pushBack(makeFigure(static_cast<int>(rng() % 3), coord(rng), coord(rng), side(rng), side(rng)));
+        }
+    }
+    return figures;
+}
+
+// Сдвигает каждую фигуру на случайный вектор не длиннее shift по каждой оси:
+// повторы становятся почти совпадающими, а не точными копиями.
+Figures jitterFigures(const Figures& figures, double shift, unsigned seed = 7) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> offset(-shift, shift);
+    Figures shifted(figures.getSize());
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        double dx = offset(rng);
+        double dy = offset(rng);
+        Point<double> points[4];
+        for (size_t k = 0; k < 4; ++k) {
+            Point<double> p = figures[i]->getVertex(k);
+            points[k] = Point<double>(p.x + dx, p.y + dy);
+        }
+        shifted.pushBack(makeFigure(figureKind(*figures[i]), points));
+    }
+    return shifted;
+}
+
+void benchDedup(size_t n) {
+    std::cout << "dedup: n = " << n << std::endl;
+    const double eps = 1e-6;
+    for (double rate : {0.0, 0.1, 0.5, 0.9}) {
+        for (bool near : {false, true}) {
+            Figures figures = makeFigures(n, rate);
+            if (near) {
+                figures = jitterFigures(figures, eps / 2);
+            }
+            size_t removed = 0;
+            double ms = measureMs([&] { removed = removeDuplicates(figures, eps); });
+            std::cout << "  duplicate rate " << rate << (near ? " (near, eps " : " (exact, eps ") << eps
+                      << "): removed " << removed << " in " << ms << " ms" << std::endl;
+
+            FigureIndex<double> index(eps);
+            double buildMs = measureMs([&] { index.build(figures); });
+            size_t hits = 0;
+            double findMs = measureMs([&] {
+                for (size_t i = 0; i < figures.getSize(); ++i) {
+                    hits += index.find(*figures[i]).has_value();
+                }
+            });
+            std::cout << "    index build " << buildMs << " ms, " << hits << " lookups "
+                      << findMs * 1e6 / static_cast<double>(hits) << " ns/lookup, "
+                      << static_cast<double>(index.memoryUsage()) / static_cast<double>(index.getSize())
+                      << " bytes per figure" << std::endl;
+        }
+    }
+}
+
+template<typename Coord>
+void reportCompact(const char* name, const Figures& figures, double referenceArea) {
+    CompactFigureStore<Coord> store = CompactFigureStore<Coord>::fromFigures(figures);
+    double total = 0.0;
+    double ms = measureMs([&] { total = store.totalArea(); });
+    std::cout << "  " << name << ": " << store.memoryUsage() << " bytes ("
+              << static_cast<double>(store.memoryUsage()) / figures.getSize() << " per figure), totalArea "
+              << ms << " ms, coord error <= " << store.coordinateErrorBound()
+              << ", total area diff " << std::abs(total - referenceArea) << std::endl;
+}
+
+void benchMemory(size_t n) {
+    std::cout << "memory: n = " << n << std::endl;
+    Figures figures = makeFigures(n, 0.0);
+    size_t full = memoryUsage(figures);
+    double total = 0.0;
+    double ms = measureMs([&] {
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            total += figures[i]->area();
+        }
+    });
+    std::cout << "  Array<shared_ptr<Figure>>: " << full << " bytes ("
+              << static_cast<double>(full) / n << " per figure, buffer "
+              << figures.memoryUsage() << "), totalArea " << ms << " ms" << std::endl;
+    reportCompact<float>("float", figures, total);
+    reportCompact<int16_t>("int16", figures, total);
+}
+
+void benchAggregate(size_t n) {
+    std::cout << "aggregate: n = " << n << std::endl;
+    Figures figures = makeFigures(n, 0.0);
+
+    Figures plain;
+    double plainMs = measureMs([&] {
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            plain.pushBack(figures[i]);
+        }
+    });
+    AggregateArray<double> aggregated;
+    double aggMs = measureMs([&] {
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            aggregated.pushBack(figures[i]);
+        }
+    });
+    std::cout << "  insert: Array " << plainMs << " ms, AggregateArray " << aggMs << " ms" << std::endl;
+
+    double total = 0.0;
+    double rescanMs = measureMs([&] {
+        for (size_t i = 0; i < plain.getSize(); ++i) {
+            total += static_cast<double>(*plain[i]);
+        }
+    });
+    double cached = 0.0;
+    double cachedMs = measureMs([&] {
+        cached = aggregated.totalArea() + aggregated.maxArea() + aggregated.boundingBox().maxX;
+    });
+    std::cout << "  totalArea: rescan " << rescanMs << " ms, aggregate " << cachedMs * 1e3
+              << " us (diff " << std::abs(total - aggregated.totalArea()) << ")" << std::endl;
+
+    double removeMs = measureMs([&] {
+        for (int i = 0; i < 1000; ++i) {
+            aggregated.remove(aggregated.getSize() - 1);
+        }
+    });
+    std::cout << "  remove from tail: " << removeMs * 1e3 / 1000 << " us/op" << std::endl;
+    (void)cached;
+}
+
+void benchAsyncLoad(size_t n) {
+    std::cout << "async load: n = " << n << ", threads = " << std::thread::hardware_concurrency() << std::endl;
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "laba4_bench_figures.txt";
+    {
+        Figures figures = makeFigures(n, 0.0);
+        std::ofstream out(path);
+        writeFigures(out, figures);
+    }
+
+    size_t syncCount = 0;
+    double syncMs = measureMs([&] {
+        std::ifstream in(path);
+        syncCount = readFigures<double>(in).getSize();
+    });
+    std::cout << "  sync Read loop: " << syncMs << " ms (" << syncCount * 1e3 / syncMs << " figures/s)" << std::endl;
+
+    ThreadPool pool;
+    size_t asyncCount = 0;
+    double asyncMs = measureMs([&] {
+        std::ifstream in(path);
+        for (auto& batch : readFigureBatches<double>(pool, in)) {
+            asyncCount += batch.getSize();
+        }
+    });
+    std::cout << "  readFigureBatches: " << asyncMs << " ms (" << asyncCount * 1e3 / asyncMs
+              << " figures/s, speedup " << syncMs / asyncMs << "x)" << std::endl;
+
+    Figures figures = makeFigures(n, 0.0);
+    double total = 0.0;
+    double totalMs = measureMs([&] { total = syncWait(totalAreaAsync(pool, figures)); });
+    std::cout << "  totalAreaAsync: " << totalMs << " ms" << std::endl;
+    std::filesystem::remove(path);
+}
+
+void benchIntersections(size_t n) {
+    std::cout << "intersections: n = " << n << std::endl;
+    Figures figures = makeFigures(n, 0.0);
+    for (size_t threads = 1; threads <= defaultThreadCount(); threads *= 2) {
+        IntersectionStats stats;
+        double ms = measureMs([&] { findIntersections(figures, threads, &stats); });
+        std::cout << "  threads " << threads << ": " << ms << " ms, candidates " << stats.candidatePairs
+                  << ", intersecting " << stats.intersectingPairs
+                  << ", culling efficiency " << stats.cullingEfficiency()
+                  << ", " << stats.candidatePairs * 1e3 / ms << " candidate pairs/s" << std::endl;
+    }
+}
+
+void benchUnionHull(size_t n) {
+    // Поле растет вместе с n, чтобы плотность перекрытий оставалась как у 10^5 фигур на [-1000, 1000]^2.
+    double extent = 1000.0 * std::sqrt(static_cast<double>(n) / 1e5);
+    std::cout << "union/hull: n = " << n << ", field [-" << extent << ", " << extent << "]^2" << std::endl;
+    Figures figures = makeFigures(n, 0.0, 42, extent);
+    double sum = 0.0;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        sum += figures[i]->area();
+    }
+    for (size_t threads = 1; threads <= defaultThreadCount(); threads *= 2) {
+        double covered = 0.0;
+        double unionMs = measureMs([&] { covered = unionArea(figures, threads); });
+        Contour hull;
+        double hullMs = measureMs([&] { hull = convexHull(figures, threads); });
+        std::cout << "  threads " << threads << ": unionArea " << unionMs << " ms (" << covered
+                  << " of " << sum << " summed), convexHull " << hullMs << " ms ("
+                  << hull.size() << " vertices)" << std::endl;
+    }
+}
+
+void benchParser(size_t n) {
+    std::cout << "parser: n = " << n << std::endl;
+    std::string text;
+    {
+        std::ostringstream out;
+        writeFigures(out, makeFigures(n, 0.0));
+        text = out.str();
+    }
+    double mb = static_cast<double>(text.size()) / (1 << 20);
+
+    // Только числа: operator>> против parseNumber по тому же тексту без тегов.
+    std::string numbers = text;
+    for (char& c : numbers) {
+        if (c == 'S' || c == 'R' || c == 'T') {
+            c = ' ';
+        }
+    }
+    double streamSum = 0.0;
+    double streamMs = measureMs([&] {
+        std::istringstream in(numbers);
+        double value;
+        while (in >> value) {
+            streamSum += value;
+        }
+    });
+    double parserSum = 0.0;
+    double parserMs = measureMs([&] {
+        std::string_view view(numbers);
+        size_t pos = 0;
+        skipSpaces(view, pos);
+        while (pos < view.size()) {
+            parserSum += parseNumber<double>(view, pos);
+            skipSpaces(view, pos);
+        }
+    });
+    std::cout << "  numbers operator>>: " << streamMs << " ms (" << mb * 1e3 / streamMs << " MB/s)" << std::endl;
+    std::cout << "  numbers parseNumber: " << parserMs << " ms (" << mb * 1e3 / parserMs
+              << " MB/s, speedup " << streamMs / parserMs << "x, sums equal " << (streamSum == parserSum) << ")" << std::endl;
+
+    size_t streamCount = 0;
+    double readMs = measureMs([&] {
+        std::istringstream in(text);
+        streamCount = readFigures<double>(in).getSize();
+    });
+    size_t viewCount = 0;
+    double parseMs = measureMs([&] { viewCount = parseFigures<double>(text).getSize(); });
+    std::cout << "  figures readFigures(istream): " << readMs << " ms (" << streamCount * 1e3 / readMs << " figures/s)" << std::endl;
+    std::cout << "  figures parseFigures(string_view): " << parseMs << " ms (" << viewCount * 1e3 / parseMs
+              << " figures/s)" << std::endl;
+}
+
+void benchJournal(size_t n) {
+    std::cout << "journal: n = " << n << std::endl;
+    Figures source = makeFigures(n, 0.0);
+
+    Figures direct;
+    double directMs = measureMs([&] {
+        for (size_t i = 0; i < n; ++i) {
+            direct.pushBack(source[i]);
+        }
+    });
+    Figures journaled;
+    FigureJournal<double> journal(journaled);
+    double journalMs = measureMs([&] {
+        for (size_t i = 0; i < n; ++i) {
+            journal.pushBack(source[i]);
+        }
+    });
+    std::cout << "  pushBack direct: " << directMs << " ms, through journal: " << journalMs << " ms, journal "
+              << journal.memoryUsage() / static_cast<double>(n) << " bytes/record" << std::endl;
+
+    double clearMs = measureMs([&] { journal.clear(); });
+    double undoClearMs = measureMs([&] { journal.undo(); });
+    std::cout << "  clear: " << clearMs * 1e3 << " us, undo clear: " << undoClearMs * 1e3 << " us ("
+              << journaled.getSize() << " figures back)" << std::endl;
+
+    // Память журнала на коллекции из n фигур после k изменений.
+    for (size_t k : {size_t(10), size_t(1000), size_t(100000)}) {
+        Figures base;
+        for (size_t i = 0; i < n; ++i) {
+            base.pushBack(source[i]);
+        }
+        FigureJournal<double> changes(base);
+        size_t before = changes.memoryUsage();
+        for (size_t i = 0; i < k; ++i) {
+            if (i % 2 == 0) {
+                changes.pushBack(source[i]);
+            } else {
+                changes.remove(base.getSize() - 1 - i % 7);
+            }
+        }
+        std::cout << "  " << k << " changes: journal +" << changes.memoryUsage() - before << " bytes" << std::endl;
+    }
+
+    size_t undone = journal.getVersion();
+    double undoAllMs = measureMs([&] { journal.checkout(0); });
+    double redoAllMs = measureMs([&] { journal.checkout(undone); });
+    std::cout << "  undo " << undone << " records: " << undoAllMs << " ms (" << undoAllMs * 1e6 / undone
+              << " ns/op), redo: " << redoAllMs << " ms" << std::endl;
+
+    // Отмена remove сдвигает хвост, поэтому дальний переход по истории удалений дорог
+    // без снимков: с ними повторяется не больше interval записей.
+    size_t base = std::min<size_t>(n, 100000);
+    size_t removes = base / 20;
+    for (size_t interval : {size_t(0), size_t(100), size_t(1000)}) {
+        Figures figures;
+        for (size_t i = 0; i < base; ++i) {
+            figures.pushBack(source[i]);
+        }
+        FigureJournal<double> history(figures, interval);
+        for (size_t i = 0; i < removes; ++i) {
+            history.remove((i * 7919) % (figures.getSize() / 4 + 1));
+        }
+        double checkoutMs = measureMs([&] {
+            history.checkout(removes / 10 + 3);
+            history.checkout(removes / 2 + 17);
+        });
+        std::cout << "  " << removes << " removes from " << base << ", checkpoint interval " << interval << ": far checkout "
+                  << checkoutMs << " ms, journal " << history.memoryUsage() / (1 << 20) << " MiB" << std::endl;
+    }
+}
+
+void benchDurable(size_t n) {
+    std::cout << "durable store: n = " << n << std::endl;
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "laba4_bench_store";
+    Figures source = makeFigures(std::min<size_t>(n, 100000), 0.0);
+
+    struct Policy {
+        const char* name;
+        DurableOptions options;
+        size_t ops;
+    };
+    const Policy policies[] = {
+        {"never", DurableOptions{SyncPolicy::Never, 1, 1 << 20, 0}, n},
+        {"group 4096", DurableOptions{SyncPolicy::Group, 4096, 1 << 20, 0}, n},
+        {"group 64", DurableOptions{SyncPolicy::Group, 64, 1 << 20, 0}, std::min<size_t>(n, 200000)},
+        {"always", DurableOptions{SyncPolicy::Always, 1, 1 << 20, 0}, std::min<size_t>(n, 5000)},
+    };
+    for (const Policy& policy : policies) {
+        std::filesystem::remove_all(directory);
+        DurableFigureStore<double> store(directory, policy.options);
+        double ms = measureMs([&] {
+            for (size_t i = 0; i < policy.ops; ++i) {
+                store.pushBack(source[i % source.getSize()]);
+            }
+            store.commit();
+        });
+        std::cout << "  sync " << policy.name << ": " << policy.ops * 1e3 / ms << " ops/s (" << policy.ops
+                  << " adds)" << std::endl;
+    }
+
+    // Журнал из 10 * n записей: добавления, удаления с конца и clear каждые n записей,
+    // чтобы в памяти одновременно было не больше n фигур.
+    size_t records = 10 * n;
+    std::filesystem::remove_all(directory);
+    {
+        DurableFigureStore<double> store(directory, DurableOptions{SyncPolicy::Never, 1, 1 << 20, 0});
+        for (size_t i = 0; i < records; ++i) {
+            if (i % n == n - 1) {
+                store.clear();
+            } else if (i % 10 == 9) {
+                store.remove(store.getFigures().getSize() - 1);
+            } else {
+                store.pushBack(source[i % source.getSize()]);
+            }
+        }
+    }
+    size_t walBytes = std::filesystem::file_size(directory / "wal.log");
+    {
+        DurableFigureStore<double> store(directory);
+        const RecoveryStats& stats = store.getRecoveryStats();
+        std::cout << "  recovery of " << stats.walRecords << " WAL records (" << walBytes / (1 << 20)
+                  << " MiB): " << stats.milliseconds << " ms, " << stats.walRecords * 1e3 / stats.milliseconds
+                  << " records/s, " << store.getFigures().getSize() << " figures" << std::endl;
+        for (size_t i = store.getFigures().getSize(); i < n; ++i) {
+            store.pushBack(source[i % source.getSize()]);
+        }
+        double compactMs = measureMs([&] { store.compact(); });
+        std::cout << "  compact " << store.getFigures().getSize() << " figures: " << compactMs << " ms" << std::endl;
+    }
+    {
+        DurableFigureStore<double> store(directory);
+        const RecoveryStats& stats = store.getRecoveryStats();
+        std::cout << "  recovery from snapshot of " << stats.snapshotFigures << " figures: " << stats.milliseconds
+                  << " ms" << std::endl;
+    }
+    std::filesystem::remove_all(directory);
+}
+
+void benchPartitioned(size_t n) {
+    NumaTopology topology = NumaTopology::detect();
+    std::cout << "partitioned: n = " << n << ", NUMA nodes = " << topology.nodes.size()
+              << ", cpus = " << topology.getCpuCount() << std::endl;
+    Figures figures = makeFigures(n, 0.0);
+
+    // Один буфер, заполненный главным потоком: все страницы на его узле.
+    std::vector<std::array<double, 8>> flat(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t v = 0; v < 4; ++v) {
+            Point<double> p = figures[i]->getVertex(v);
+            flat[i][2 * v] = p.x;
+            flat[i][2 * v + 1] = p.y;
+        }
+    }
+    auto flatArea = [&flat](size_t threads) {
+        std::vector<NeumaierSum> partial(threads);
+        parallelFor(flat.size(), threads, [&](size_t begin, size_t end, size_t part) {
+            for (size_t i = begin; i < end; ++i) {
+                const std::array<double, 8>& c = flat[i];
+                double sum = 0.0;
+                for (size_t k = 0; k < 4; ++k) {
+                    size_t j = (k + 1) % 4;
+                    sum += c[2 * k] * c[2 * j + 1] - c[2 * j] * c[2 * k + 1];
+                }
+                partial[part].add(std::abs(sum) / 2.0);
+            }
+        });
+        NeumaierSum total;
+        for (const NeumaierSum& sum : partial) {
+            total.add(sum.value());
+        }
+        return total.value();
+    };
+
+    const int repeats = 5;
+    BoundingBox<double> query{-100.0, -100.0, 100.0, 100.0};
+    for (size_t threads = 1; threads <= std::max<size_t>(topology.getCpuCount(), 2); threads *= 2) {
+        double flatResult = 0.0;
+        double flatMs = measureMs([&] {
+            for (int r = 0; r < repeats; ++r) {
+                flatResult = flatArea(threads);
+            }
+        }) / repeats;
+
+        PartitionedFigureArray<double> partitioned(threads, true, topology);
+        double fillMs = measureMs([&] { partitioned.pushBatch(figures); });
+        double shardResult = 0.0;
+        double shardMs = measureMs([&] {
+            for (int r = 0; r < repeats; ++r) {
+                shardResult = partitioned.totalArea();
+            }
+        }) / repeats;
+        size_t found = 0;
+        double rangeMs = measureMs([&] { found = partitioned.rangeQuery(query).size(); });
+        std::cout << "  threads " << threads << ": flat totalArea " << flatMs << " ms, partitioned totalArea "
+                  << shardMs << " ms (fill " << fillMs << " ms), rangeQuery " << rangeMs << " ms (" << found
+                  << " found), |diff| " << std::abs(flatResult - shardResult) << std::endl;
+    }
+}
+
+void benchTiles(size_t n) {
+    std::cout << "tiles: n = " << n << std::endl;
+    Figures figures = makeFigures(n, 0.0);
+    BoundingBox<double> world{-1010.0, -1010.0, 1010.0, 1010.0};
+
+    for (size_t levels : {size_t(6), size_t(8), size_t(10)}) {
+        TilePyramid<double> pyramid(world, levels);
+        double buildMs = measureMs([&] { pyramid.build(figures); });
+        double addMs = measureMs([&] {
+            for (size_t i = 0; i < 10000; ++i) {
+                pyramid.add(*figures[i % n]);
+            }
+        });
+        double removeMs = measureMs([&] {
+            for (size_t i = 0; i < 10000; ++i) {
+                pyramid.remove(*figures[i % n]);
+            }
+        });
+        std::cout << "  levels " << levels << ": build " << buildMs << " ms, add " << addMs * 1e2 << " ns/op, remove "
+                  << removeMs * 1e2 << " ns/op" << std::endl;
+    }
+
+    TilePyramid<double> pyramid(world, 8);
+    pyramid.build(figures);
+    for (double half : {1000.0, 100.0, 10.0}) {
+        BoundingBox<double> viewport{-half, -half, half, half};
+        // Без пирамиды: каждый кадр заново считает Center() и area() всех фигур.
+        size_t scanCount = 0;
+        double scanMs = measureMs([&] {
+            double area = 0.0;
+            for (size_t i = 0; i < figures.getSize(); ++i) {
+                if (viewport.contains(figures[i]->Center())) {
+                    ++scanCount;
+                    area += figures[i]->area();
+                }
+            }
+            (void)area;
+        });
+        size_t level = pyramid.levelFor(viewport);
+        std::vector<TileSummary> visible;
+        double queryMs = measureMs([&] {
+            for (int r = 0; r < 100; ++r) {
+                visible = pyramid.query(viewport, level);
+            }
+        }) / 100;
+        TileSummary exact;
+        double aggregateMs = measureMs([&] {
+            for (int r = 0; r < 100; ++r) {
+                exact = pyramid.aggregate(viewport);
+            }
+        }) / 100;
+        std::cout << "  viewport +-" << half << ": full scan " << scanMs << " ms (" << scanCount
+                  << "), query level " << level << " " << queryMs * 1e3 << " us (" << visible.size()
+                  << " tiles), exact aggregate " << aggregateMs * 1e3 << " us (" << exact.count << ")" << std::endl;
+    }
+}
+
+void benchPolygons(size_t n) {
+    std::cout << "polygon: n = " << n << " (половина четырехугольники, половина многоугольники 3..12 вершин)" << std::endl;
+    Figures figures = makeFigures(n / 2, 0.0);
+    auto pool = std::make_shared<VertexPool<double>>();
+    pool->reserve(n - n / 2, (n - n / 2) * 8);
+    std::mt19937 rng(38);
+    std::uniform_real_distribution<double> coord(-1000.0, 1000.0);
+    std::uniform_real_distribution<double> radius(0.5, 20.0);
+    std::vector<Point<double>> points;
+    double buildMs = measureMs([&] {
+        for (size_t p = n / 2; p < n; ++p) {
+            size_t count = 3 + p % 10;
+            double cx = coord(rng), cy = coord(rng), r = radius(rng);
+            points.resize(count);
+            for (size_t k = 0; k < count; ++k) {
+                double angle = 6.283185307179586 * static_cast<double>(k) / static_cast<double>(count);
+                points[k] = Point<double>(cx + r * std::cos(angle), cy + r * std::sin(angle));
+            }
+            figures.pushBack(std::make_shared<Polygon<double>>(pool, points));
+        }
+    });
+    std::cout << "  build polygons: " << buildMs << " ms, vertices in pool " << pool->getTotalVertexCount()
+              << ", pool " << pool->memoryUsage() / (1 << 20) << " MiB" << std::endl;
+
+    double mixedTotal = 0.0;
+    double mixedMs = measureMs([&] {
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            mixedTotal += static_cast<double>(*figures[i]);
+        }
+    });
+    double polygonTotal = 0.0;
+    double virtualMs = measureMs([&] {
+        for (size_t i = n / 2; i < figures.getSize(); ++i) {
+            polygonTotal += figures[i]->area();
+        }
+    });
+    double perIdTotal = 0.0;
+    double perIdMs = measureMs([&] {
+        for (size_t id = 0; id < pool->getPolygonCount(); ++id) {
+            perIdTotal += pool->area(id);
+        }
+    });
+    // Первый вызов выделяет выходной массив, поэтому меряется повторный.
+    std::vector<double> areas;
+    pool->areas(areas);
+    double batchMs = measureMs([&] { pool->areas(areas); });
+    double batchTotal = 0.0;
+    for (double a : areas) {
+        batchTotal += a;
+    }
+    std::vector<Point<double>> centers;
+    pool->centers(centers);
+    double centersMs = measureMs([&] { pool->centers(centers); });
+    double polygons = static_cast<double>(pool->getPolygonCount());
+    std::cout << "  mixed totalArea (virtual): " << mixedMs << " ms, " << static_cast<double>(figures.getSize()) / mixedMs / 1e3
+              << " M figures/s" << std::endl;
+    std::cout << "  polygon area: virtual " << virtualMs << " ms, pool per id " << perIdMs << " ms, pool batch "
+              << batchMs << " ms (" << polygons / batchMs / 1e3 << " M polygons/s), centers batch " << centersMs << " ms"
+              << std::endl;
+    std::cout << "  check: " << polygonTotal << " " << perIdTotal << " " << batchTotal << " (mixed " << mixedTotal << ")"
+              << std::endl;
+}
+
+// Поэлементное сложение в аккумулятор режима, чтобы сравнить его с пакетным.
+template<typename Sum>
+double streamSum(const std::vector<double>& values) {
+    Sum sum;
+    for (double v : values) {
+        sum.add(v);
+    }
+    return sum.value();
+}
+
+void benchSummation(size_t n) {
+    std::cout << "summation: n = " << n << std::endl;
+    // Площади от 1e-6 до 1e6 со знаками, как при инкрементальном вычитании удаленных фигур.
+    std::mt19937_64 rng(39);
+    std::uniform_real_distribution<double> mantissa(1.0, 2.0);
+    std::uniform_int_distribution<int> exponent(-20, 20);
+    std::vector<double> values(n);
+    for (double& v : values) {
+        v = std::ldexp(mantissa(rng), exponent(rng)) * (rng() % 4 == 0 ? -1.0 : 1.0);
+    }
+    double exact = sum(values, SummationMode::Exact);
+
+    const std::pair<const char*, SummationMode> modes[] = {
+        {"naive", SummationMode::Naive},
+        {"neumaier", SummationMode::Neumaier},
+        {"pairwise", SummationMode::Pairwise},
+        {"exact", SummationMode::Exact},
+    };
+    for (const auto& [name, mode] : modes) {
+        double batch = 0.0;
+        double batchMs = measureMs([&] { batch = sum(values, mode); });
+        double streamed = 0.0;
+        double streamMs = measureMs([&] {
+            switch (mode) {
+                case SummationMode::Naive:
+                    streamed = streamSum<NaiveSum>(values);
+                    break;
+                case SummationMode::Neumaier:
+                    streamed = streamSum<NeumaierSum>(values);
+                    break;
+                case SummationMode::Pairwise:
+                    streamed = streamSum<PairwiseSum>(values);
+                    break;
+                case SummationMode::Exact:
+                    streamed = streamSum<ExactSum>(values);
+                    break;
+            }
+        });
+        std::cout << "  " << name << ": batch " << batchMs * 1e6 / static_cast<double>(n) << " ns/value, stream "
+                  << streamMs * 1e6 / static_cast<double>(n) << " ns/value, error batch "
+                  << std::abs(batch - exact) / std::abs(exact) << ", stream " << std::abs(streamed - exact) / std::abs(exact)
+                  << std::endl;
+    }
+
+    Figures figures = makeFigures(n, 0.0);
+    for (const auto& [name, mode] : modes) {
+        double total = 0.0;
+        double ms = measureMs([&] { total = sumAreas(figures, mode); });
+        std::cout << "  sumAreas " << name << ": " << ms << " ms (" << total << ")" << std::endl;
+    }
+}
+
+void benchReplay(size_t n) {
+    // Запрос окна перебирает всю коллекцию, поэтому трасса ограничена.
+    size_t ops = std::min<size_t>(n, 100000);
+    TraceMix mix;
+    mix.initial = 10000;
+    std::cout << "replay: " << ops << " ops after " << mix.initial << " initial adds" << std::endl;
+    std::vector<TraceEvent<double>> trace;
+    double generateMs = measureMs([&] { trace = makeTrace<double>(ops, 40, mix); });
+    std::ostringstream text;
+    double writeMs = measureMs([&] { writeTrace(text, trace); });
+    std::string buffer = text.str();
+    std::vector<TraceEvent<double>> parsed;
+    double parseMs = measureMs([&] { parsed = parseTrace<double>(buffer); });
+    std::cout << "  generate " << generateMs << " ms, write " << writeMs << " ms, parse " << parseMs << " ms ("
+              << buffer.size() / (1 << 20) << " MiB)" << std::endl;
+
+    AggregateReplayTarget<double> target;
+    ReplayReport report = replayTrace(parsed, target);
+    std::cout << "  replay " << report.seconds * 1e3 << " ms, " << static_cast<double>(parsed.size()) / report.seconds
+              << " ops/s" << std::endl;
+    for (size_t op = 0; op < TraceOpCount; ++op) {
+        printLatency(std::cout, traceOpName(static_cast<TraceOp>(op)), report.byOp[op]);
+    }
+    printLatency(std::cout, "all", report.all);
+}
+
+void benchServer(size_t n) {
+    // Каждой конфигурации — свежий сервер, чтобы хранилище не росло от прогона к прогону.
+    size_t commands = std::min<size_t>(n, 200000);
+    std::string socketPath = (std::filesystem::temp_directory_path() / "laba4_bench.sock").string();
+    std::cout << "server: ~" << commands << " commands per configuration, 2 worker threads" << std::endl;
+    for (const char* transport : {"unix", "tcp"}) {
+        for (size_t connections : {size_t(1), size_t(4)}) {
+            for (size_t batch : {size_t(1), size_t(16), size_t(256)}) {
+                SharedFigureStore<double> store;
+                ServerAddress address = ServerAddress::parse(std::string(transport) == "unix" ? "unix:" + socketPath : "tcp:0");
+                FigureServer<double> server(address, store, 2);
+                size_t requests = std::max<size_t>(1, commands / (batch * connections));
+                LoadReport report = runServerLoad(server.getAddress(), connections, requests, batch);
+                std::cout << "  " << transport << " connections " << connections << " batch " << batch << ": "
+                          << static_cast<double>(report.requests) / report.seconds << " req/s, "
+                          << static_cast<double>(report.commands) / report.seconds << " cmd/s, p50 "
+                          << report.latency.percentile(0.5) / 1e3 << " us, p99 " << report.latency.percentile(0.99) / 1e3
+                          << " us, p999 " << report.latency.percentile(0.999) / 1e3 << " us" << std::endl;
+            }
+        }
+    }
+}
+
+// Задержка каждого добавления в конец и время прохода по индексу для одного контейнера.
+template<typename Container, typename V>
+void reportAppends(const char* name, const std::vector<V>& values) {
+    Container container;
+    LatencyHistogram latency;
+    double appendMs = measureMs([&] {
+        for (const V& v : values) {
+            auto start = std::chrono::steady_clock::now();
+            container.pushBack(v);
+            auto end = std::chrono::steady_clock::now();
+            latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        }
+    });
+    double check = 0.0;
+    double iterateMs = measureMs([&] {
+        for (size_t i = 0; i < container.getSize(); ++i) {
+            if constexpr (std::is_arithmetic_v<V>) {
+                check += container[i];
+            } else {
+                check += static_cast<double>(*container[i]);
+            }
+        }
+    });
+    std::cout << "  " << name << ": append " << appendMs << " ms, iterate " << iterateMs << " ms ("
+              << static_cast<double>(values.size()) / iterateMs / 1e3 << " M/s, " << check << "), "
+              << container.memoryUsage() / (1 << 20) << " MiB" << std::endl;
+    printLatency(std::cout, "append", latency);
+}
+
+void benchChunked(size_t n) {
+    // Числа — чтобы перенос при удвоении Array был заметен, фигуры — как в коллекции.
+    size_t numbers = 16 * n;
+    std::cout << "chunked: " << numbers << " doubles, " << n << " figures" << std::endl;
+    std::vector<double> values(numbers);
+    for (size_t i = 0; i < numbers; ++i) {
+        values[i] = static_cast<double>(i % 1000);
+    }
+    reportAppends<Array<double>>("Array<double>", values);
+    reportAppends<ChunkedArray<double>>("ChunkedArray<double>", values);
+    values = {};
+
+    Figures source = makeFigures(n, 0.0);
+    std::vector<std::shared_ptr<Figure<double>>> figures(n);
+    for (size_t i = 0; i < n; ++i) {
+        figures[i] = source[i];
+    }
+    reportAppends<Figures>("Array<figure>", figures);
+    reportAppends<ChunkedArray<std::shared_ptr<Figure<double>>>>("ChunkedArray<figure>", figures);
+}
+
+void benchAccess(size_t n) {
+    // Не меньше 10^7 чисел, чтобы проход не помещался в кэш и было видно цену проверок.
+    size_t count = std::max<size_t>(n, 10000000);
+    std::cout << "access: " << count << " doubles" << std::endl;
+    Array<double> values(count);
+    for (size_t i = 0; i < count; ++i) {
+        values.pushBack(static_cast<double>(i % 1000) * 0.5);
+    }
+    auto report = [count](const char* name, double ms, double check) {
+        std::cout << "  " << name << ": " << ms << " ms, " << static_cast<double>(count) / ms / 1e3 << " M/s ("
+                  << check << ")" << std::endl;
+    };
+    // Проверяемый operator[] и atUnchecked складывают в одном порядке; range-for тоже,
+    // а transformReduce идет четырьмя полосами и векторизуется.
+    double checked = 0.0;
+    double checkedMs = measureMs([&] {
+        for (size_t i = 0; i < values.getSize(); ++i) {
+            checked += values[i];
+        }
+    });
+    report("operator[] (checked)", checkedMs, checked);
+    double unchecked = 0.0;
+    double uncheckedMs = measureMs([&] {
+        for (size_t i = 0; i < values.getSize(); ++i) {
+            unchecked += values.atUnchecked(i);
+        }
+    });
+    report("atUnchecked", uncheckedMs, unchecked);
+    double ranged = 0.0;
+    double rangedMs = measureMs([&] {
+        for (double v : values) {
+            ranged += v;
+        }
+    });
+    report("range-for", rangedMs, ranged);
+    double reduced = 0.0;
+    double reducedMs = measureMs([&] {
+        reduced = values.transformReduce(0.0, std::plus<>(), [](double v) { return v; });
+    });
+    report("transformReduce", reducedMs, reduced);
+    double scaledChecked = 0.0;
+    double scaledCheckedMs = measureMs([&] {
+        for (size_t i = 0; i < values.getSize(); ++i) {
+            scaledChecked += values[i] * values[i];
+        }
+    });
+    report("checked scale+sum", scaledCheckedMs, scaledChecked);
+    double scaled = 0.0;
+    double scaledMs = measureMs([&] {
+        scaled = values.transformReduce(0.0, std::plus<>(), [](double v) { return v * v; });
+    });
+    report("transformReduce scale+sum", scaledMs, scaled);
+}
+
+void benchBatch(size_t n) {
+    // Прямоугольники со сторонами 0.1..10, каждая сотая строка вырождена.
+    std::cout << "batch: " << n << " rectangles, 1% degenerate" << std::endl;
+    std::mt19937_64 rng(44);
+    std::uniform_real_distribution<double> coord(-1000.0, 1000.0);
+    std::uniform_real_distribution<double> side(0.1, 10.0);
+    std::vector<double> xs(4 * n), ys(4 * n);
+    for (size_t r = 0; r < n; ++r) {
+        double x = coord(rng), y = coord(rng), w = side(rng), h = r % 100 == 99 ? 0.0 : side(rng);
+        double px[4] = {x, x + w, x + w, x}, py[4] = {y, y, y + h, y + h};
+        std::copy(px, px + 4, xs.begin() + 4 * r);
+        std::copy(py, py + 4, ys.begin() + 4 * r);
+    }
+
+    Figures single;
+    size_t rejected = 0;
+    double singleMs = measureMs([&] {
+        for (size_t r = 0; r < n; ++r) {
+            const double* x = xs.data() + 4 * r;
+            const double* y = ys.data() + 4 * r;
+            try {
+                single.pushBack(std::make_shared<Rectangle<double>>(Point<double>(x[0], y[0]), Point<double>(x[1], y[1]),
+                                                                    Point<double>(x[2], y[2]), Point<double>(x[3], y[3])));
+            } catch (const std::invalid_argument&) {
+                ++rejected;
+            }
+        }
+    });
+    BatchMask mask;
+    double validateMs = measureMs([&] { mask = detail::validateBatch<double>(xs, ys); });
+    Figures batch;
+    BatchMask invalid;
+    double batchMs = measureMs([&] { invalid = Rectangle<double>::makeBatch(xs, ys, batch); });
+    double rows = static_cast<double>(n);
+    std::cout << "  constructors: " << singleMs << " ms, " << rows / singleMs / 1e3 << " M rows/s (" << rejected
+              << " rejected)" << std::endl;
+    std::cout << "  validate only: " << validateMs << " ms, " << rows / validateMs / 1e3 << " M rows/s ("
+              << mask.count() << " rejected)" << std::endl;
+    std::cout << "  makeBatch: " << batchMs << " ms, " << rows / batchMs / 1e3 << " M rows/s (" << invalid.count()
+              << " rejected, " << batch.getSize() << " built)" << std::endl;
+}
+
+void benchQuery(size_t n) {
+    std::cout << "query: n = " << n << ", trapezoids with area > 20, translated, sum of centers" << std::endl;
+    Figures figures = makeFigures(n, 0.0);
+    auto report = [](const char* name, double ms, const Point<double>& sum) {
+        std::cout << "  " << name << ": " << ms << " ms (" << sum.x << ", " << sum.y << ")" << std::endl;
+    };
+
+    Point<double> loopSum;
+    double loopMs = measureMs([&] {
+        double x = 0.0, y = 0.0;
+        for (const std::shared_ptr<Figure<double>>& figure : figures) {
+            if (dynamic_cast<const Trapezoid<double>*>(figure.get()) && figure->area() > 20.0) {
+                Point<double> c = figure->Center();
+                x += c.x + 5.0;
+                y += c.y - 5.0;
+            }
+        }
+        loopSum = Point<double>(x, y);
+    });
+    report("hand-written loop", loopMs, loopSum);
+
+    Point<double> querySum;
+    double queryMs = measureMs([&] {
+        querySum = query(figures)
+                       .ofType<Trapezoid<double>>()
+                       .filter([](const Trapezoid<double>& t) { return t.area() > 20.0; })
+                       .translate(5.0, -5.0)
+                       .sum([](const TransformedFigure<double>& t) { return t.Center(); });
+    });
+    report("fused query", queryMs, querySum);
+
+    // Как раньше: каждая стадия собирает промежуточный массив копий shared_ptr.
+    Point<double> eagerSum;
+    double eagerMs = measureMs([&] {
+        Figures trapezoids;
+        for (const std::shared_ptr<Figure<double>>& figure : figures) {
+            if (dynamic_cast<const Trapezoid<double>*>(figure.get())) {
+                trapezoids.pushBack(figure);
+            }
+        }
+        Figures large;
+        for (const std::shared_ptr<Figure<double>>& figure : trapezoids) {
+            if (figure->area() > 20.0) {
+                large.pushBack(figure);
+            }
+        }
+        std::vector<Point<double>> centers;
+        for (const std::shared_ptr<Figure<double>>& figure : large) {
+            Point<double> c = figure->Center();
+            centers.emplace_back(c.x + 5.0, c.y - 5.0);
+        }
+        double x = 0.0, y = 0.0;
+        for (const Point<double>& c : centers) {
+            x += c.x;
+            y += c.y;
+        }
+        eagerSum = Point<double>(x, y);
+    });
+    report("intermediate arrays", eagerMs, eagerSum);
+
+    double loopArea = 0.0;
+    double loopAreaMs = measureMs([&] {
+        for (const std::shared_ptr<Figure<double>>& figure : figures) {
+            double a = figure->area();
+            if (a > 20.0) {
+                loopArea += a;
+            }
+        }
+    });
+    double queryArea = 0.0;
+    double queryAreaMs = measureMs([&] {
+        queryArea = query(figures)
+                        .map([](const Figure<double>& f) { return f.area(); })
+                        .filter([](double a) { return a > 20.0; })
+                        .sum();
+    });
+    std::cout << "  area > 20: loop " << loopAreaMs << " ms (" << loopArea << "), query " << queryAreaMs << " ms ("
+              << queryArea << ")" << std::endl;
+}
+
+void benchSlotMap(size_t n) {
+    // Каждый шаг нагрузки удаляет случайную живую фигуру и добавляет новую.
+    std::cout << "slotmap: " << n << " live figures, churn remove+insert" << std::endl;
+    Figures source = makeFigures(n, 0.0);
+    std::mt19937_64 rng(46);
+
+    SlotMap<std::shared_ptr<Figure<double>>> map;
+    map.reserve(n);
+    std::vector<SlotHandle> handles;
+    handles.reserve(n);
+    double fillMs = measureMs([&] {
+        for (size_t i = 0; i < n; ++i) {
+            handles.push_back(map.insert(source[i]));
+        }
+    });
+    size_t churn = n;
+    double churnMs = measureMs([&] {
+        for (size_t step = 0; step < churn; ++step) {
+            size_t victim = rng() % handles.size();
+            map.remove(handles[victim]);
+            handles[victim] = map.insert(source[step]);
+        }
+    });
+    double lookupTotal = 0.0;
+    double lookupMs = measureMs([&] {
+        for (size_t step = 0; step < n; ++step) {
+            lookupTotal += map[handles[rng() % handles.size()]]->area();
+        }
+    });
+    double denseTotal = 0.0;
+    double denseMs = measureMs([&] {
+        for (const std::shared_ptr<Figure<double>>& figure : map) {
+            denseTotal += figure->area();
+        }
+    });
+    std::cout << "  SlotMap: fill " << fillMs << " ms, churn " << churnMs * 1e6 / static_cast<double>(churn)
+              << " ns/step, random lookup " << lookupMs * 1e6 / static_cast<double>(n) << " ns, dense pass " << denseMs
+              << " ms (" << denseTotal << "), " << map.memoryUsage() / (1 << 20) << " MiB" << std::endl;
+
+    // Array сдвигает хвост при удалении, поэтому шагов меньше.
+    Figures array;
+    for (size_t i = 0; i < n; ++i) {
+        array.pushBack(source[i]);
+    }
+    size_t arrayChurn = std::min<size_t>(n, 20000);
+    double arrayChurnMs = measureMs([&] {
+        for (size_t step = 0; step < arrayChurn; ++step) {
+            array.remove(rng() % array.getSize());
+            array.pushBack(source[step]);
+        }
+    });
+    double arrayTotal = 0.0;
+    double arrayMs = measureMs([&] {
+        for (const std::shared_ptr<Figure<double>>& figure : array) {
+            arrayTotal += figure->area();
+        }
+    });
+    std::cout << "  Array: churn " << arrayChurnMs * 1e6 / static_cast<double>(arrayChurn) << " ns/step (" << arrayChurn
+              << " steps), pass " << arrayMs << " ms (" << arrayTotal << ")" << std::endl;
+}
+
+// Результат читающего процесса, передаваемый родителю через канал.
+struct ShmReaderResult {
+    double attachMs;
+    double lookupsPerSecond;
+    double scanMs;
+    uint64_t retries;
+    double checksum;
+};
+
+ShmReaderResult runShmReader(const std::string& segment, size_t lookups, unsigned seed, bool scan) {
+    ShmReaderResult result{};
+    std::unique_ptr<ShmFigureView> view;
+    result.attachMs = measureMs([&] { view = std::make_unique<ShmFigureView>(segment); });
+    std::mt19937_64 rng(seed);
+    size_t size = view->getSize();
+    double lookupMs = measureMs([&] {
+        for (size_t i = 0; i < lookups; ++i) {
+            ShmFigureRecord record = view->record(rng() % size);
+            result.checksum += record.area + record.centerX + record.maxY;
+        }
+    });
+    result.lookupsPerSecond = static_cast<double>(lookups) / lookupMs * 1e3;
+    if (scan) {
+        result.scanMs = measureMs([&] { result.checksum += view->totalArea(); });
+    }
+    result.retries = view->getRetryCount();
+    return result;
+}
+
+void benchShm(size_t n) {
+    std::cout << "shm: " << n << " figures in a shared segment" << std::endl;
+    Figures figures = makeFigures(n, 0.0);
+    const std::string segment = "/laba4_bench_" + std::to_string(getpid());
+    ShmFigureStore store(segment, n);
+    double publishMs = measureMs([&] {
+        store.batch([&](ShmFigureStore& s) {
+            for (const std::shared_ptr<Figure<double>>& figure : figures) {
+                s.pushBack(*figure);
+            }
+        });
+    });
+    // Для сравнения: так каждый процесс сейчас получает коллекцию — разбором текста.
+    std::ostringstream text;
+    writeFigures(text, figures);
+    std::string buffer = text.str();
+    double parseMs = measureMs([&] { parseFigures<double>(buffer); });
+    std::cout << "  publish " << publishMs << " ms, reload by parsing text " << parseMs << " ms per process" << std::endl;
+
+    size_t lookups = 1000000;
+    for (bool writing : {false, true}) {
+        for (int readers : {1, 2, 4}) {
+            std::vector<pid_t> pids;
+            std::vector<int> pipes;
+            for (int r = 0; r < readers; ++r) {
+                int fds[2];
+                if (pipe(fds) != 0) {
+                    throw std::runtime_error("pipe");
+                }
+                pid_t pid = fork();
+                if (pid == 0) {
+                    close(fds[0]);
+                    ShmReaderResult result = runShmReader(segment, lookups, static_cast<unsigned>(r + 1), !writing);
+                    ssize_t written = write(fds[1], &result, sizeof(result));
+                    _exit(written == static_cast<ssize_t>(sizeof(result)) ? 0 : 1);
+                }
+                close(fds[1]);
+                pids.push_back(pid);
+                pipes.push_back(fds[0]);
+            }
+            // Пишущий режим: писатель без пауз заменяет случайные фигуры, пока читатели работают.
+            // Полный проход дольше промежутка между записями и при таком писателе не завершится
+            // (seqlock не защищает длинные чтения от голодания), поэтому меряются только выборки.
+            size_t updates = 0;
+            std::mt19937_64 rng(47);
+            while (writing && waitpid(-1, nullptr, WNOHANG) == 0) {
+                size_t index = rng() % n;
+                store.set(index, *figures[index]);
+                ++updates;
+            }
+            double lookupRate = 0.0, scanMs = 0.0, attachMs = 0.0;
+            uint64_t retries = 0;
+            for (int r = 0; r < readers; ++r) {
+                ShmReaderResult result{};
+                if (read(pipes[r], &result, sizeof(result)) != static_cast<ssize_t>(sizeof(result))) {
+                    result = ShmReaderResult{};
+                }
+                close(pipes[r]);
+                waitpid(pids[r], nullptr, 0);
+                lookupRate += result.lookupsPerSecond;
+                scanMs = std::max(scanMs, result.scanMs);
+                attachMs = std::max(attachMs, result.attachMs);
+                retries += result.retries;
+            }
+            std::cout << "  " << (writing ? "writer busy" : "writer idle") << ", readers " << readers << ": attach "
+                      << attachMs << " ms, lookups " << lookupRate / 1e6 << " M/s total, full scan "
+                      << (writing ? std::string("-") : std::to_string(scanMs) + " ms") << ", retries " << retries << ", writer updates " << updates << std::endl;
+        }
+    }
+}
+
+void benchTrace(size_t n) {
+    // Операция как в меню: построить квадрат с проверкой и добавить в массив, по спану на шаг и на операцию.
+    std::cout << "trace: " << n << " add-figure operations, 3 spans each" << std::endl;
+    Figures source = makeFigures(n, 0.0);
+    auto run = [&](bool spans) {
+        Figures figures;
+        figures.reserve(n);
+        return measureMs([&] {
+            for (size_t i = 0; i < n; ++i) {
+                const Figure<double>& f = *source[i];
+                if (spans) {
+                    TraceSpan op("addSquare");
+                    std::shared_ptr<Figure<double>> square;
+                    {
+                        TraceSpan construct("construct");
+                        square = std::make_shared<Square<double>>(f.getVertex(0), f.getVertex(1), f.getVertex(2),
+                                                                  f.getVertex(3));
+                    }
+                    TraceSpan push("pushBack");
+                    figures.pushBack(std::move(square));
+                } else {
+                    figures.pushBack(std::make_shared<Square<double>>(f.getVertex(0), f.getVertex(1), f.getVertex(2),
+                                                                      f.getVertex(3)));
+                }
+            }
+        });
+    };
+    // Лучший из трех прогонов после прогревочного: разница между вариантами меньше шума аллокатора.
+    auto best = [&](bool spans) {
+        double ms = run(spans);
+        for (int round = 0; round < 2; ++round) {
+            ms = std::min(ms, run(spans));
+        }
+        return ms;
+    };
+    auto perOp = [n](double ms) { return ms * 1e6 / static_cast<double>(n); };
+
+    Tracer& tracer = Tracer::global();
+    run(false);
+    double plainMs = best(false);
+    double disabledMs = best(true);
+    tracer.enable();
+    double enabledMs = best(true);
+    tracer.disable();
+    std::ostringstream json;
+    double writeMs = measureMs([&] { tracer.writeChromeTrace(json); });
+    std::cout << "  per op: no spans " << perOp(plainMs) << " ns, tracing off " << perOp(disabledMs)
+              << " ns, tracing on " << perOp(enabledMs) << " ns (" << (perOp(enabledMs) - perOp(plainMs)) / 3.0
+              << " ns/span)" << std::endl;
+    std::cout << "  kept " << tracer.getEventCount() << " spans, dropped " << tracer.getDroppedCount() << ", json "
+              << json.str().size() / 1024 << " KiB in " << writeMs << " ms" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string suite = argc > 1 ? argv[1] : "all";
+    size_t n = argc > 2 ? std::stoull(argv[2]) : 1000000;
+
+    struct Suite {
+        const char* name;
+        std::function<void(size_t)> run;
+    };
+    const std::vector<Suite> suites = {
+        {"dedup", benchDedup},
+        {"memory", benchMemory},
+        {"aggregate", benchAggregate},
+        {"async", benchAsyncLoad},
+        {"intersections", benchIntersections},
+        {"union", benchUnionHull},
+        {"parser", benchParser},
+        {"journal", benchJournal},
+        {"durable", benchDurable},
+        {"partitioned", benchPartitioned},
+        {"tiles", benchTiles},
+        {"polygon", benchPolygons},
+        {"summation", benchSummation},
+        {"replay", benchReplay},
+        {"server", benchServer},
+        {"chunked", benchChunked},
+        {"access", benchAccess},
+        {"batch", benchBatch},
+        {"query", benchQuery},
+        {"slotmap", benchSlotMap},
+        {"shm", benchShm},
+        {"trace", benchTrace},
+    };
+
+    bool found = false;
+    for (const Suite& s : suites) {
+        if (suite == "all" || suite == s.name) {
+            s.run(n);
+            found = true;
+        }
+    }
+    if (!found) {
+        std::cerr << "usage: laba4_bench [all";
+        for (const Suite& s : suites) {
+            std::cerr << "|" << s.name;
+        }
+        std::cerr << "] [n]" << std::endl;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
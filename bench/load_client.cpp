@@ -0,0 +1,31 @@
+#include <iostream>
+#include <string>
+
+#include "../figure_server.h"
+
+// Нагрузочный клиент сервера фигур (laba4_exe --serve):
+//   laba4_load_client <адрес> [соединений=4] [пакетов на соединение=10000] [команд в пакете=16] [зерно=1]
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "использование: laba4_load_client <unix:путь|tcp:порт> [соединений] [пакетов] [команд в пакете] [зерно]"
+                  << std::endl;
+        return 2;
+    }
+    try {
+        ServerAddress address = ServerAddress::parse(argv[1]);
+        size_t connections = argc > 2 ? std::stoul(argv[2]) : 4;
+        size_t requests = argc > 3 ? std::stoul(argv[3]) : 10000;
+        size_t batch = argc > 4 ? std::stoul(argv[4]) : 16;
+        uint64_t seed = argc > 5 ? std::stoull(argv[5]) : 1;
+        LoadReport report = runServerLoad(address, connections, requests, batch, seed);
+        std::cout << "пакетов: " << report.requests << ", команд: " << report.commands << ", ошибок: " << report.errors
+                  << " за " << report.seconds << " с\n"
+                  << "  " << static_cast<double>(report.requests) / report.seconds << " пакетов/с, "
+                  << static_cast<double>(report.commands) / report.seconds << " команд/с\n";
+        printLatency(std::cout, "batch", report.latency);
+    } catch (const std::exception& err) {
+        std::cerr << "ошибка: " << err.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../workload.h"
+
+// Генерация и воспроизведение трасс нагрузки.
+//   laba4_replay generate <файл> [операций] [зерно] [начальных фигур]
+//   laba4_replay run <файл>
+int usage() {
+    std::cerr << "использование:\n"
+              << "  laba4_replay generate <файл> [операций=100000] [зерно=1] [начальных фигур=10000]\n"
+              << "  laba4_replay run <файл>" << std::endl;
+    return 2;
+}
+
+int generate(int argc, char** argv) {
+    size_t ops = argc > 3 ? std::stoull(argv[3]) : 100000;
+    uint64_t seed = argc > 4 ? std::stoull(argv[4]) : 1;
+    TraceMix mix;
+    mix.initial = argc > 5 ? std::stoull(argv[5]) : 10000;
+    std::vector<TraceEvent<double>> trace = makeTrace<double>(ops, seed, mix);
+    std::ofstream out(argv[2]);
+    if (!out) {
+        std::cerr << "не удалось открыть " << argv[2] << std::endl;
+        return 1;
+    }
+    writeTrace(out, trace);
+    std::cout << "записано операций: " << trace.size() << std::endl;
+    return 0;
+}
+
+int run(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "не удалось открыть " << path << std::endl;
+        return 1;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+    std::vector<TraceEvent<double>> trace;
+    try {
+        trace = parseTrace<double>(text);
+    } catch (const ParseError& err) {
+        std::cerr << "ошибка разбора трассы: " << err.what() << std::endl;
+        return 1;
+    }
+
+    AggregateReplayTarget<double> target;
+    ReplayReport report = replayTrace(trace, target);
+    std::cout << "операций: " << trace.size() << " за " << report.seconds << " с ("
+              << static_cast<double>(trace.size()) / report.seconds << " оп/с), фигур в конце: "
+              << target.getFigures().getSize() << ", контрольная сумма " << report.checksum << "\n";
+    for (size_t op = 0; op < TraceOpCount; ++op) {
+        if (report.byOp[op].getCount() > 0) {
+            printLatency(std::cout, traceOpName(static_cast<TraceOp>(op)), report.byOp[op]);
+        }
+    }
+    printLatency(std::cout, "all", report.all);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        return usage();
+    }
+    std::string command = argv[1];
+    if (command == "generate") {
+        return generate(argc, argv);
+    }
+    if (command == "run") {
+        return run(argv[2]);
+    }
+    return usage();
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef BOUNDING_BOX_H
+#define BOUNDING_BOX_H
+
+#include "figure.h"
+#include <algorithm>
+
+template<Scalar T>
+struct BoundingBox {
+    T minX;
+    T minY;
+    T maxX;
+    T maxY;
+
+    bool intersects(const BoundingBox& other) const {
+        return minX <= other.maxX && other.minX <= maxX &&
+               minY <= other.maxY && other.minY <= maxY;
+    }
+
+    bool contains(const Point<T>& p) const {
+        return minX <= p.x && p.x <= maxX && minY <= p.y && p.y <= maxY;
+    }
+
+    void expand(const BoundingBox& other) {
+        minX = std::min(minX, other.minX);
+        minY = std::min(minY, other.minY);
+        maxX = std::max(maxX, other.maxX);
+        maxY = std::max(maxY, other.maxY);
+    }
+};
+
+template<Scalar T>
+BoundingBox<T> boundingBox(const Figure<T>& figure) {
+    Point<T> p = figure.getVertex(0);
+    BoundingBox<T> box{p.x, p.y, p.x, p.y};
+    for (size_t i = 1; i < figure.getVertexCount(); ++i) {
+        p = figure.getVertex(i);
+        box.minX = std::min(box.minX, p.x);
+        box.minY = std::min(box.minY, p.y);
+        box.maxX = std::max(box.maxX, p.x);
+        box.maxY = std::max(box.maxY, p.y);
+    }
+    return box;
+}
+
+#endif
\ No newline at end of file
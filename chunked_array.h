@@ -0,0 +1,184 @@
+#ifndef CHUNKED_ARRAY_H
+#define CHUNKED_ARRAY_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// Массив из блоков фиксированного размера BlockSize с тем же API, что у Array.
+// При росте выделяется только новый блок, а элементы не переносятся, поэтому ссылки
+// на элементы остаются действительными до их удаления или вставки перед ними.
+//
+// Индекс блоков двухуровневый: каталог k хранит указатели на 2^k блоков и выделяется
+// без инициализации, когда заполнены предыдущие, а таблица каталогов фиксирована.
+// Поэтому указатели никогда не копируются, и добавление в конец стоит O(1) в худшем
+// случае: не больше одного выделения каталога и одного блока из BlockSize элементов
+// (время самого аллокатора и первых обращений к новым страницам сюда не входит).
+template<typename T, size_t BlockSize = 1024>
+class ChunkedArray {
+    static_assert(BlockSize > 0 && (BlockSize & (BlockSize - 1)) == 0, "BlockSize должен быть степенью двойки");
+
+private:
+    static constexpr size_t MaxDirectories = 64;
+
+    std::array<std::unique_ptr<T*[]>, MaxDirectories> directories;
+    size_t blockCount;
+    size_t size;
+
+    // Блок b лежит в каталоге k = floor(log2(b + 1)) под номером b + 1 - 2^k.
+    T*& block(size_t b) const {
+        size_t k = static_cast<size_t>(std::bit_width(b + 1)) - 1;
+        return directories[k][b + 1 - (size_t(1) << k)];
+    }
+
+    T& at(size_t index) { return block(index / BlockSize)[index % BlockSize]; }
+    const T& at(size_t index) const { return block(index / BlockSize)[index % BlockSize]; }
+
+    void addBlock() {
+        size_t k = static_cast<size_t>(std::bit_width(blockCount + 1)) - 1;
+        if (!directories[k]) {
+            directories[k] = std::make_unique_for_overwrite<T*[]>(size_t(1) << k);
+        }
+        std::unique_ptr<T[]> fresh = std::make_unique<T[]>(BlockSize);
+        block(blockCount) = fresh.release();
+        ++blockCount;
+    }
+
+    void grow() {
+        if (size == blockCount * BlockSize) {
+            addBlock();
+        }
+    }
+
+    void release() {
+        for (size_t b = 0; b < blockCount; ++b) {
+            delete[] block(b);
+        }
+        for (std::unique_ptr<T*[]>& directory : directories) {
+            directory.reset();
+        }
+        blockCount = 0;
+        size = 0;
+    }
+
+public:
+    ChunkedArray() : blockCount(0), size(0) {}
+
+    explicit ChunkedArray(size_t initialCapacity) : blockCount(0), size(0) {
+        reserve(initialCapacity);
+    }
+
+    ChunkedArray(const ChunkedArray&) = delete;
+    ChunkedArray& operator=(const ChunkedArray&) = delete;
+
+    ChunkedArray(ChunkedArray&& other) noexcept
+        : directories(std::move(other.directories)),
+          blockCount(other.blockCount),
+          size(other.size) {
+        other.blockCount = 0;
+        other.size = 0;
+    }
+
+    ChunkedArray& operator=(ChunkedArray&& other) noexcept {
+        if (this != &other) {
+            release();
+            directories = std::move(other.directories);
+            blockCount = other.blockCount;
+            size = other.size;
+            other.blockCount = 0;
+            other.size = 0;
+        }
+        return *this;
+    }
+
+    // Заранее выделяет блоки под capacity элементов.
+    void reserve(size_t capacity) {
+        size_t count = (capacity + BlockSize - 1) / BlockSize;
+        while (blockCount < count) {
+            addBlock();
+        }
+    }
+
+    void pushBack(T&& value) {
+        grow();
+        at(size) = std::move(value);
+        ++size;
+    }
+
+    void pushBack(const T& value) {
+        grow();
+        at(size) = value;
+        ++size;
+    }
+
+    // Вставка со сдвигом хвоста вправо, index == size добавляет в конец.
+    void insert(size_t index, T value) {
+        if (index > size) {
+            throw std::out_of_range("Index out of range");
+        }
+        grow();
+        for (size_t i = size; i > index; --i) {
+            at(i) = std::move(at(i - 1));
+        }
+        at(index) = std::move(value);
+        ++size;
+    }
+
+    void remove(size_t index) {
+        if (index >= size) {
+            throw std::out_of_range("Index out of range");
+        }
+
+        for (size_t i = index; i < size - 1; ++i) {
+            at(i) = std::move(at(i + 1));
+        }
+        --size;
+    }
+
+    void clear() {
+        size = 0;
+    }
+
+    T& operator[](size_t index) {
+        if (index >= size) {
+            throw std::out_of_range("Index out of range");
+        }
+        return at(index);
+    }
+
+    const T& operator[](size_t index) const {
+        if (index >= size) {
+            throw std::out_of_range("Index out of range");
+        }
+        return at(index);
+    }
+
+    // Обход по блокам: body получает указатель на начало непрерывного куска и его длину.
+    template<typename F>
+    void forEachBlock(F&& body) const {
+        for (size_t begin = 0, b = 0; begin < size; begin += BlockSize, ++b) {
+            body(static_cast<const T*>(block(b)), std::min(BlockSize, size - begin));
+        }
+    }
+
+    size_t getSize() const { return size; }
+    size_t getCapacity() const { return blockCount * BlockSize; }
+    size_t getBlockCount() const { return blockCount; }
+    bool isEmpty() const { return size == 0; }
+
+    // Байты, занятые блоками и их индексом (без памяти, на которую ссылаются элементы).
+    size_t memoryUsage() const {
+        size_t index = 0;
+        for (size_t k = 0; k < MaxDirectories && directories[k]; ++k) {
+            index += (size_t(1) << k) * sizeof(T*);
+        }
+        return sizeof(*this) + index + getCapacity() * sizeof(T);
+    }
+
+    ~ChunkedArray() { release(); }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,228 @@
+#ifndef COMPACT_STORE_H
+#define COMPACT_STORE_H
+
+#include "figure.h"
+#include "array.h"
+#include "figure_kind.h"
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+template<typename C>
+concept CompactCoord = std::same_as<C, float> || std::same_as<C, int16_t>;
+
+// Компактное хранилище четырехугольников: координаты хранятся относительно общего
+// начала координат (originX, originY) в единицах scale как float или int16,
+// а для вычислений расширяются до double.
+//
+// Погрешность координаты не превышает coordinateErrorBound():
+//   float: |x - origin| * 2^-24 (половина ulp на максимальном смещении);
+//   int16: scale / 2.
+// Погрешность площади фигуры с ограничивающим прямоугольником периметра P
+// при погрешности координат e не превышает e * P + 4 * e^2 (areaErrorBound()).
+template<CompactCoord Coord>
+class CompactFigureStore {
+private:
+    std::vector<Coord> coords;
+    std::vector<FigureKind> kinds;
+    double originX;
+    double originY;
+    double scale;
+    double maxOffset;
+
+    Coord encode(double offset) const {
+        if constexpr (std::is_floating_point_v<Coord>) {
+            return static_cast<Coord>(offset / scale);
+        } else {
+            double q = std::nearbyint(offset / scale);
+            if (!(std::abs(q) <= std::numeric_limits<Coord>::max())) {
+                throw std::out_of_range("координата вне диапазона компактного хранилища");
+            }
+            return static_cast<Coord>(q);
+        }
+    }
+
+    double offsetX(size_t index, size_t vertex) const {
+        return static_cast<double>(coords[8 * index + 2 * vertex]) * scale;
+    }
+
+    double offsetY(size_t index, size_t vertex) const {
+        return static_cast<double>(coords[8 * index + 2 * vertex + 1]) * scale;
+    }
+
+    void checkIndex(size_t index) const {
+        if (index >= kinds.size()) {
+            throw std::out_of_range("Index out of range");
+        }
+    }
+
+public:
+    CompactFigureStore(double origin_x, double origin_y, double step = 1.0)
+        : originX(origin_x), originY(origin_y), scale(step), maxOffset(0.0) {
+        if (!(scale > 0.0)) {
+            throw std::invalid_argument("масштаб должен быть положительным");
+        }
+    }
+
+    // Начало координат ставится в центр общего ограничивающего прямоугольника,
+    // для int16 масштаб подбирается так, чтобы все вершины попали в диапазон.
+    template<Scalar T>
+    static CompactFigureStore fromFigures(const Array<std::shared_ptr<Figure<T>>>& figures) {
+        double minX = 0.0, minY = 0.0, maxX = 0.0, maxY = 0.0;
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            for (size_t v = 0; v < figures[i]->getVertexCount(); ++v) {
+                Point<T> p = figures[i]->getVertex(v);
+                double x = static_cast<double>(p.x);
+                double y = static_cast<double>(p.y);
+                bool first = i == 0 && v == 0;
+                minX = first ? x : std::min(minX, x);
+                minY = first ? y : std::min(minY, y);
+                maxX = first ? x : std::max(maxX, x);
+                maxY = first ? y : std::max(maxY, y);
+            }
+        }
+
+        double step = 1.0;
+        if constexpr (!std::is_floating_point_v<Coord>) {
+            double halfExtent = std::max(maxX - minX, maxY - minY) / 2.0;
+            if (halfExtent > 0.0) {
+                step = halfExtent / (std::numeric_limits<Coord>::max() - 1);
+            }
+        }
+
+        CompactFigureStore store((minX + maxX) / 2.0, (minY + maxY) / 2.0, step);
+        store.reserve(figures.getSize());
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            store.pushBack(*figures[i]);
+        }
+        return store;
+    }
+
+    void reserve(size_t count) {
+        coords.reserve(8 * count);
+        kinds.reserve(count);
+    }
+
+    template<Scalar T>
+    void pushBack(const Figure<T>& figure) {
+        if (figure.getVertexCount() != 4) {
+            throw std::invalid_argument("в компактном хранилище только четырехугольники");
+        }
+        FigureKind kind = figureKind(figure);
+        Coord encoded[8];
+        double offset = maxOffset;
+        for (size_t v = 0; v < 4; ++v) {
+            Point<T> p = figure.getVertex(v);
+            double dx = static_cast<double>(p.x) - originX;
+            double dy = static_cast<double>(p.y) - originY;
+            encoded[2 * v] = encode(dx);
+            encoded[2 * v + 1] = encode(dy);
+            offset = std::max(offset, std::max(std::abs(dx), std::abs(dy)));
+        }
+        coords.insert(coords.end(), encoded, encoded + 8);
+        kinds.push_back(kind);
+        maxOffset = offset;
+    }
+
+    Point<double> getVertex(size_t index, size_t vertex) const {
+        checkIndex(index);
+        if (vertex >= 4) {
+            throw std::out_of_range("Index out of range");
+        }
+        return Point<double>(originX + offsetX(index, vertex), originY + offsetY(index, vertex));
+    }
+
+    FigureKind getKind(size_t index) const {
+        checkIndex(index);
+        return kinds[index];
+    }
+
+    double area(size_t index) const {
+        checkIndex(index);
+        double sum = 0.0;
+        for (size_t i = 0; i < 4; ++i) {
+            size_t j = (i + 1) % 4;
+            sum += offsetX(index, i) * offsetY(index, j);
+            sum -= offsetX(index, j) * offsetY(index, i);
+        }
+        return std::abs(sum) / 2.0;
+    }
+
+    Point<double> Center(size_t index) const {
+        checkIndex(index);
+        double cx = 0.0, cy = 0.0;
+        for (size_t v = 0; v < 4; ++v) {
+            cx += offsetX(index, v);
+            cy += offsetY(index, v);
+        }
+        return Point<double>(originX + cx / 4.0, originY + cy / 4.0);
+    }
+
+    double totalArea() const {
+        double total = 0.0;
+        for (size_t i = 0; i < kinds.size(); ++i) {
+            total += area(i);
+        }
+        return total;
+    }
+
+    // Восстанавливает полноценную фигуру; может бросить invalid_argument,
+    // если после квантования фигура выродилась.
+    std::shared_ptr<Figure<double>> figure(size_t index) const {
+        checkIndex(index);
+        Point<double> points[4];
+        for (size_t v = 0; v < 4; ++v) {
+            points[v] = getVertex(index, v);
+        }
+        return makeFigure(kinds[index], points);
+    }
+
+    double coordinateErrorBound() const {
+        // Второе слагаемое учитывает округления в double: вычитание начала координат,
+        // деление на масштаб и обратное умножение.
+        double roundoff = 2.0 * maxOffset * std::numeric_limits<double>::epsilon();
+        if constexpr (std::is_floating_point_v<Coord>) {
+            return maxOffset * std::numeric_limits<Coord>::epsilon() / 2.0 + roundoff;
+        } else {
+            return scale / 2.0 + roundoff;
+        }
+    }
+
+    double areaErrorBound(size_t index) const {
+        checkIndex(index);
+        double minX = offsetX(index, 0), maxX = minX;
+        double minY = offsetY(index, 0), maxY = minY;
+        for (size_t v = 1; v < 4; ++v) {
+            minX = std::min(minX, offsetX(index, v));
+            maxX = std::max(maxX, offsetX(index, v));
+            minY = std::min(minY, offsetY(index, v));
+            maxY = std::max(maxY, offsetY(index, v));
+        }
+        double e = coordinateErrorBound();
+        double perimeter = 2.0 * (maxX - minX + maxY - minY) + 4.0 * e;
+        return e * perimeter + 4.0 * e * e;
+    }
+
+    double getScale() const { return scale; }
+    Point<double> getOrigin() const { return Point<double>(originX, originY); }
+
+    void clear() {
+        coords.clear();
+        kinds.clear();
+        maxOffset = 0.0;
+    }
+
+    size_t getSize() const { return kinds.size(); }
+    bool isEmpty() const { return kinds.empty(); }
+
+    size_t memoryUsage() const {
+        return sizeof(*this) + coords.capacity() * sizeof(Coord) + kinds.capacity() * sizeof(FigureKind);
+    }
+};
+
+#endif
\ No newline at end of file
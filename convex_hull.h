@@ -0,0 +1,108 @@
+#ifndef CONVEX_HULL_H
+#define CONVEX_HULL_H
+
+#include "figure.h"
+#include "array.h"
+#include "intersection.h"
+#include "parallel.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// Выпуклая оболочка набора точек (монотонная цепочка Эндрю), обход против часовой
+// стрелки без коллинеарных точек. Входной вектор сортируется на месте.
+inline Contour convexHull(Contour& points) {
+    std::sort(points.begin(), points.end(), [](const Point<double>& l, const Point<double>& r) {
+        return l.x != r.x ? l.x < r.x : l.y < r.y;
+    });
+    points.erase(std::unique(points.begin(), points.end(), [](const Point<double>& l, const Point<double>& r) {
+        return l.x == r.x && l.y == r.y;
+    }), points.end());
+    if (points.size() < 3) {
+        return points;
+    }
+
+    Contour hull(2 * points.size());
+    size_t k = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        while (k >= 2 && crossProduct(hull[k - 2], hull[k - 1], points[i]) <= 0.0) {
+            --k;
+        }
+        hull[k++] = points[i];
+    }
+    for (size_t i = points.size() - 1, lower = k + 1; i > 0; --i) {
+        while (k >= lower && crossProduct(hull[k - 2], hull[k - 1], points[i - 1]) <= 0.0) {
+            --k;
+        }
+        hull[k++] = points[i - 1];
+    }
+    hull.resize(k - 1);
+    return hull;
+}
+
+// Отбрасывает точки строго внутри восьмиугольника из крайних точек по x, y, x + y и x - y
+// (эвристика Акла–Туссена): они не могут попасть в оболочку, а сортировать остается мало.
+inline void discardInterior(Contour& points) {
+    if (points.size() < 16) {
+        return;
+    }
+    // Направления перечислены против часовой стрелки, поэтому крайние точки
+    // образуют выпуклый многоугольник с тем же обходом.
+    static constexpr double dirs[8][2] = {
+        {0, -1}, {1, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}
+    };
+    Point<double> extreme[8];
+    double best[8];
+    for (size_t k = 0; k < 8; ++k) {
+        extreme[k] = points[0];
+        best[k] = dirs[k][0] * points[0].x + dirs[k][1] * points[0].y;
+    }
+    for (const Point<double>& p : points) {
+        for (size_t k = 0; k < 8; ++k) {
+            double value = dirs[k][0] * p.x + dirs[k][1] * p.y;
+            if (value > best[k]) {
+                best[k] = value;
+                extreme[k] = p;
+            }
+        }
+    }
+
+    auto inside = [&extreme](const Point<double>& p) {
+        for (size_t k = 0; k < 8; ++k) {
+            const Point<double>& a = extreme[k];
+            const Point<double>& b = extreme[(k + 1) % 8];
+            if ((a.x != b.x || a.y != b.y) && crossProduct(a, b, p) <= 0.0) {
+                return false;
+            }
+        }
+        return true;
+    };
+    points.erase(std::remove_if(points.begin(), points.end(), inside), points.end());
+}
+
+// Выпуклая оболочка всех вершин коллекции. Каждый поток строит оболочку своего куска
+// фигур, затем оболочки кусков сливаются еще одним проходом монотонной цепочки —
+// на слияние приходится лишь суммарное число вершин частичных оболочек.
+template<Scalar T>
+Contour convexHull(const Array<std::shared_ptr<Figure<T>>>& figures, size_t threads = defaultThreadCount()) {
+    std::vector<Contour> partial(std::max<size_t>(threads, 1));
+    parallelFor(figures.getSize(), threads, [&](size_t begin, size_t end, size_t part) {
+        Contour points;
+        for (size_t i = begin; i < end; ++i) {
+            for (size_t v = 0; v < figures[i]->getVertexCount(); ++v) {
+                Point<T> p = figures[i]->getVertex(v);
+                points.emplace_back(static_cast<double>(p.x), static_cast<double>(p.y));
+            }
+        }
+        discardInterior(points);
+        partial[part] = convexHull(points);
+    });
+
+    Contour merged;
+    for (const Contour& hull : partial) {
+        merged.insert(merged.end(), hull.begin(), hull.end());
+    }
+    return convexHull(merged);
+}
+
+#endif
\ No newline at end of file
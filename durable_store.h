@@ -0,0 +1,613 @@
+#ifndef DURABLE_STORE_H
+#define DURABLE_STORE_H
+
+#include "figure.h"
+#include "array.h"
+#include "figure_kind.h"
+#include "figure_journal.h"
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Когда журнал сбрасывается на диск через fdatasync.
+enum class SyncPolicy : uint8_t {
+    Never,  // только write: переживает падение процесса после commit, но не отключение питания
+    Always, // write и fdatasync на каждую операцию
+    Group   // групповая фиксация: один write и fdatasync на groupOps операций или commit()
+};
+
+struct DurableOptions {
+    SyncPolicy sync = SyncPolicy::Group;
+    size_t groupOps = 256;
+    size_t bufferBytes = 1 << 20;
+    size_t compactBytes = 64 << 20; // 0 — сжимать только вызовом compact()
+};
+
+struct RecoveryStats {
+    size_t snapshotFigures = 0;
+    size_t walRecords = 0;
+    size_t truncatedBytes = 0;
+    double milliseconds = 0.0;
+};
+
+namespace detail {
+
+inline uint32_t crc32(const char* data, size_t length, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> result{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            result[i] = c;
+        }
+        return result;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+[[noreturn]] inline void throwSystemError(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+inline void writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = ::write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throwSystemError("ошибка записи журнала");
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+}
+
+inline void syncDirectory(const std::filesystem::path& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        throwSystemError("не удалось открыть каталог " + directory.string());
+    }
+    ::fsync(fd);
+    ::close(fd);
+}
+
+// Чтение файла большими блоками: разбор записей не делает системный вызов на каждое поле.
+class FileReader {
+private:
+    int fd;
+    std::vector<char> buffer;
+    size_t begin = 0;
+    size_t end = 0;
+    size_t consumed = 0;
+
+public:
+    explicit FileReader(int descriptor, size_t blockBytes = 1 << 20) : fd(descriptor), buffer(blockBytes) {}
+
+    // Копирует length байт в out; false, если файл кончился раньше.
+    bool read(void* out, size_t length) {
+        char* target = static_cast<char*>(out);
+        while (length > 0) {
+            if (begin == end) {
+                ssize_t got = ::read(fd, buffer.data(), buffer.size());
+                if (got < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (got < 0) {
+                    throwSystemError("ошибка чтения журнала");
+                }
+                if (got == 0) {
+                    return false;
+                }
+                begin = 0;
+                end = static_cast<size_t>(got);
+            }
+            size_t chunk = std::min(length, end - begin);
+            std::memcpy(target, buffer.data() + begin, chunk);
+            begin += chunk;
+            consumed += chunk;
+            target += chunk;
+            length -= chunk;
+        }
+        return true;
+    }
+
+    size_t getConsumed() const { return consumed; }
+};
+
+}
+
+// Долговременное хранилище коллекции фигур: журнал упреждающей записи (WAL)
+// операций add/insert/remove/clear и снимок, в который журнал периодически сжимается.
+//
+// Каталог содержит snapshot.bin и wal.log. Запись журнала — длина, CRC32 и тело
+// (код операции и данные), поэтому оборванный при сбое хвост обнаруживается
+// и отрезается при восстановлении. Снимок пишется во временный файл и заменяет
+// старый через rename; у снимка и журнала общий номер поколения, так что журнал
+// старше снимка (сбой между rename и сбросом журнала) при восстановлении пропускается.
+// Числа пишутся в порядке байт машины, размер T проверяется при открытии.
+template<Scalar T>
+class DurableFigureStore {
+    static_assert(std::is_trivially_copyable_v<T>, "координаты пишутся побайтово");
+
+public:
+    using Figures = Array<std::shared_ptr<Figure<T>>>;
+
+private:
+    enum Op : uint8_t {
+        OpAdd = 1,
+        OpRemove = 2,
+        OpClear = 3,
+        OpInsert = 4
+    };
+
+    static constexpr char WalMagic[4] = {'L', 'B', '4', 'W'};
+    static constexpr char SnapshotMagic[4] = {'L', 'B', '4', 'S'};
+    static constexpr uint16_t FormatVersion = 1;
+    static constexpr size_t HeaderBytes = 16;
+    static constexpr size_t FigureBytes = 1 + 8 * sizeof(T);
+
+    std::filesystem::path directory;
+    DurableOptions options;
+    Figures figures;
+    int walFd = -1;
+    uint64_t generation = 0;
+    size_t walBytes = 0;
+    std::vector<char> pending;
+    size_t pendingOps = 0;
+    RecoveryStats recovery;
+
+    std::filesystem::path walPath() const { return directory / "wal.log"; }
+    std::filesystem::path snapshotPath() const { return directory / "snapshot.bin"; }
+
+    static void makeHeader(char (&header)[HeaderBytes], const char (&magic)[4], uint64_t gen) {
+        uint16_t scalarSize = sizeof(T);
+        std::memcpy(header, magic, 4);
+        std::memcpy(header + 4, &FormatVersion, 2);
+        std::memcpy(header + 6, &scalarSize, 2);
+        std::memcpy(header + 8, &gen, 8);
+    }
+
+    static uint64_t checkHeader(const char (&header)[HeaderBytes], const char (&magic)[4]) {
+        uint16_t version;
+        uint16_t scalarSize;
+        uint64_t gen;
+        std::memcpy(&version, header + 4, 2);
+        std::memcpy(&scalarSize, header + 6, 2);
+        std::memcpy(&gen, header + 8, 8);
+        if (std::memcmp(header, magic, 4) != 0 || version != FormatVersion) {
+            throw std::runtime_error("неизвестный формат файла хранилища");
+        }
+        if (scalarSize != sizeof(T)) {
+            throw std::runtime_error("хранилище записано с другим типом координат");
+        }
+        return gen;
+    }
+
+    static void encodeFigure(std::vector<char>& out, const Figure<T>& figure) {
+        size_t offset = out.size();
+        out.resize(offset + FigureBytes);
+        char* cursor = out.data() + offset;
+        *cursor++ = static_cast<char>(figureKind(figure));
+        for (size_t v = 0; v < 4; ++v) {
+            Point<T> p = figure.getVertex(v);
+            std::memcpy(cursor, &p.x, sizeof(T));
+            std::memcpy(cursor + sizeof(T), &p.y, sizeof(T));
+            cursor += 2 * sizeof(T);
+        }
+    }
+
+    static std::shared_ptr<Figure<T>> decodeFigure(const char* data) {
+        uint8_t kind = static_cast<uint8_t>(data[0]);
+        if (kind >= FigureKindCount) {
+            throw std::runtime_error("неизвестный тип фигуры в хранилище");
+        }
+        Point<T> points[4];
+        for (size_t v = 0; v < 4; ++v) {
+            std::memcpy(&points[v].x, data + 1 + 2 * v * sizeof(T), sizeof(T));
+            std::memcpy(&points[v].y, data + 1 + (2 * v + 1) * sizeof(T), sizeof(T));
+        }
+        return makeFigure(static_cast<FigureKind>(kind), points);
+    }
+
+    void append(Op op, const Figure<T>* figure, uint64_t index) {
+        size_t start = pending.size();
+        pending.resize(start + 8);
+        pending.push_back(static_cast<char>(op));
+        if (op == OpRemove || op == OpInsert) {
+            const char* bytes = reinterpret_cast<const char*>(&index);
+            pending.insert(pending.end(), bytes, bytes + 8);
+        }
+        if (op == OpAdd || op == OpInsert) {
+            encodeFigure(pending, *figure);
+        }
+        uint32_t length = static_cast<uint32_t>(pending.size() - start - 8);
+        uint32_t crc = detail::crc32(pending.data() + start + 8, length);
+        std::memcpy(pending.data() + start, &length, 4);
+        std::memcpy(pending.data() + start + 4, &crc, 4);
+        ++pendingOps;
+
+        switch (options.sync) {
+            case SyncPolicy::Always:
+                commit();
+                break;
+            case SyncPolicy::Group:
+                if (pendingOps >= options.groupOps) {
+                    commit();
+                }
+                break;
+            case SyncPolicy::Never:
+                if (pending.size() >= options.bufferBytes) {
+                    commit();
+                }
+                break;
+        }
+    }
+
+    void applyRecord(const char* body, size_t length) {
+        switch (static_cast<uint8_t>(body[0])) {
+            case OpAdd:
+                if (length != 1 + FigureBytes) {
+                    throw std::runtime_error("поврежденная запись журнала");
+                }
+                figures.pushBack(decodeFigure(body + 1));
+                break;
+            case OpRemove: {
+                uint64_t index;
+                if (length != 9) {
+                    throw std::runtime_error("поврежденная запись журнала");
+                }
+                std::memcpy(&index, body + 1, 8);
+                figures.remove(static_cast<size_t>(index));
+                break;
+            }
+            case OpClear:
+                figures = Figures();
+                break;
+            case OpInsert: {
+                uint64_t index;
+                if (length != 9 + FigureBytes) {
+                    throw std::runtime_error("поврежденная запись журнала");
+                }
+                std::memcpy(&index, body + 1, 8);
+                figures.insert(static_cast<size_t>(index), decodeFigure(body + 9));
+                break;
+            }
+            default:
+                throw std::runtime_error("неизвестная операция в журнале");
+        }
+    }
+
+    void loadSnapshot() {
+        int fd = ::open(snapshotPath().c_str(), O_RDONLY);
+        if (fd < 0) {
+            if (errno == ENOENT) {
+                return;
+            }
+            detail::throwSystemError("не удалось открыть снимок");
+        }
+        try {
+            detail::FileReader reader(fd);
+            char header[HeaderBytes];
+            uint64_t count;
+            if (!reader.read(header, HeaderBytes) || !reader.read(&count, 8)) {
+                throw std::runtime_error("снимок поврежден");
+            }
+            generation = checkHeader(header, SnapshotMagic);
+            struct stat info;
+            ::fstat(fd, &info);
+            if (count > static_cast<uint64_t>(info.st_size) / FigureBytes) {
+                throw std::runtime_error("снимок поврежден");
+            }
+            figures = Figures(static_cast<size_t>(count));
+            uint32_t crc = 0;
+            char record[FigureBytes];
+            for (uint64_t i = 0; i < count; ++i) {
+                if (!reader.read(record, FigureBytes)) {
+                    throw std::runtime_error("снимок поврежден");
+                }
+                crc = detail::crc32(record, FigureBytes, crc);
+                figures.pushBack(decodeFigure(record));
+            }
+            uint32_t stored;
+            if (!reader.read(&stored, 4) || stored != crc) {
+                throw std::runtime_error("снимок поврежден");
+            }
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+        recovery.snapshotFigures = figures.getSize();
+    }
+
+    // Проигрывает журнал и возвращает длину его целой части.
+    size_t replayWal(int fd) {
+        detail::FileReader reader(fd);
+        char header[HeaderBytes];
+        if (!reader.read(header, HeaderBytes)) {
+            return 0;
+        }
+        uint64_t walGeneration = checkHeader(header, WalMagic);
+        if (walGeneration < generation) {
+            return 0;
+        }
+        generation = walGeneration;
+
+        size_t good = HeaderBytes;
+        std::vector<char> body;
+        while (true) {
+            uint32_t frame[2];
+            if (!reader.read(frame, 8) || frame[0] == 0 || frame[0] > (1u << 20)) {
+                break;
+            }
+            body.resize(frame[0]);
+            if (!reader.read(body.data(), frame[0]) || detail::crc32(body.data(), frame[0]) != frame[1]) {
+                break;
+            }
+            applyRecord(body.data(), frame[0]);
+            ++recovery.walRecords;
+            good = reader.getConsumed();
+        }
+        return good;
+    }
+
+    // Создает пустой журнал текущего поколения на месте старого.
+    void resetWal() {
+        std::filesystem::path temporary = directory / "wal.tmp";
+        int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            detail::throwSystemError("не удалось создать журнал");
+        }
+        char header[HeaderBytes];
+        makeHeader(header, WalMagic, generation);
+        detail::writeAll(fd, header, HeaderBytes);
+        ::fdatasync(fd);
+        if (::rename(temporary.c_str(), walPath().c_str()) != 0) {
+            ::close(fd);
+            detail::throwSystemError("не удалось заменить журнал");
+        }
+        detail::syncDirectory(directory);
+        if (walFd >= 0) {
+            ::close(walFd);
+        }
+        walFd = fd;
+        walBytes = HeaderBytes;
+        ::lseek(walFd, 0, SEEK_END);
+    }
+
+    void recover() {
+        auto start = std::chrono::steady_clock::now();
+        loadSnapshot();
+
+        int fd = ::open(walPath().c_str(), O_RDWR);
+        if (fd < 0 && errno != ENOENT) {
+            detail::throwSystemError("не удалось открыть журнал");
+        }
+        size_t good = 0;
+        if (fd >= 0) {
+            try {
+                good = replayWal(fd);
+            } catch (...) {
+                ::close(fd);
+                throw;
+            }
+        }
+        if (good == 0) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            resetWal();
+        } else {
+            struct stat info;
+            ::fstat(fd, &info);
+            recovery.truncatedBytes = static_cast<size_t>(info.st_size) - good;
+            if (recovery.truncatedBytes > 0 && ::ftruncate(fd, static_cast<off_t>(good)) != 0) {
+                ::close(fd);
+                detail::throwSystemError("не удалось отрезать поврежденный хвост журнала");
+            }
+            ::lseek(fd, 0, SEEK_END);
+            walFd = fd;
+            walBytes = good;
+        }
+        recovery.milliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+public:
+    explicit DurableFigureStore(const std::filesystem::path& dir, DurableOptions opts = {})
+        : directory(dir), options(opts) {
+        std::filesystem::create_directories(directory);
+        recover();
+    }
+
+    DurableFigureStore(const DurableFigureStore&) = delete;
+    DurableFigureStore& operator=(const DurableFigureStore&) = delete;
+
+    ~DurableFigureStore() {
+        try {
+            commit();
+        } catch (...) {
+        }
+        if (walFd >= 0) {
+            ::close(walFd);
+        }
+    }
+
+    void pushBack(std::shared_ptr<Figure<T>> figure) {
+        if (!figure || figure->getVertexCount() != 4) {
+            throw std::invalid_argument("в хранилище пишутся только четырехугольники");
+        }
+        append(OpAdd, figure.get(), 0);
+        figures.pushBack(std::move(figure));
+    }
+
+    void insert(size_t index, std::shared_ptr<Figure<T>> figure) {
+        if (!figure || figure->getVertexCount() != 4) {
+            throw std::invalid_argument("в хранилище пишутся только четырехугольники");
+        }
+        if (index > figures.getSize()) {
+            throw std::out_of_range("Index out of range");
+        }
+        append(OpInsert, figure.get(), index);
+        figures.insert(index, std::move(figure));
+    }
+
+    void remove(size_t index) {
+        if (index >= figures.getSize()) {
+            throw std::out_of_range("Index out of range");
+        }
+        append(OpRemove, nullptr, index);
+        figures.remove(index);
+    }
+
+    void clear() {
+        append(OpClear, nullptr, 0);
+        figures = Figures();
+    }
+
+    // Заменяет содержимое хранилища: clear и добавление каждой фигуры.
+    void assign(const Figures& source) {
+        clear();
+        for (size_t i = 0; i < source.getSize(); ++i) {
+            pushBack(source[i]);
+        }
+    }
+
+    // Записывает накопленные операции одним write и, если политика требует, fdatasync.
+    // После возврата операции переживают падение процесса, а при Always и Group — и ОС.
+    void commit() {
+        if (pending.empty()) {
+            return;
+        }
+        detail::writeAll(walFd, pending.data(), pending.size());
+        if (options.sync != SyncPolicy::Never && ::fdatasync(walFd) != 0) {
+            detail::throwSystemError("ошибка fdatasync журнала");
+        }
+        walBytes += pending.size();
+        pending.clear();
+        pendingOps = 0;
+        if (options.compactBytes > 0 && walBytes >= options.compactBytes) {
+            compact();
+        }
+    }
+
+    // Сжатие: текущая коллекция пишется в новый снимок, журнал начинается заново.
+    void compact() {
+        detail::writeAll(walFd, pending.data(), pending.size());
+        pending.clear();
+        pendingOps = 0;
+
+        std::filesystem::path temporary = directory / "snapshot.tmp";
+        int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            detail::throwSystemError("не удалось создать снимок");
+        }
+        try {
+            std::vector<char> buffer;
+            buffer.reserve(options.bufferBytes + FigureBytes + HeaderBytes + 8);
+            char header[HeaderBytes];
+            makeHeader(header, SnapshotMagic, generation + 1);
+            uint64_t count = figures.getSize();
+            buffer.insert(buffer.end(), header, header + HeaderBytes);
+            buffer.insert(buffer.end(), reinterpret_cast<const char*>(&count), reinterpret_cast<const char*>(&count) + 8);
+            uint32_t crc = 0;
+            for (size_t i = 0; i < figures.getSize(); ++i) {
+                size_t offset = buffer.size();
+                encodeFigure(buffer, *figures[i]);
+                crc = detail::crc32(buffer.data() + offset, FigureBytes, crc);
+                if (buffer.size() >= options.bufferBytes) {
+                    detail::writeAll(fd, buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+            }
+            buffer.insert(buffer.end(), reinterpret_cast<const char*>(&crc), reinterpret_cast<const char*>(&crc) + 4);
+            detail::writeAll(fd, buffer.data(), buffer.size());
+            if (::fdatasync(fd) != 0) {
+                detail::throwSystemError("ошибка fdatasync снимка");
+            }
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+        if (::rename(temporary.c_str(), snapshotPath().c_str()) != 0) {
+            detail::throwSystemError("не удалось заменить снимок");
+        }
+        detail::syncDirectory(directory);
+        ++generation;
+        resetWal();
+    }
+
+    const Figures& getFigures() const { return figures; }
+    const RecoveryStats& getRecoveryStats() const { return recovery; }
+    size_t getWalBytes() const { return walBytes + pending.size(); }
+};
+
+// Подписывает хранилище на журнал: каждое изменение коллекции журнала, включая
+// отмену и повтор, записывается в хранилище. Коллекция журнала должна совпадать
+// с содержимым хранилища на момент вызова.
+template<Scalar T>
+void persistJournal(FigureJournal<T>& journal, DurableFigureStore<T>& store) {
+    journal.setObserver([&journal, &store](JournalOp op, bool reverted, size_t index, size_t count) {
+        const Array<std::shared_ptr<Figure<T>>>& figures = journal.getFigures();
+        switch (op) {
+            case JournalOp::PushBack:
+                if (reverted) {
+                    store.remove(store.getFigures().getSize() - 1);
+                } else {
+                    store.pushBack(figures[figures.getSize() - 1]);
+                }
+                break;
+            case JournalOp::Remove:
+                if (reverted) {
+                    store.insert(index, figures[index]);
+                } else {
+                    store.remove(index);
+                }
+                break;
+            case JournalOp::Clear:
+                if (reverted) {
+                    store.assign(figures);
+                } else {
+                    store.clear();
+                }
+                break;
+            case JournalOp::Append:
+                // Батч проверяется целиком до записи, чтобы отвергнутый батч не попал в хранилище частично.
+                for (size_t i = 0; i < count && !reverted; ++i) {
+                    if (figures[figures.getSize() - count + i]->getVertexCount() != 4) {
+                        throw std::invalid_argument("в хранилище пишутся только четырехугольники");
+                    }
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    if (reverted) {
+                        store.remove(store.getFigures().getSize() - 1);
+                    } else {
+                        store.pushBack(figures[figures.getSize() - count + i]);
+                    }
+                }
+                break;
+        }
+    });
+}
+
+#endif
\ No newline at end of file
@@ -1,35 +1,46 @@
-#ifndef FIGURE_H
-#define FIGURE_H
-
-#include "Point.h"
-#include <iostream>
-#include <memory>
-
-template<Scalar T>
-class Figure {
-public:
-    virtual ~Figure() = default;
-
-    virtual Point<T> Center() const = 0;
-    virtual T area() const = 0;
-    virtual explicit operator double() const = 0;
-
-    virtual void Print(std::ostream& outS) const = 0;
-    virtual void Read(std::istream& inpS) = 0;
-
-    virtual std::unique_ptr<Figure<T>> clone() const = 0;
-};
-
-template<Scalar T>
-std::ostream& operator<<(std::ostream& outS, const Figure<T>& figure) {
-    figure.Print(outS);
-    return outS;
-}
-
-template<Scalar T>
-std::istream& operator>>(std::istream& inpS, Figure<T>& figure) {
-    figure.Read(inpS);
-    return inpS;
-}
-
+#ifndef FIGURE_H
+#define FIGURE_H
+
+#include "point.h"
+#include <cstddef>
+#include <iostream>
+#include <memory>
+
+// Размер блока кучи под объект из bytes байт по модели malloc из glibc:
+// заголовок size_t, выравнивание по 16 байт, минимальный блок 32 байта.
+constexpr size_t heapBlockSize(size_t bytes) {
+    size_t block = (bytes + sizeof(size_t) + 15) / 16 * 16;
+    return block < 32 ? 32 : block;
+}
+
+template<Scalar T>
+class Figure {
+public:
+    virtual ~Figure() = default;
+
+    virtual Point<T> Center() const = 0;
+    virtual T area() const = 0;
+    virtual size_t getVertexCount() const = 0;
+    virtual Point<T> getVertex(size_t index) const = 0;
+    virtual size_t memoryUsage() const = 0;
+    virtual explicit operator double() const = 0;
+
+    virtual void Print(std::ostream& outS) const = 0;
+    virtual void Read(std::istream& inpS) = 0;
+
+    virtual std::unique_ptr<Figure<T>> clone() const = 0;
+};
+
+template<Scalar T>
+std::ostream& operator<<(std::ostream& outS, const Figure<T>& figure) {
+    figure.Print(outS);
+    return outS;
+}
+
+template<Scalar T>
+std::istream& operator>>(std::istream& inpS, Figure<T>& figure) {
+    figure.Read(inpS);
+    return inpS;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef FIGURE_BATCH_H
+#define FIGURE_BATCH_H
+
+#include "figure.h"
+#include "array.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+// Маска строк пакета: бит row % 64 слова row / 64 установлен, если строка отклонена.
+class BatchMask {
+private:
+    std::vector<uint64_t> words;
+    size_t rows = 0;
+
+public:
+    BatchMask() = default;
+    explicit BatchMask(size_t rowCount) : words((rowCount + 63) / 64), rows(rowCount) {}
+
+    bool test(size_t row) const {
+        if (row >= rows) {
+            throw std::out_of_range("Index out of range");
+        }
+        return (words[row / 64] >> (row % 64)) & 1;
+    }
+
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t word : words) {
+            total += static_cast<size_t>(std::popcount(word));
+        }
+        return total;
+    }
+
+    void setWord(size_t index, uint64_t word) { words.at(index) = word; }
+    std::span<const uint64_t> getWords() const { return words; }
+    size_t getSize() const { return rows; }
+};
+
+namespace detail {
+
+// Тег конструкторов четырехугольников без проверки: вершины уже проверены пакетом.
+struct PrevalidatedTag {};
+
+// Проверка пакета четырехугольников: строка r — вершины (xs[4r + k], ys[4r + k]).
+// Площадь считается той же формулой, что и area() фигур, по 64 строки за раз без ветвлений,
+// поэтому цикл векторизуется; строка отклоняется по тому же правилу, что и в конструкторах.
+template<Scalar T>
+BatchMask validateBatch(std::span<const T> xs, std::span<const T> ys) {
+    if (xs.size() != ys.size() || xs.size() % 4 != 0) {
+        throw std::invalid_argument("в пакете должно быть поровну x и y, по четыре на фигуру");
+    }
+    size_t rows = xs.size() / 4;
+    BatchMask invalid(rows);
+    T areas[64];
+    for (size_t base = 0; base < rows; base += 64) {
+        size_t count = std::min<size_t>(64, rows - base);
+        const T* x = xs.data() + 4 * base;
+        const T* y = ys.data() + 4 * base;
+        for (size_t k = 0; k < count; ++k) {
+            T x1 = x[4 * k + 1] - x[4 * k], y1 = y[4 * k + 1] - y[4 * k];
+            T x2 = x[4 * k + 2] - x[4 * k], y2 = y[4 * k + 2] - y[4 * k];
+            T x3 = x[4 * k + 3] - x[4 * k], y3 = y[4 * k + 3] - y[4 * k];
+            T sum = T(0);
+            sum += x1 * y2 - x2 * y1;
+            sum += x2 * y3 - x3 * y2;
+            areas[k] = std::abs(sum) / T(2);
+        }
+        uint64_t word = 0;
+        for (size_t k = 0; k < count; ++k) {
+            word |= static_cast<uint64_t>(areas[k] < 1e-9) << k;
+        }
+        invalid.setWord(base / 64, word);
+    }
+    return invalid;
+}
+
+// Проверяет пакет и добавляет допустимые фигуры F в out в порядке строк, без повторной проверки.
+template<typename F, Scalar T>
+BatchMask makeBatch(std::span<const T> xs, std::span<const T> ys, Array<std::shared_ptr<Figure<T>>>& out) {
+    BatchMask invalid = validateBatch(xs, ys);
+    out.reserve(out.getSize() + invalid.getSize() - invalid.count());
+    std::span<const uint64_t> words = invalid.getWords();
+    for (size_t row = 0; row < invalid.getSize(); ++row) {
+        if ((words[row / 64] >> (row % 64)) & 1) {
+            continue;
+        }
+        const T* x = xs.data() + 4 * row;
+        const T* y = ys.data() + 4 * row;
+        out.pushBack(std::make_shared<F>(PrevalidatedTag{}, Point<T>(x[0], y[0]), Point<T>(x[1], y[1]),
+                                         Point<T>(x[2], y[2]), Point<T>(x[3], y[3])));
+    }
+    return invalid;
+}
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,250 @@
+#ifndef FIGURE_INDEX_H
+#define FIGURE_INDEX_H
+
+#include "figure.h"
+#include "array.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Ключ фигуры не зависит от порядка и направления обхода вершин: это ячейка сетки с шагом
+// 2 * eps, в которую попадает среднее вершин, и число вершин. Почти совпадающие фигуры
+// (вершины отличаются не больше чем на eps по каждой координате) попадают в ту же или
+// соседнюю ячейку, поэтому индекс просматривает две ячейки по каждой оси и сравнивает вершины.
+struct FigureKey {
+    double cellX = 0.0;
+    double cellY = 0.0;
+    size_t vertexCount = 0;
+
+    bool operator==(const FigureKey& other) const = default;
+};
+
+inline uint64_t mixHash(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+struct FigureKeyHash {
+    size_t operator()(const FigureKey& key) const {
+        uint64_t x;
+        uint64_t y;
+        std::memcpy(&x, &key.cellX, sizeof(x));
+        std::memcpy(&y, &key.cellY, sizeof(y));
+        return static_cast<size_t>(mixHash(mixHash(mixHash(key.vertexCount) ^ x) ^ y));
+    }
+};
+
+// Среднее вершин фигуры в единицах ячейки ключа.
+template<Scalar T>
+Point<double> figureKeyAnchor(const Figure<T>& figure, double eps) {
+    if (!(eps > 0.0)) {
+        throw std::invalid_argument("eps должен быть положительным");
+    }
+    size_t n = figure.getVertexCount();
+    double x = 0.0;
+    double y = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        Point<T> p = figure.getVertex(i);
+        x += static_cast<double>(p.x);
+        y += static_cast<double>(p.y);
+    }
+    double scale = 2.0 * eps * static_cast<double>(n);
+    return Point<double>(x / scale, y / scale);
+}
+
+inline FigureKey figureKeyAt(const Point<double>& anchor, size_t vertexCount) {
+    // + 0.0 убирает отрицательный ноль, чтобы -0 и 0 давали один ключ
+    return FigureKey{std::floor(anchor.x) + 0.0, std::floor(anchor.y) + 0.0, vertexCount};
+}
+
+template<Scalar T>
+FigureKey makeFigureKey(const Figure<T>& figure, double eps = 1e-9) {
+    return figureKeyAt(figureKeyAnchor(figure, eps), figure.getVertexCount());
+}
+
+// Хеш-индекс с открытой адресацией (линейное пробирование) по ключам фигур.
+// Вершины проиндексированных фигур хранятся подряд в одном массиве, слот ссылается на них
+// смещением. Хранит позицию первой фигуры, совпадающей с данной с точностью до eps.
+template<Scalar T>
+class FigureIndex {
+private:
+    static constexpr size_t Empty = static_cast<size_t>(-1);
+
+    struct Slot {
+        size_t hash = 0;
+        size_t position = Empty;
+        size_t offset = 0;
+        FigureKey key;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<double> vertices;
+    size_t count;
+    double eps;
+
+    void rehash(size_t newSize) {
+        std::vector<Slot> old = std::move(slots);
+        slots = std::vector<Slot>(newSize);
+        for (Slot& slot : old) {
+            if (slot.position != Empty) {
+                slots[emptySlot(slot.hash)] = slot;
+            }
+        }
+    }
+
+    size_t emptySlot(size_t hash) const {
+        size_t mask = slots.size() - 1;
+        size_t i = hash & mask;
+        while (slots[i].position != Empty) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    bool near(const double* stored, const Point<T>& p) const {
+        return std::abs(stored[0] - static_cast<double>(p.x)) <= eps &&
+               std::abs(stored[1] - static_cast<double>(p.y)) <= eps;
+    }
+
+    // Совпадают ли вершины при каком-либо начале и направлении обхода.
+    bool matches(const Slot& slot, const Figure<T>& figure) const {
+        size_t n = slot.key.vertexCount;
+        const double* stored = vertices.data() + slot.offset;
+        Point<T> first = figure.getVertex(0);
+        for (size_t start = 0; start < n; ++start) {
+            if (!near(stored + 2 * start, first)) {
+                continue;
+            }
+            for (size_t step : {size_t(1), n - 1}) {
+                size_t k = 1;
+                while (k < n && near(stored + 2 * ((start + step * k) % n), figure.getVertex(k))) {
+                    ++k;
+                }
+                if (k == n) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    std::optional<size_t> lookup(const Figure<T>& figure, const FigureKey& key, const Point<double>& anchor) const {
+        if (slots.empty() || key.vertexCount == 0) {
+            return std::nullopt;
+        }
+        double sideX = anchor.x - key.cellX < 0.5 ? -1.0 : 1.0;
+        double sideY = anchor.y - key.cellY < 0.5 ? -1.0 : 1.0;
+        size_t mask = slots.size() - 1;
+        for (double dx : {0.0, sideX}) {
+            for (double dy : {0.0, sideY}) {
+                FigureKey probe{key.cellX + dx, key.cellY + dy, key.vertexCount};
+                size_t hash = FigureKeyHash{}(probe);
+                for (size_t i = hash & mask; slots[i].position != Empty; i = (i + 1) & mask) {
+                    if (slots[i].hash == hash && slots[i].key == probe && matches(slots[i], figure)) {
+                        return slots[i].position;
+                    }
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+public:
+    explicit FigureIndex(double epsilon = 1e-9) : count(0), eps(epsilon) {
+        if (!(eps > 0.0)) {
+            throw std::invalid_argument("eps должен быть положительным");
+        }
+    }
+
+    void reserve(size_t expected) {
+        size_t needed = 16;
+        while (needed < expected * 2) {
+            needed *= 2;
+        }
+        if (needed > slots.size()) {
+            rehash(needed);
+        }
+    }
+
+    // Возвращает позицию уже проиндексированной фигуры, совпадающей с данной с точностью
+    // до eps, либо добавляет фигуру под переданной позицией и возвращает nullopt.
+    // Если подходят несколько фигур, возвращается любая из них.
+    std::optional<size_t> insert(const Figure<T>& figure, size_t position) {
+        Point<double> anchor = figureKeyAnchor(figure, eps);
+        FigureKey key = figureKeyAt(anchor, figure.getVertexCount());
+        if (std::optional<size_t> found = lookup(figure, key, anchor)) {
+            return found;
+        }
+        if ((count + 1) * 2 > slots.size()) {
+            rehash(slots.empty() ? 16 : slots.size() * 2);
+        }
+        size_t hash = FigureKeyHash{}(key);
+        Slot& slot = slots[emptySlot(hash)];
+        slot.hash = hash;
+        slot.position = position;
+        slot.offset = vertices.size();
+        slot.key = key;
+        for (size_t i = 0; i < key.vertexCount; ++i) {
+            Point<T> p = figure.getVertex(i);
+            vertices.push_back(static_cast<double>(p.x));
+            vertices.push_back(static_cast<double>(p.y));
+        }
+        ++count;
+        return std::nullopt;
+    }
+
+    std::optional<size_t> find(const Figure<T>& figure) const {
+        Point<double> anchor = figureKeyAnchor(figure, eps);
+        FigureKey key = figureKeyAt(anchor, figure.getVertexCount());
+        return lookup(figure, key, anchor);
+    }
+
+    void build(const Array<std::shared_ptr<Figure<T>>>& figures) {
+        clear();
+        reserve(figures.getSize());
+        vertices.reserve(figures.getSize() * 8);
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            insert(*figures.atUnchecked(i), i);
+        }
+    }
+
+    void clear() {
+        slots.clear();
+        vertices.clear();
+        count = 0;
+    }
+
+    size_t getSize() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    size_t memoryUsage() const {
+        return sizeof(*this) + slots.capacity() * sizeof(Slot) + vertices.capacity() * sizeof(double);
+    }
+};
+
+// Удаляет дубликаты (фигуры, совпадающие с более ранней с точностью до eps), оставляя первое вхождение.
+// Возвращает количество удаленных фигур.
+template<Scalar T>
+size_t removeDuplicates(Array<std::shared_ptr<Figure<T>>>& figures, double eps = 1e-9) {
+    FigureIndex<T> index(eps);
+    index.reserve(figures.getSize());
+
+    Array<std::shared_ptr<Figure<T>>> unique(figures.getSize());
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        if (!index.insert(*figures.atUnchecked(i), unique.getSize())) {
+            unique.pushBack(std::move(figures.atUnchecked(i)));
+        }
+    }
+
+    size_t removed = figures.getSize() - unique.getSize();
+    figures = std::move(unique);
+    return removed;
+}
+
+#endif
\ No newline at end of file
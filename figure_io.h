@@ -0,0 +1,197 @@
+#ifndef FIGURE_IO_H
+#define FIGURE_IO_H
+
+#include "figure.h"
+#include "array.h"
+#include "figure_kind.h"
+#include "figure_parser.h"
+#include <istream>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Текстовый формат коллекции: по фигуре на строку,
+// "<тег> x1 y1 x2 y2 x3 y3 x4 y4", тег S — квадрат, R — прямоугольник, T — трапеция,
+// и "P n x1 y1 ... xn yn" для многоугольника из n вершин.
+
+inline char figureKindTag(FigureKind kind) {
+    switch (kind) {
+        case FigureKind::Square:
+            return 'S';
+        case FigureKind::Rectangle:
+            return 'R';
+        case FigureKind::Trapezoid:
+            return 'T';
+        case FigureKind::Polygon:
+            return 'P';
+    }
+    throw std::invalid_argument("неизвестный тип фигуры");
+}
+
+inline FigureKind figureKindFromTag(char tag) {
+    switch (tag) {
+        case 'S':
+            return FigureKind::Square;
+        case 'R':
+            return FigureKind::Rectangle;
+        case 'T':
+            return FigureKind::Trapezoid;
+        case 'P':
+            return FigureKind::Polygon;
+    }
+    throw std::invalid_argument("неизвестный тег фигуры");
+}
+
+template<Scalar T>
+std::shared_ptr<Figure<T>> makeEmptyFigure(FigureKind kind) {
+    switch (kind) {
+        case FigureKind::Square:
+            return std::make_shared<Square<T>>();
+        case FigureKind::Rectangle:
+            return std::make_shared<Rectangle<T>>();
+        case FigureKind::Trapezoid:
+            return std::make_shared<Trapezoid<T>>();
+        case FigureKind::Polygon:
+            return std::make_shared<Polygon<T>>();
+    }
+    throw std::invalid_argument("неизвестный тип фигуры");
+}
+
+template<Scalar T>
+void writeFigure(std::ostream& outS, const Figure<T>& figure) {
+    std::streamsize oldPrecision = outS.precision(std::numeric_limits<T>::max_digits10);
+    FigureKind kind = figureKind(figure);
+    outS << figureKindTag(kind);
+    if (kind == FigureKind::Polygon) {
+        outS << ' ' << figure.getVertexCount();
+    }
+    for (size_t v = 0; v < figure.getVertexCount(); ++v) {
+        Point<T> p = figure.getVertex(v);
+        outS << ' ' << p.x << ' ' << p.y;
+    }
+    outS << '\n';
+    outS.precision(oldPrecision);
+}
+
+template<Scalar T>
+void writeFigures(std::ostream& outS, const Array<std::shared_ptr<Figure<T>>>& figures) {
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        writeFigure(outS, *figures[i]);
+    }
+}
+
+namespace detail {
+
+// Собирает фигуру из разобранных вершин. Многоугольники одного вызова чтения
+// складываются в общий пул polygons.
+template<Scalar T>
+std::shared_ptr<Figure<T>> makeParsedFigure(FigureKind kind, std::span<const Point<T>> points,
+                                            std::shared_ptr<VertexPool<T>>& polygons, size_t tagPosition) {
+    try {
+        if (kind == FigureKind::Polygon) {
+            if (!polygons) {
+                polygons = std::make_shared<VertexPool<T>>();
+            }
+            return std::make_shared<Polygon<T>>(polygons, points);
+        }
+        const Point<T> quad[4] = {points[0], points[1], points[2], points[3]};
+        return makeFigure(kind, quad);
+    } catch (const std::invalid_argument& err) {
+        throw ParseError(err.what(), tagPosition);
+    }
+}
+
+inline FigureKind parseFigureTag(char tag, size_t tagPosition) {
+    try {
+        return figureKindFromTag(tag);
+    } catch (const std::invalid_argument& err) {
+        throw ParseError(err.what(), tagPosition);
+    }
+}
+
+inline void checkPolygonSize(size_t count, size_t position) {
+    if (count < 3 || count > MaxPolygonVertices) {
+        throw ParseError("недопустимое число вершин многоугольника", position);
+    }
+}
+
+}
+
+// Синхронное чтение до конца потока. Числа разбираются тем же разбором, что и в Figure::Read,
+// фигуры проверяются конструкторами, как при вводе с клавиатуры.
+// Позиция в ParseError отсчитывается от места, с которого начато чтение потока.
+template<Scalar T>
+Array<std::shared_ptr<Figure<T>>> readFigures(std::istream& inpS) {
+    Array<std::shared_ptr<Figure<T>>> figures;
+    std::shared_ptr<VertexPool<T>> polygons;
+    std::vector<T> values;
+    std::vector<Point<T>> points;
+    std::streambuf* source = inpS.rdbuf();
+    if (!inpS || source == nullptr) {
+        return figures;
+    }
+    size_t offset = 0;
+    while (true) {
+        int c = skipStreamSpaces(source, offset);
+        if (c == std::char_traits<char>::eof()) {
+            inpS.setstate(std::ios::eofbit);
+            break;
+        }
+        size_t tagPosition = offset++;
+        source->sbumpc();
+        FigureKind kind = detail::parseFigureTag(static_cast<char>(c), tagPosition);
+        size_t count = 4;
+        if (kind == FigureKind::Polygon) {
+            skipStreamSpaces(source, offset);
+            size_t countPosition = offset;
+            readNumbers(inpS, &count, 1, offset);
+            detail::checkPolygonSize(count, countPosition);
+        }
+        values.resize(2 * count);
+        readNumbers(inpS, values.data(), values.size(), offset);
+        points.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            points[i] = Point<T>(values[2 * i], values[2 * i + 1]);
+        }
+        figures.pushBack(detail::makeParsedFigure<T>(kind, points, polygons, tagPosition));
+    }
+    return figures;
+}
+
+// Разбор коллекции прямо из памяти без потоков и промежуточных строк.
+// Позиция в ParseError отсчитывается от начала text.
+template<Scalar T>
+Array<std::shared_ptr<Figure<T>>> parseFigures(std::string_view text) {
+    Array<std::shared_ptr<Figure<T>>> figures;
+    std::shared_ptr<VertexPool<T>> polygons;
+    std::vector<Point<T>> points;
+    size_t pos = 0;
+    skipSpaces(text, pos);
+    while (pos < text.size()) {
+        size_t tagPosition = pos++;
+        FigureKind kind = detail::parseFigureTag(text[tagPosition], tagPosition);
+        if (kind == FigureKind::Polygon) {
+            size_t countPosition = pos;
+            size_t count = parseNumber<size_t>(text, pos);
+            detail::checkPolygonSize(count, countPosition);
+            points.resize(count);
+            for (Point<T>& p : points) {
+                p.x = parseNumber<T>(text, pos);
+                p.y = parseNumber<T>(text, pos);
+            }
+            figures.pushBack(detail::makeParsedFigure<T>(kind, points, polygons, tagPosition));
+        } else {
+            Point<T> quad[4];
+            parsePoints(text, pos, quad, 4);
+            figures.pushBack(detail::makeParsedFigure<T>(kind, quad, polygons, tagPosition));
+        }
+        skipSpaces(text, pos);
+    }
+    return figures;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,424 @@
+#ifndef FIGURE_JOURNAL_H
+#define FIGURE_JOURNAL_H
+
+#include "figure.h"
+#include "array.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+enum class JournalOp : uint8_t {
+    PushBack,
+    Remove,
+    Clear,
+    Append
+};
+
+// Журнал изменений коллекции фигур с отменой и повтором.
+//
+// Все изменения коллекции должны идти через журнал. Каждое изменение хранится
+// как небольшая запись: фигуры не копируются, запись держит shared_ptr на добавленную
+// или удаленную фигуру, а clear переносит весь буфер коллекции в запись за O(1).
+// Поэтому память журнала растет с числом изменений, а не с размером коллекции.
+// Отмена и повтор стоят столько же, сколько исходная операция: O(1) для pushBack
+// и clear, сдвиг хвоста для remove, число фигур для append.
+//
+// Версия — число примененных записей. checkout переходит к любой версии; при
+// checkpointInterval > 0 каждые checkpointInterval записей сохраняется разностный
+// снимок: чем коллекция в конце отрезка отличается от начала (куски начального
+// состояния, дожившие добавленные фигуры и удаленные фигуры начального состояния).
+// Снимок занимает память по числу изменений в отрезке, а переход через весь отрезок
+// стоит одного прохода по коллекции вместо повтора его записей, например сдвигов remove.
+//
+// Наблюдатель (например, долговременное хранилище) получает каждое изменение коллекции:
+// операцию, признак отмены, индекс для remove и число фигур для append.
+// Clear с reverted = true означает, что коллекция заменена целиком. Исключение
+// наблюдателя отменяет изменение: коллекция и журнал остаются прежними.
+template<Scalar T>
+class FigureJournal {
+public:
+    using Figures = Array<std::shared_ptr<Figure<T>>>;
+    using Observer = std::function<void(JournalOp op, bool reverted, size_t index, size_t count)>;
+
+private:
+    struct Record {
+        JournalOp op;
+        size_t index;
+        std::shared_ptr<Figure<T>> figure;
+        std::unique_ptr<Figures> figures;
+    };
+
+    // count фигур подряд: из added снимка (inserted) или из начального состояния отрезка.
+    struct Piece {
+        bool inserted;
+        size_t start;
+        size_t count;
+    };
+
+    // Разностный снимок отрезка записей [i, i + 1) * checkpointInterval. Фигуры начального
+    // состояния, дожившие до конца, идут в конечном состоянии в прежнем порядке.
+    struct Delta {
+        size_t fromSize;
+        size_t toSize;
+        // Оценка стоимости повтора записей отрезка (число перемещаемых указателей).
+        size_t replayCost;
+        bool hasClear;
+        std::vector<Piece> pieces;
+        std::vector<std::shared_ptr<Figure<T>>> added;
+        // Позиция в начальном состоянии и фигура, по возрастанию позиции.
+        std::vector<std::pair<size_t, std::shared_ptr<Figure<T>>>> removed;
+    };
+
+    Figures& figures;
+    std::vector<Record> records;
+    size_t applied = 0;
+    size_t checkpointInterval;
+    size_t initialSize;
+    std::vector<Delta> deltas;
+    Observer observer;
+
+    void notify(JournalOp op, bool reverted, const Record& record) {
+        if (observer) {
+            observer(op, reverted, record.index, record.figures ? record.figures->getSize() : 1);
+        }
+    }
+
+    void change(Record& record) {
+        switch (record.op) {
+            case JournalOp::PushBack:
+                figures.pushBack(record.figure);
+                break;
+            case JournalOp::Remove:
+                figures.remove(record.index);
+                break;
+            case JournalOp::Clear:
+                *record.figures = std::move(figures);
+                figures = Figures();
+                break;
+            case JournalOp::Append:
+                for (size_t i = 0; i < record.figures->getSize(); ++i) {
+                    figures.pushBack((*record.figures)[i]);
+                }
+                break;
+        }
+    }
+
+    void unchange(Record& record) {
+        switch (record.op) {
+            case JournalOp::PushBack:
+                figures.remove(figures.getSize() - 1);
+                break;
+            case JournalOp::Remove:
+                figures.insert(record.index, record.figure);
+                break;
+            case JournalOp::Clear:
+                figures = std::move(*record.figures);
+                break;
+            case JournalOp::Append:
+                for (size_t i = 0; i < record.figures->getSize(); ++i) {
+                    figures.remove(figures.getSize() - 1);
+                }
+                break;
+        }
+    }
+
+    // Если наблюдатель отверг изменение, коллекция возвращается в прежнее состояние,
+    // чтобы она не разошлась с наблюдателем (и с журналом).
+    void apply(Record& record) {
+        change(record);
+        try {
+            notify(record.op, false, record);
+        } catch (...) {
+            unchange(record);
+            throw;
+        }
+    }
+
+    void revert(Record& record) {
+        unchange(record);
+        try {
+            notify(record.op, true, record);
+        } catch (...) {
+            change(record);
+            throw;
+        }
+    }
+
+    static void addPieces(std::vector<Piece>& pieces, size_t start, size_t count) {
+        if (!pieces.empty() && pieces.back().inserted && pieces.back().start + pieces.back().count == start) {
+            pieces.back().count += count;
+        } else {
+            pieces.push_back(Piece{true, start, count});
+        }
+    }
+
+    // Строит снимок последнего отрезка, когда все его записи применены (applied на границе).
+    void takeCheckpoint() {
+        size_t from = applied - checkpointInterval;
+        Delta delta{deltas.empty() ? initialSize : deltas.back().toSize, figures.getSize(), 0, false, {}, {}, {}};
+        std::vector<Piece> pieces;
+        if (delta.fromSize > 0) {
+            pieces.push_back(Piece{false, 0, delta.fromSize});
+        }
+        std::vector<std::shared_ptr<Figure<T>>> inserted;
+        size_t size = delta.fromSize;
+        for (size_t r = from; r < applied; ++r) {
+            const Record& record = records[r];
+            switch (record.op) {
+                case JournalOp::PushBack:
+                    inserted.push_back(record.figure);
+                    addPieces(pieces, inserted.size() - 1, 1);
+                    ++size;
+                    ++delta.replayCost;
+                    break;
+                case JournalOp::Append:
+                    for (size_t i = 0; i < record.figures->getSize(); ++i) {
+                        inserted.push_back((*record.figures)[i]);
+                    }
+                    addPieces(pieces, inserted.size() - record.figures->getSize(), record.figures->getSize());
+                    size += record.figures->getSize();
+                    delta.replayCost += record.figures->getSize();
+                    break;
+                case JournalOp::Remove: {
+                    size_t k = 0;
+                    size_t offset = record.index;
+                    while (offset >= pieces[k].count) {
+                        offset -= pieces[k++].count;
+                    }
+                    Piece piece = pieces[k];
+                    if (!piece.inserted) {
+                        delta.removed.emplace_back(piece.start + offset, record.figure);
+                    }
+                    Piece parts[2] = {Piece{piece.inserted, piece.start, offset},
+                                      Piece{piece.inserted, piece.start + offset + 1, piece.count - offset - 1}};
+                    pieces.erase(pieces.begin() + static_cast<std::ptrdiff_t>(k));
+                    for (const Piece& part : parts) {
+                        if (part.count > 0) {
+                            pieces.insert(pieces.begin() + static_cast<std::ptrdiff_t>(k++), part);
+                        }
+                    }
+                    delta.replayCost += size - record.index;
+                    --size;
+                    break;
+                }
+                case JournalOp::Clear: {
+                    // Примененная запись clear держит коллекцию на момент очистки.
+                    size_t position = 0;
+                    for (const Piece& piece : pieces) {
+                        for (size_t i = 0; !piece.inserted && i < piece.count; ++i) {
+                            delta.removed.emplace_back(piece.start + i, (*record.figures)[position + i]);
+                        }
+                        position += piece.count;
+                    }
+                    pieces.clear();
+                    size = 0;
+                    delta.hasClear = true;
+                    ++delta.replayCost;
+                    break;
+                }
+            }
+        }
+        for (Piece& piece : pieces) {
+            if (piece.inserted) {
+                size_t start = delta.added.size();
+                delta.added.insert(delta.added.end(), inserted.begin() + static_cast<std::ptrdiff_t>(piece.start),
+                                   inserted.begin() + static_cast<std::ptrdiff_t>(piece.start + piece.count));
+                piece.start = start;
+            }
+        }
+        delta.pieces = std::move(pieces);
+        std::sort(delta.removed.begin(), delta.removed.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        deltas.push_back(std::move(delta));
+    }
+
+    static Figures forwardState(const Figures& current, const Delta& delta) {
+        Figures next(delta.toSize);
+        for (const Piece& piece : delta.pieces) {
+            for (size_t i = piece.start; i < piece.start + piece.count; ++i) {
+                next.pushBack(piece.inserted ? delta.added[i] : current[i]);
+            }
+        }
+        return next;
+    }
+
+    static Figures backwardState(const Figures& current, const Delta& delta) {
+        Figures previous(delta.fromSize);
+        auto removed = delta.removed.begin();
+        size_t position = 0;
+        for (const Piece& piece : delta.pieces) {
+            if (!piece.inserted) {
+                for (; removed != delta.removed.end() && removed->first < piece.start; ++removed) {
+                    previous.pushBack(removed->second);
+                }
+                for (size_t i = 0; i < piece.count; ++i) {
+                    previous.pushBack(current[position + i]);
+                }
+            }
+            position += piece.count;
+        }
+        for (; removed != delta.removed.end(); ++removed) {
+            previous.pushBack(removed->second);
+        }
+        return previous;
+    }
+
+    // Переход через отрезок по снимку. Наблюдатель получает замену коллекции целиком;
+    // если он ее отверг, коллекция возвращается к прежней.
+    void jump(const Delta& delta, bool forward) {
+        size_t target = forward ? applied + checkpointInterval : applied - checkpointInterval;
+        Figures next = forward ? forwardState(figures, delta) : backwardState(figures, delta);
+        Figures previous = std::move(figures);
+        figures = std::move(next);
+        try {
+            if (observer) {
+                observer(JournalOp::Clear, true, 0, figures.getSize());
+            }
+        } catch (...) {
+            figures = std::move(previous);
+            throw;
+        }
+        // Буферы пропущенных назад записей clear больше не нужны: повтор заполнит их заново.
+        for (size_t i = target; i < applied; ++i) {
+            if (records[i].op == JournalOp::Clear) {
+                *records[i].figures = Figures();
+            }
+        }
+        applied = target;
+    }
+
+    bool worthJumping(const Delta& delta) const { return delta.replayCost > delta.fromSize + delta.toSize; }
+
+    void commit(Record record) {
+        apply(record);
+        // Новая ветка истории отбрасывает все, что можно было повторить.
+        records.erase(records.begin() + static_cast<std::ptrdiff_t>(applied), records.end());
+        if (checkpointInterval > 0) {
+            deltas.resize(applied / checkpointInterval);
+        }
+        records.push_back(std::move(record));
+        ++applied;
+        if (checkpointInterval > 0 && applied % checkpointInterval == 0) {
+            takeCheckpoint();
+        }
+    }
+
+public:
+    explicit FigureJournal(Figures& target, size_t checkpointInterval = 0)
+        : figures(target), checkpointInterval(checkpointInterval), initialSize(target.getSize()) {}
+
+    FigureJournal(const FigureJournal&) = delete;
+    FigureJournal& operator=(const FigureJournal&) = delete;
+
+    void pushBack(std::shared_ptr<Figure<T>> figure) {
+        commit(Record{JournalOp::PushBack, 0, std::move(figure), nullptr});
+    }
+
+    void remove(size_t index) {
+        commit(Record{JournalOp::Remove, index, figures[index], nullptr});
+    }
+
+    void clear() {
+        commit(Record{JournalOp::Clear, 0, nullptr, std::make_unique<Figures>()});
+    }
+
+    // Добавляет весь батч одной записью: он отменяется и повторяется целиком.
+    void append(Figures&& batch) {
+        commit(Record{JournalOp::Append, 0, nullptr, std::make_unique<Figures>(std::move(batch))});
+    }
+
+    void setObserver(Observer callback) { observer = std::move(callback); }
+
+    bool canUndo() const { return applied > 0; }
+    bool canRedo() const { return applied < records.size(); }
+
+    void undo() {
+        if (!canUndo()) {
+            throw std::logic_error("нечего отменять");
+        }
+        revert(records[applied - 1]);
+        --applied;
+    }
+
+    void redo() {
+        if (!canRedo()) {
+            throw std::logic_error("нечего повторять");
+        }
+        apply(records[applied]);
+        ++applied;
+    }
+
+    // Переход к версии от 0 (до первой записи) до getRecordCount(). Целые отрезки
+    // между снимками проходятся по снимку, если это дешевле повтора их записей;
+    // вперед — только отрезки без clear, чтобы записи clear получили свое содержимое.
+    void checkout(size_t version) {
+        if (version > records.size()) {
+            throw std::out_of_range("Index out of range");
+        }
+        size_t step = checkpointInterval;
+        if (step > 0 && version + step <= applied) {
+            while (applied % step != 0) {
+                undo();
+            }
+            while (applied >= version + step) {
+                const Delta& delta = deltas[applied / step - 1];
+                if (worthJumping(delta)) {
+                    jump(delta, false);
+                } else {
+                    for (size_t i = 0; i < step; ++i) {
+                        undo();
+                    }
+                }
+            }
+        } else if (step > 0 && applied + step <= version) {
+            while (applied % step != 0) {
+                redo();
+            }
+            while (applied + step <= version) {
+                const Delta& delta = deltas[applied / step];
+                if (!delta.hasClear && worthJumping(delta)) {
+                    jump(delta, true);
+                } else {
+                    for (size_t i = 0; i < step; ++i) {
+                        redo();
+                    }
+                }
+            }
+        }
+        while (applied < version) {
+            redo();
+        }
+        while (applied > version) {
+            undo();
+        }
+    }
+
+    size_t getVersion() const { return applied; }
+    size_t getRecordCount() const { return records.size(); }
+    size_t getCheckpointCount() const { return deltas.size(); }
+    const Figures& getFigures() const { return figures; }
+
+    // Память самого журнала: записи, буферы, перенесенные в записи clear и append,
+    // и разностные снимки. Сами фигуры общие с коллекцией и не учитываются.
+    size_t memoryUsage() const {
+        size_t bytes = sizeof(*this) + records.capacity() * sizeof(Record);
+        for (const Record& record : records) {
+            if (record.figures) {
+                bytes += heapBlockSize(sizeof(Figures)) + record.figures->memoryUsage() - sizeof(Figures);
+            }
+        }
+        bytes += deltas.capacity() * sizeof(Delta);
+        for (const Delta& delta : deltas) {
+            bytes += delta.pieces.capacity() * sizeof(Piece) +
+                     delta.added.capacity() * sizeof(std::shared_ptr<Figure<T>>) +
+                     delta.removed.capacity() * sizeof(std::pair<size_t, std::shared_ptr<Figure<T>>>);
+        }
+        return bytes;
+    }
+};
+
+#endif
\ No newline at end of file
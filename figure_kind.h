@@ -0,0 +1,54 @@
+#ifndef FIGURE_KIND_H
+#define FIGURE_KIND_H
+
+#include "figure.h"
+#include "square.h"
+#include "rectangle.h"
+#include "trapez.h"
+#include "polygon.h"
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+enum class FigureKind : uint8_t {
+    Square = 0,
+    Rectangle = 1,
+    Trapezoid = 2,
+    Polygon = 3
+};
+
+constexpr size_t FigureKindCount = 4;
+
+template<Scalar T>
+FigureKind figureKind(const Figure<T>& figure) {
+    if (dynamic_cast<const Square<T>*>(&figure)) {
+        return FigureKind::Square;
+    }
+    if (dynamic_cast<const Rectangle<T>*>(&figure)) {
+        return FigureKind::Rectangle;
+    }
+    if (dynamic_cast<const Trapezoid<T>*>(&figure)) {
+        return FigureKind::Trapezoid;
+    }
+    if (dynamic_cast<const Polygon<T>*>(&figure)) {
+        return FigureKind::Polygon;
+    }
+    throw std::invalid_argument("неизвестный тип фигуры");
+}
+
+template<Scalar T>
+std::shared_ptr<Figure<T>> makeFigure(FigureKind kind, const Point<T> (&points)[4]) {
+    switch (kind) {
+        case FigureKind::Square:
+            return std::make_shared<Square<T>>(points[0], points[1], points[2], points[3]);
+        case FigureKind::Rectangle:
+            return std::make_shared<Rectangle<T>>(points[0], points[1], points[2], points[3]);
+        case FigureKind::Trapezoid:
+            return std::make_shared<Trapezoid<T>>(points[0], points[1], points[2], points[3]);
+        case FigureKind::Polygon:
+            return std::make_shared<Polygon<T>>(std::span<const Point<T>>(points, 4));
+    }
+    throw std::invalid_argument("неизвестный тип фигуры");
+}
+
+#endif
\ No newline at end of file
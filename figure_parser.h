@@ -0,0 +1,184 @@
+#ifndef FIGURE_PARSER_H
+#define FIGURE_PARSER_H
+
+#include "point.h"
+#include <charconv>
+#include <cmath>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+// Ошибка разбора с позицией (смещение в байтах от начала разбираемого текста).
+class ParseError : public std::runtime_error {
+private:
+    std::string text;
+    size_t pos;
+
+public:
+    ParseError(const std::string& message, size_t position)
+        : std::runtime_error(message + " (позиция " + std::to_string(position) + ")"), text(message), pos(position) {}
+
+    size_t position() const { return pos; }
+    const std::string& reason() const { return text; }
+};
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline void skipSpaces(std::string_view text, size_t& pos) {
+    while (pos < text.size() && isSpace(text[pos])) {
+        ++pos;
+    }
+}
+
+// Разбирает одно число начиная с pos (ведущие пробелы пропускаются) и сдвигает pos за него.
+// Число должно заканчиваться пробелом или концом текста. Память не выделяется.
+template<Scalar T>
+T parseNumber(std::string_view text, size_t& pos) {
+    static_assert(std::is_arithmetic_v<T>, "разбираются только арифметические типы");
+
+    skipSpaces(text, pos);
+    if (pos >= text.size()) {
+        throw ParseError("неожиданный конец ввода", pos);
+    }
+
+    size_t start = pos;
+    const char* first = text.data() + pos;
+    const char* last = text.data() + text.size();
+    // from_chars не принимает явный плюс, а operator>> принимает
+    if (*first == '+' && first + 1 < last && *(first + 1) != '-' && *(first + 1) != '+') {
+        ++first;
+    }
+
+    T value{};
+    std::from_chars_result result = std::from_chars(first, last, value);
+    if (result.ec == std::errc::result_out_of_range) {
+        throw ParseError("число вне диапазона", start);
+    }
+    if (result.ec != std::errc() || (result.ptr < last && !isSpace(*result.ptr))) {
+        throw ParseError("ожидалось число", start);
+    }
+    if constexpr (std::is_floating_point_v<T>) {
+        if (!std::isfinite(value)) {
+            throw ParseError("ожидалось конечное число", start);
+        }
+    }
+    pos = static_cast<size_t>(result.ptr - text.data());
+    return value;
+}
+
+// Разбирает count точек "x y" подряд. Результат пишется в out только при успехе.
+template<Scalar T>
+void parsePoints(std::string_view text, size_t& pos, Point<T>* out, size_t count) {
+    constexpr size_t MaxPoints = 64;
+    if (count > MaxPoints) {
+        throw std::invalid_argument("слишком много точек");
+    }
+    T values[2 * MaxPoints];
+    size_t cursor = pos;
+    for (size_t i = 0; i < 2 * count; ++i) {
+        values[i] = parseNumber<T>(text, cursor);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = Point<T>(values[2 * i], values[2 * i + 1]);
+    }
+    pos = cursor;
+}
+
+// Пропускает пробельные символы потока, не забирая следующий символ, и прибавляет
+// их число к offset. Возвращает следующий символ или eof.
+inline int skipStreamSpaces(std::streambuf* source, size_t& offset) {
+    int c = source->sgetc();
+    while (c != std::char_traits<char>::eof() && isSpace(static_cast<char>(c))) {
+        ++offset;
+        c = source->snextc();
+    }
+    return c;
+}
+
+// Читает из потока count чисел тем же разбором, что и parseNumber. Каждое слово
+// копируется в буфер на стеке и разбирается сразу, поэтому чтение останавливается
+// на первом ошибочном слове и не зависит от локали; память выделяется только для
+// слов длиннее буфера (например, чисел с очень длинной мантиссой).
+// offset — число байт, уже прочитанных до вызова: позиция в ParseError — это
+// offset плюс настоящее смещение ошибки от точки вызова, с учетом всех пробелов,
+// табуляций и переводов строк. После успешного чтения offset сдвигается за последнее число.
+// При ошибке поток возвращается на позицию вызова, если он это поддерживает,
+// и получает failbit.
+template<Scalar T>
+void readNumbers(std::istream& inpS, T* values, size_t count, size_t& offset) {
+    constexpr size_t MaxToken = 64;
+    char token[MaxToken];
+    std::string longToken;
+    size_t consumed = offset;
+
+    std::istream::pos_type start = inpS.tellg();
+    auto fail = [&](const ParseError& error) {
+        inpS.clear();
+        if (start != std::istream::pos_type(-1)) {
+            inpS.seekg(start);
+        }
+        inpS.setstate(std::ios::failbit);
+        throw error;
+    };
+
+    std::streambuf* source = inpS.rdbuf();
+    if (!inpS || source == nullptr) {
+        fail(ParseError("поток недоступен для чтения", consumed));
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        int c = skipStreamSpaces(source, consumed);
+        if (c == std::char_traits<char>::eof()) {
+            inpS.setstate(std::ios::eofbit);
+            fail(ParseError("неожиданный конец ввода", consumed));
+        }
+
+        size_t length = 0;
+        longToken.clear();
+        while (c != std::char_traits<char>::eof() && !isSpace(static_cast<char>(c))) {
+            if (length < MaxToken) {
+                token[length] = static_cast<char>(c);
+            } else {
+                if (length == MaxToken) {
+                    longToken.assign(token, MaxToken);
+                }
+                longToken.push_back(static_cast<char>(c));
+            }
+            ++length;
+            c = source->snextc();
+        }
+        std::string_view word = length <= MaxToken ? std::string_view(token, length) : std::string_view(longToken);
+        try {
+            size_t pos = 0;
+            values[i] = parseNumber<T>(word, pos);
+        } catch (const ParseError& error) {
+            fail(ParseError(error.reason(), consumed + error.position()));
+        }
+        consumed += length;
+    }
+    offset = consumed;
+}
+
+// Позиции ошибок отсчитываются от точки вызова.
+template<Scalar T>
+void readNumbers(std::istream& inpS, T* values, size_t count) {
+    size_t offset = 0;
+    readNumbers(inpS, values, count, offset);
+}
+
+// Читает N точек "x y" через readNumbers.
+template<Scalar T, size_t N>
+void readPoints(std::istream& inpS, Point<T> (&out)[N]) {
+    T values[2 * N];
+    readNumbers(inpS, values, 2 * N);
+    for (size_t i = 0; i < N; ++i) {
+        out[i] = Point<T>(values[2 * i], values[2 * i + 1]);
+    }
+}
+
+#endif
\ No newline at end of file
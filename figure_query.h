@@ -0,0 +1,176 @@
+#ifndef FIGURE_QUERY_H
+#define FIGURE_QUERY_H
+
+#include "figure.h"
+#include "array.h"
+#include <cstddef>
+#include <memory>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+// Фигура под ленивым преобразованием p -> p * scale + offset: исходная фигура не копируется,
+// вершины, центр и площадь пересчитываются при обращении. Живет не дольше исходной фигуры.
+template<Scalar T>
+class TransformedFigure {
+private:
+    const Figure<T>* figure;
+    T scale;
+    Point<T> offset;
+
+    Point<T> apply(const Point<T>& p) const {
+        return Point<T>(p.x * scale + offset.x, p.y * scale + offset.y);
+    }
+
+public:
+    TransformedFigure(const Figure<T>& source, T factor, const Point<T>& shift)
+        : figure(&source), scale(factor), offset(shift) {}
+
+    // Сначала это преобразование, затем p -> p * factor + shift.
+    TransformedFigure then(T factor, const Point<T>& shift) const {
+        return TransformedFigure(*figure, scale * factor,
+                                 Point<T>(offset.x * factor + shift.x, offset.y * factor + shift.y));
+    }
+
+    // Центр — среднее вершин, а среднее при аффинном преобразовании переходит в образ среднего.
+    Point<T> Center() const { return apply(figure->Center()); }
+    T area() const { return figure->area() * scale * scale; }
+    size_t getVertexCount() const { return figure->getVertexCount(); }
+    Point<T> getVertex(size_t index) const { return apply(figure->getVertex(index)); }
+    explicit operator double() const { return static_cast<double>(area()); }
+
+    const Figure<T>& source() const { return *figure; }
+};
+
+namespace detail {
+
+template<typename E>
+struct IsPoint : std::false_type {};
+
+template<Scalar T>
+struct IsPoint<Point<T>> : std::true_type {};
+
+}
+
+// Ленивый запрос над диапазоном: filter, map, ofType и transform только надстраивают
+// адаптеры std::views, а проход по коллекции и вызовы функций случаются один раз
+// в свертке (count, sum, reduce, forEach) или при обходе самого запроса.
+// Промежуточных коллекций и копий shared_ptr нет. Query — это std::ranges::view,
+// поэтому его можно передавать в алгоритмы std::ranges и продолжать адаптерами std::views.
+// Как и в std::views, map перед filter вычисляет функцию map дважды для прошедших фильтр
+// элементов, поэтому дорогие проекции лучше ставить после фильтров.
+template<std::ranges::view V>
+class Query : public std::ranges::view_interface<Query<V>> {
+private:
+    V base;
+
+    template<std::ranges::view W>
+    static Query<W> wrap(W view) {
+        return Query<W>(std::move(view));
+    }
+
+public:
+    Query() requires std::default_initializable<V> = default;
+    explicit Query(V view) : base(std::move(view)) {}
+
+    auto begin() { return std::ranges::begin(base); }
+    auto end() { return std::ranges::end(base); }
+
+    // Адаптеры надстраиваются над копией: filter_view обходится только неконстантным,
+    // а копия представления стоит несколько указателей.
+    template<typename Predicate>
+    auto filter(Predicate predicate) const {
+        return wrap(V(base) | std::views::filter(std::move(predicate)));
+    }
+
+    template<typename Function>
+    auto map(Function function) const {
+        return wrap(V(base) | std::views::transform(std::move(function)));
+    }
+
+    // Только фигуры типа F, уже как const F&.
+    template<typename F>
+    auto ofType() const {
+        return filter([](const auto& figure) { return dynamic_cast<const F*>(&figure) != nullptr; })
+            .map([](const auto& figure) -> const F& { return static_cast<const F&>(figure); });
+    }
+
+    // Аффинное преобразование p -> p * factor + (dx, dy); несколько подряд сливаются в одно.
+    template<Scalar T>
+    auto transform(T factor, T dx, T dy) const {
+        return map([factor, dx, dy](const auto& figure) {
+            if constexpr (requires { figure.then(factor, Point<T>(dx, dy)); }) {
+                return figure.then(factor, Point<T>(dx, dy));
+            } else {
+                return TransformedFigure<T>(figure, factor, Point<T>(dx, dy));
+            }
+        });
+    }
+
+    template<Scalar T>
+    auto translate(T dx, T dy) const {
+        return transform(T(1), dx, dy);
+    }
+
+    template<typename Function>
+    void forEach(Function function) {
+        for (auto&& element : base) {
+            function(element);
+        }
+    }
+
+    template<typename R, typename Reduce>
+    R reduce(R init, Reduce op) {
+        for (auto&& element : base) {
+            init = op(std::move(init), element);
+        }
+        return init;
+    }
+
+    size_t count() {
+        size_t total = 0;
+        for (auto&& element : base) {
+            static_cast<void>(element);
+            ++total;
+        }
+        return total;
+    }
+
+    // Сумма чисел в double или точек покоординатно в Point<double>.
+    auto sum() {
+        using E = std::remove_cvref_t<std::ranges::range_reference_t<V>>;
+        if constexpr (detail::IsPoint<E>::value) {
+            double x = 0.0, y = 0.0;
+            for (auto&& p : base) {
+                x += static_cast<double>(p.x);
+                y += static_cast<double>(p.y);
+            }
+            return Point<double>(x, y);
+        } else {
+            double total = 0.0;
+            for (auto&& value : base) {
+                total += static_cast<double>(value);
+            }
+            return total;
+        }
+    }
+
+    template<typename Function>
+    auto sum(Function function) {
+        return map(std::move(function)).sum();
+    }
+};
+
+template<std::ranges::viewable_range R>
+Query(R&&) -> Query<std::views::all_t<R>>;
+
+// Запрос по коллекции фигур; элементы — const Figure<T>&.
+template<Scalar T>
+auto query(const Array<std::shared_ptr<Figure<T>>>& figures) {
+    return Query(std::views::all(figures) |
+                 std::views::transform([](const std::shared_ptr<Figure<T>>& figure) -> const Figure<T>& {
+                     return *figure;
+                 }));
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,846 @@
+#ifndef FIGURE_SERVER_H
+#define FIGURE_SERVER_H
+
+#include "figure.h"
+#include "figure_kind.h"
+#include "bounding_box.h"
+#include "aggregate_array.h"
+#include "workload.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Двоичный протокол сервера фигур. Кадр — [u32 длина][u32 число команд][команды],
+// длина считает байты после себя. Числа в порядке байтов хоста: сервер только локальный.
+// Команды:  Add    [u8 1][u8 вид][8 x f64 координаты вершин]
+//           Remove [u8 2][u64 индекс]
+//           Total  [u8 3]
+//           Range  [u8 4][4 x f64 minX minY maxX maxY]
+// Ответ — кадр того же вида, на каждую команду [u8 статус] и при успехе 8 байт:
+// Add — u64 индекс фигуры, Remove — u64 число фигур после удаления, Total — f64 площадь,
+// Range — u64 число фигур с пересекающим окно прямоугольником; при ошибке — [u16 длина][текст].
+// Пакет изолирован, но не атомарен: другие клиенты не видят его промежуточных состояний,
+// однако ошибка команды не отменяет остальные — команды до и после нее остаются выполненными.
+enum class ServerCommand : uint8_t {
+    Add = 1,
+    Remove = 2,
+    Total = 3,
+    Range = 4
+};
+
+enum class ServerStatus : uint8_t {
+    Ok = 0,
+    Error = 1
+};
+
+constexpr uint32_t MaxServerFrameBytes = 64u << 20;
+// Сколько неотправленных ответов копится на соединение, прежде чем сервер перестает читать запросы.
+constexpr size_t MaxServerPendingBytes = 1u << 20;
+
+namespace detail {
+
+[[noreturn]] inline void throwSocketError(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+template<typename V>
+void appendValue(std::vector<char>& out, V value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(V));
+}
+
+// Чтение значений кадра с проверкой границ: обрыв кадра — ошибка протокола.
+class FrameReader {
+private:
+    const char* data;
+    size_t size;
+    size_t pos = 0;
+
+public:
+    FrameReader(const char* bytes, size_t length) : data(bytes), size(length) {}
+
+    template<typename V>
+    V read() {
+        if (size - pos < sizeof(V)) {
+            throw std::runtime_error("обрезанный кадр");
+        }
+        V value;
+        std::memcpy(&value, data + pos, sizeof(V));
+        pos += sizeof(V);
+        return value;
+    }
+
+    std::string readString(size_t length) {
+        if (size - pos < length) {
+            throw std::runtime_error("обрезанный кадр");
+        }
+        std::string text(data + pos, length);
+        pos += length;
+        return text;
+    }
+
+    bool atEnd() const { return pos == size; }
+};
+
+inline void sendAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = ::send(fd, data, length, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throwSocketError("ошибка отправки");
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+}
+
+inline void receiveAll(int fd, char* data, size_t length) {
+    while (length > 0) {
+        ssize_t got = ::recv(fd, data, length, 0);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throwSocketError("ошибка приема");
+        }
+        if (got == 0) {
+            throw std::runtime_error("соединение закрыто");
+        }
+        data += got;
+        length -= static_cast<size_t>(got);
+    }
+}
+
+}
+
+// Адрес сервера: "unix:/путь/к/сокету" или "tcp:порт" (только 127.0.0.1).
+struct ServerAddress {
+    bool local = true;
+    std::string path;
+    uint16_t port = 0;
+
+    static ServerAddress parse(const std::string& text) {
+        ServerAddress address;
+        if (text.rfind("unix:", 0) == 0 && text.size() > 5) {
+            address.path = text.substr(5);
+            if (address.path.size() >= sizeof(sockaddr_un::sun_path)) {
+                throw std::invalid_argument("слишком длинный путь сокета");
+            }
+            return address;
+        }
+        if (text.rfind("tcp:", 0) == 0) {
+            unsigned long port = std::stoul(text.substr(4));
+            if (port > 65535) {
+                throw std::invalid_argument("недопустимый порт");
+            }
+            address.local = false;
+            address.port = static_cast<uint16_t>(port);
+            return address;
+        }
+        throw std::invalid_argument("адрес должен быть unix:<путь> или tcp:<порт>");
+    }
+
+    int socketFamily() const { return local ? AF_UNIX : AF_INET; }
+
+    socklen_t fill(sockaddr_storage& storage) const {
+        std::memset(&storage, 0, sizeof(storage));
+        if (local) {
+            auto* un = reinterpret_cast<sockaddr_un*>(&storage);
+            un->sun_family = AF_UNIX;
+            std::memcpy(un->sun_path, path.c_str(), path.size() + 1);
+            return sizeof(sockaddr_un);
+        }
+        auto* in = reinterpret_cast<sockaddr_in*>(&storage);
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return sizeof(sockaddr_in);
+    }
+};
+
+// Пакет команд клиента.
+class RequestBatch {
+private:
+    std::vector<char> bytes = std::vector<char>(8);
+    std::vector<ServerCommand> ops;
+
+public:
+    template<Scalar T>
+    void add(FigureKind kind, const Point<T> (&points)[4]) {
+        detail::appendValue(bytes, ServerCommand::Add);
+        detail::appendValue(bytes, static_cast<uint8_t>(kind));
+        for (const Point<T>& p : points) {
+            detail::appendValue(bytes, static_cast<double>(p.x));
+            detail::appendValue(bytes, static_cast<double>(p.y));
+        }
+        ops.push_back(ServerCommand::Add);
+    }
+
+    template<Scalar T>
+    void add(const Figure<T>& figure) {
+        if (figure.getVertexCount() != 4) {
+            throw std::invalid_argument("по протоколу передаются только четырехугольники");
+        }
+        Point<T> points[4];
+        for (size_t v = 0; v < 4; ++v) {
+            points[v] = figure.getVertex(v);
+        }
+        add(figureKind(figure), points);
+    }
+
+    void remove(uint64_t index) {
+        detail::appendValue(bytes, ServerCommand::Remove);
+        detail::appendValue(bytes, index);
+        ops.push_back(ServerCommand::Remove);
+    }
+
+    void total() {
+        detail::appendValue(bytes, ServerCommand::Total);
+        ops.push_back(ServerCommand::Total);
+    }
+
+    template<Scalar T>
+    void range(const BoundingBox<T>& box) {
+        detail::appendValue(bytes, ServerCommand::Range);
+        for (T value : {box.minX, box.minY, box.maxX, box.maxY}) {
+            detail::appendValue(bytes, static_cast<double>(value));
+        }
+        ops.push_back(ServerCommand::Range);
+    }
+
+    // Готовый кадр; пакет можно продолжать пополнять.
+    const std::vector<char>& frame() {
+        uint32_t length = static_cast<uint32_t>(bytes.size() - 4);
+        uint32_t count = static_cast<uint32_t>(ops.size());
+        std::memcpy(bytes.data(), &length, 4);
+        std::memcpy(bytes.data() + 4, &count, 4);
+        return bytes;
+    }
+
+    void clear() {
+        bytes.resize(8);
+        ops.clear();
+    }
+
+    const std::vector<ServerCommand>& getCommands() const { return ops; }
+    size_t getCount() const { return ops.size(); }
+};
+
+struct ServerResponse {
+    ServerStatus status = ServerStatus::Ok;
+    uint64_t count = 0;   // индекс для Add, число фигур для Remove и Range
+    double value = 0.0;   // площадь для Total
+    std::string error;
+};
+
+// Общее хранилище сервера: пакет с добавлениями или удалениями выполняется
+// под исключительной блокировкой, пакет только из запросов — под разделяемой.
+// Каждый пакет применяется атомарно относительно других пакетов.
+template<Scalar T>
+class SharedFigureStore {
+private:
+    struct Command {
+        ServerCommand op;
+        FigureKind kind;
+        uint64_t index;
+        double values[8];
+    };
+
+    AggregateArray<T> figures;
+    // Прямоугольники фигур подряд: запрос окна перебирает их без виртуальных вызовов.
+    std::vector<BoundingBox<T>> boxes;
+    mutable std::shared_mutex mutex;
+
+    static void writeError(std::vector<char>& out, const std::string& message) {
+        detail::appendValue(out, ServerStatus::Error);
+        uint16_t length = static_cast<uint16_t>(std::min<size_t>(message.size(), 65535));
+        detail::appendValue(out, length);
+        out.insert(out.end(), message.data(), message.data() + length);
+    }
+
+    void query(const Command& command, std::vector<char>& out) const {
+        if (command.op == ServerCommand::Total) {
+            detail::appendValue(out, ServerStatus::Ok);
+            detail::appendValue(out, figures.totalArea());
+            return;
+        }
+        BoundingBox<T> box{static_cast<T>(command.values[0]), static_cast<T>(command.values[1]),
+                           static_cast<T>(command.values[2]), static_cast<T>(command.values[3])};
+        // Без ветвлений: при случайных окнах условие intersects плохо предсказывается.
+        uint64_t found = 0;
+        for (const BoundingBox<T>& b : boxes) {
+            found += static_cast<uint64_t>((b.minX <= box.maxX) & (box.minX <= b.maxX) & (b.minY <= box.maxY) &
+                                           (box.minY <= b.maxY));
+        }
+        detail::appendValue(out, ServerStatus::Ok);
+        detail::appendValue(out, found);
+    }
+
+    void execute(const Command& command, std::vector<char>& out) {
+        if (command.op == ServerCommand::Add) {
+            Point<T> points[4];
+            for (size_t v = 0; v < 4; ++v) {
+                points[v] = Point<T>(static_cast<T>(command.values[2 * v]), static_cast<T>(command.values[2 * v + 1]));
+                // NaN проходит проверки фигур и ломает порядок в агрегатах хранилища.
+                if (!std::isfinite(static_cast<double>(points[v].x)) || !std::isfinite(static_cast<double>(points[v].y))) {
+                    writeError(out, "координаты должны быть конечными");
+                    return;
+                }
+            }
+            std::shared_ptr<Figure<T>> figure;
+            try {
+                figure = makeFigure(command.kind, points);
+            } catch (const std::invalid_argument& err) {
+                writeError(out, err.what());
+                return;
+            }
+            boxes.push_back(boundingBox(*figure));
+            figures.pushBack(std::move(figure));
+            detail::appendValue(out, ServerStatus::Ok);
+            detail::appendValue(out, static_cast<uint64_t>(figures.getSize() - 1));
+        } else if (command.op == ServerCommand::Remove) {
+            if (command.index >= figures.getSize()) {
+                writeError(out, "Index out of range");
+                return;
+            }
+            figures.remove(static_cast<size_t>(command.index));
+            boxes.erase(boxes.begin() + static_cast<std::ptrdiff_t>(command.index));
+            detail::appendValue(out, ServerStatus::Ok);
+            detail::appendValue(out, static_cast<uint64_t>(figures.getSize()));
+        } else {
+            query(command, out);
+        }
+    }
+
+public:
+    // Выполняет кадр запроса (без поля длины) и дописывает кадр ответа в out.
+    // Нарушение формата — std::runtime_error, соединение после него закрывается.
+    void handle(const char* payload, size_t length, std::vector<char>& out) {
+        thread_local std::vector<Command> commands;
+        commands.clear();
+        detail::FrameReader reader(payload, length);
+        uint32_t count = reader.read<uint32_t>();
+        bool writes = false;
+        for (uint32_t i = 0; i < count; ++i) {
+            Command command{reader.read<ServerCommand>(), FigureKind::Square, 0, {}};
+            switch (command.op) {
+                case ServerCommand::Add: {
+                    uint8_t kind = reader.read<uint8_t>();
+                    if (kind >= FigureKindCount || static_cast<FigureKind>(kind) == FigureKind::Polygon) {
+                        throw std::runtime_error("неизвестный вид фигуры");
+                    }
+                    command.kind = static_cast<FigureKind>(kind);
+                    for (double& value : command.values) {
+                        value = reader.read<double>();
+                    }
+                    writes = true;
+                    break;
+                }
+                case ServerCommand::Remove:
+                    command.index = reader.read<uint64_t>();
+                    writes = true;
+                    break;
+                case ServerCommand::Total:
+                    break;
+                case ServerCommand::Range:
+                    for (size_t v = 0; v < 4; ++v) {
+                        command.values[v] = reader.read<double>();
+                    }
+                    break;
+                default:
+                    throw std::runtime_error("неизвестная команда");
+            }
+            commands.push_back(command);
+        }
+        if (!reader.atEnd()) {
+            throw std::runtime_error("лишние байты в кадре");
+        }
+
+        size_t start = out.size();
+        out.resize(start + 8);
+        if (writes) {
+            std::unique_lock lock(mutex);
+            for (const Command& command : commands) {
+                execute(command, out);
+            }
+        } else {
+            std::shared_lock lock(mutex);
+            for (const Command& command : commands) {
+                query(command, out);
+            }
+        }
+        uint32_t frameLength = static_cast<uint32_t>(out.size() - start - 4);
+        std::memcpy(out.data() + start, &frameLength, 4);
+        std::memcpy(out.data() + start + 4, &count, 4);
+    }
+
+    size_t getSize() const {
+        std::shared_lock lock(mutex);
+        return figures.getSize();
+    }
+
+    double totalArea() const {
+        std::shared_lock lock(mutex);
+        return figures.totalArea();
+    }
+};
+
+// Сервер на epoll: все соединения и слушающий сокет в одном epoll с EPOLLONESHOT,
+// его ждут threads рабочих потоков. Соединение в каждый момент обслуживает один поток:
+// он читает доступные байты, выполняет полные кадры, пишет ответы и снова взводит
+// соединение (с EPOLLOUT, если ответ не ушел целиком). Клиент, который шлет запросы,
+// но не читает ответы, упирается в MaxServerPendingBytes: выполнение кадров останавливается,
+// а соединение ждет только EPOLLOUT. Поэтому input не больше одного кадра и буфера чтения.
+template<Scalar T>
+class FigureServer {
+private:
+    // Передачу соединения между потоками упорядочивает EPOLLONESHOT; мьютекс
+    // (всегда свободный) делает этот порядок явным для модели памяти и TSan.
+    struct Connection {
+        std::mutex mutex;
+        int fd;
+        std::vector<char> input;
+        std::vector<char> output;
+        size_t sent = 0;
+        // Выполнение остановлено на пороге неотправленных ответов.
+        bool throttled = false;
+    };
+
+    ServerAddress address;
+    SharedFigureStore<T>& store;
+    int listenFd = -1;
+    int epollFd = -1;
+    int stopFd = -1;
+    std::vector<std::thread> workers;
+    std::mutex connectionsMutex;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::atomic<uint64_t> frames{0};
+    // Метки событий слушающего сокета и остановки в epoll_event::data.ptr.
+    char listenTag = 0;
+    char stopTag = 0;
+
+    void arm(int fd, void* tag, uint32_t events, int op) {
+        epoll_event event{};
+        event.events = events;
+        event.data.ptr = tag;
+        if (epoll_ctl(epollFd, op, fd, &event) != 0) {
+            detail::throwSocketError("ошибка epoll_ctl");
+        }
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            if (!address.local) {
+                int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            }
+            auto connection = std::make_unique<Connection>();
+            connection->fd = fd;
+            Connection* raw = connection.get();
+            std::lock_guard guard(raw->mutex);
+            {
+                std::lock_guard lock(connectionsMutex);
+                connections.emplace(fd, std::move(connection));
+            }
+            arm(fd, raw, EPOLLIN | EPOLLRDHUP | EPOLLONESHOT, EPOLL_CTL_ADD);
+        }
+        arm(listenFd, &listenTag, EPOLLIN | EPOLLONESHOT, EPOLL_CTL_MOD);
+    }
+
+    void close(Connection* connection) {
+        // Запись убирается до close: иначе другой поток может принять соединение
+        // с тем же номером дескриптора и потерять его запись.
+        std::unique_ptr<Connection> owned;
+        {
+            std::lock_guard lock(connectionsMutex);
+            auto found = connections.find(connection->fd);
+            owned = std::move(found->second);
+            connections.erase(found);
+        }
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, owned->fd, nullptr);
+        ::close(owned->fd);
+    }
+
+    size_t pending(const Connection& connection) const { return connection.output.size() - connection.sent; }
+
+    // Выполняет полные кадры из input, пока ответов меньше порога. false — ошибка протокола.
+    bool executeFrames(Connection& connection) {
+        size_t pos = 0;
+        while (connection.input.size() - pos >= 4 && pending(connection) < MaxServerPendingBytes) {
+            uint32_t length;
+            std::memcpy(&length, connection.input.data() + pos, 4);
+            if (length > MaxServerFrameBytes) {
+                return false;
+            }
+            if (connection.input.size() - pos - 4 < length) {
+                break;
+            }
+            try {
+                store.handle(connection.input.data() + pos + 4, length, connection.output);
+            } catch (const std::runtime_error&) {
+                return false;
+            }
+            frames.fetch_add(1, std::memory_order_relaxed);
+            pos += 4 + length;
+        }
+        connection.input.erase(connection.input.begin(), connection.input.begin() + static_cast<std::ptrdiff_t>(pos));
+        return true;
+    }
+
+    // false — соединение нужно закрыть.
+    bool readAndExecute(Connection& connection) {
+        char buffer[64 * 1024];
+        while (true) {
+            if (!executeFrames(connection)) {
+                return false;
+            }
+            connection.throttled = pending(connection) >= MaxServerPendingBytes;
+            if (connection.throttled) {
+                return true;
+            }
+            ssize_t got = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (got > 0) {
+                connection.input.insert(connection.input.end(), buffer, buffer + got);
+                continue;
+            }
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            return got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+
+    // false — соединение нужно закрыть.
+    bool flush(Connection& connection) {
+        while (connection.sent < connection.output.size()) {
+            ssize_t written = ::send(connection.fd, connection.output.data() + connection.sent,
+                                     connection.output.size() - connection.sent, MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            connection.sent += static_cast<size_t>(written);
+        }
+        connection.output.clear();
+        connection.sent = 0;
+        return true;
+    }
+
+    void serve(Connection* connection, uint32_t events) {
+        {
+            std::lock_guard lock(connection->mutex);
+            bool open = !(events & EPOLLERR);
+            // Ответы на уже выполненные команды отправляются и перед закрытием.
+            bool flushed = flush(*connection);
+            while (open && flushed) {
+                open = readAndExecute(*connection);
+                flushed = flush(*connection);
+                // Остановленные на пороге кадры продолжаются, если ответы ушли целиком:
+                // новых событий для них может не прийти.
+                if (!connection->throttled || !connection->output.empty()) {
+                    break;
+                }
+            }
+            if (open && flushed) {
+                // Без EPOLLRDHUP при остановке: полузакрытое соединение иначе будило бы поток непрерывно.
+                uint32_t interest = EPOLLONESHOT;
+                if (!connection->throttled) {
+                    interest |= EPOLLIN | EPOLLRDHUP;
+                }
+                if (!connection->output.empty()) {
+                    interest |= EPOLLOUT;
+                }
+                arm(connection->fd, connection, interest, EPOLL_CTL_MOD);
+                return;
+            }
+        }
+        close(connection);
+    }
+
+    void work() {
+        epoll_event events[16];
+        while (true) {
+            int ready = epoll_wait(epollFd, events, 16, -1);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            for (int i = 0; i < ready; ++i) {
+                void* tag = events[i].data.ptr;
+                if (tag == &stopTag) {
+                    return;
+                }
+                if (tag == &listenTag) {
+                    acceptAll();
+                } else {
+                    serve(static_cast<Connection*>(tag), events[i].events);
+                }
+            }
+        }
+    }
+
+public:
+    FigureServer(const ServerAddress& serverAddress, SharedFigureStore<T>& figureStore, size_t threads = 2)
+        : address(serverAddress), store(figureStore) {
+        listenFd = socket(address.socketFamily(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) {
+            detail::throwSocketError("не удалось создать сокет");
+        }
+        try {
+            if (address.local) {
+                ::unlink(address.path.c_str());
+            } else {
+                int one = 1;
+                setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            }
+            sockaddr_storage storage;
+            socklen_t length = address.fill(storage);
+            if (bind(listenFd, reinterpret_cast<sockaddr*>(&storage), length) != 0) {
+                detail::throwSocketError("не удалось занять адрес");
+            }
+            if (listen(listenFd, SOMAXCONN) != 0) {
+                detail::throwSocketError("ошибка listen");
+            }
+            if (!address.local && address.port == 0) {
+                length = sizeof(storage);
+                getsockname(listenFd, reinterpret_cast<sockaddr*>(&storage), &length);
+                address.port = ntohs(reinterpret_cast<sockaddr_in*>(&storage)->sin_port);
+            }
+            epollFd = epoll_create1(EPOLL_CLOEXEC);
+            stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (epollFd < 0 || stopFd < 0) {
+                detail::throwSocketError("не удалось создать epoll");
+            }
+            arm(listenFd, &listenTag, EPOLLIN | EPOLLONESHOT, EPOLL_CTL_ADD);
+            // Без EPOLLONESHOT: событие остановки видят все рабочие потоки.
+            arm(stopFd, &stopTag, EPOLLIN, EPOLL_CTL_ADD);
+        } catch (...) {
+            release();
+            throw;
+        }
+        for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    FigureServer(const FigureServer&) = delete;
+    FigureServer& operator=(const FigureServer&) = delete;
+
+    void stop() {
+        if (workers.empty()) {
+            return;
+        }
+        uint64_t one = 1;
+        ssize_t written = ::write(stopFd, &one, sizeof(one));
+        (void)written;
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        release();
+    }
+
+    ~FigureServer() { stop(); }
+
+    // Фактический адрес (для tcp:0 — с выбранным системой портом).
+    const ServerAddress& getAddress() const { return address; }
+    uint64_t getFrameCount() const { return frames.load(std::memory_order_relaxed); }
+
+private:
+    void release() {
+        for (auto& [fd, connection] : connections) {
+            ::close(fd);
+        }
+        connections.clear();
+        for (int* fd : {&listenFd, &epollFd, &stopFd}) {
+            if (*fd >= 0) {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+        if (address.local) {
+            ::unlink(address.path.c_str());
+        }
+    }
+};
+
+// Блокирующий клиент: отправляет пакет и ждет ответ на него.
+class FigureClient {
+private:
+    int fd = -1;
+    std::vector<char> buffer;
+
+public:
+    explicit FigureClient(const ServerAddress& address) {
+        fd = socket(address.socketFamily(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            detail::throwSocketError("не удалось создать сокет");
+        }
+        sockaddr_storage storage;
+        socklen_t length = address.fill(storage);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&storage), length) != 0) {
+            int error = errno;
+            ::close(fd);
+            errno = error;
+            detail::throwSocketError("не удалось подключиться");
+        }
+        if (!address.local) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+    }
+
+    FigureClient(const FigureClient&) = delete;
+    FigureClient& operator=(const FigureClient&) = delete;
+
+    ~FigureClient() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    void send(RequestBatch& batch) {
+        const std::vector<char>& frame = batch.frame();
+        detail::sendAll(fd, frame.data(), frame.size());
+    }
+
+    // Ответ на ранее отправленный пакет batch.
+    std::vector<ServerResponse> receive(const RequestBatch& batch) {
+        uint32_t length;
+        detail::receiveAll(fd, reinterpret_cast<char*>(&length), 4);
+        if (length > MaxServerFrameBytes) {
+            throw std::runtime_error("слишком большой кадр ответа");
+        }
+        buffer.resize(length);
+        detail::receiveAll(fd, buffer.data(), length);
+        detail::FrameReader reader(buffer.data(), length);
+        uint32_t count = reader.read<uint32_t>();
+        if (count != batch.getCount()) {
+            throw std::runtime_error("число ответов не совпадает с пакетом");
+        }
+        std::vector<ServerResponse> responses(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            ServerResponse& response = responses[i];
+            response.status = reader.read<ServerStatus>();
+            if (response.status != ServerStatus::Ok) {
+                response.error = reader.readString(reader.read<uint16_t>());
+            } else if (batch.getCommands()[i] == ServerCommand::Total) {
+                response.value = reader.read<double>();
+            } else {
+                response.count = reader.read<uint64_t>();
+            }
+        }
+        return responses;
+    }
+
+    std::vector<ServerResponse> call(RequestBatch& batch) {
+        send(batch);
+        return receive(batch);
+    }
+
+    int getDescriptor() const { return fd; }
+};
+
+struct LoadReport {
+    LatencyHistogram latency;   // время ответа на пакет, нс
+    uint64_t requests = 0;
+    uint64_t commands = 0;
+    uint64_t errors = 0;
+    double seconds = 0.0;
+};
+
+// Замкнутая нагрузка: connections соединений, каждое шлет requests пакетов по batch команд
+// (добавления 30%, удаления 20%, общая площадь 30%, окно 20%) и ждет ответа на каждый.
+inline LoadReport runServerLoad(const ServerAddress& address, size_t connections, size_t requests, size_t batch,
+                                uint64_t seed = 1) {
+    std::vector<LoadReport> partial(connections);
+    std::vector<std::thread> threads;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t c = 0; c < connections; ++c) {
+        threads.emplace_back([&, c] {
+            LoadReport& report = partial[c];
+            FigureClient client(address);
+            FigureGenerator<double> generator(seed + c);
+            RequestBatch request;
+            uint64_t knownSize = 0;
+            for (size_t r = 0; r < requests; ++r) {
+                request.clear();
+                for (size_t i = 0; i < batch; ++i) {
+                    double roll = generator.random(0.0, 1.0);
+                    if (roll < 0.3) {
+                        request.add(*generator.next());
+                    } else if (roll < 0.5 && knownSize > 0) {
+                        request.remove(generator.random() % knownSize);
+                    } else if (roll < 0.8) {
+                        request.total();
+                    } else {
+                        double x = generator.random(-1000.0, 1000.0), y = generator.random(-1000.0, 1000.0);
+                        request.range(BoundingBox<double>{x, y, x + 100.0, y + 100.0});
+                    }
+                }
+                auto start = std::chrono::steady_clock::now();
+                std::vector<ServerResponse> responses = client.call(request);
+                report.latency.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+                for (size_t i = 0; i < responses.size(); ++i) {
+                    if (responses[i].status != ServerStatus::Ok) {
+                        ++report.errors;
+                    } else if (request.getCommands()[i] == ServerCommand::Add) {
+                        knownSize = responses[i].count + 1;
+                    } else if (request.getCommands()[i] == ServerCommand::Remove) {
+                        knownSize = responses[i].count;
+                    }
+                }
+                ++report.requests;
+                report.commands += responses.size();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    LoadReport total;
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    for (const LoadReport& report : partial) {
+        total.latency.merge(report.latency);
+        total.requests += report.requests;
+        total.commands += report.commands;
+        total.errors += report.errors;
+    }
+    return total;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "../point.h"
+#include "../figure.h"
+#include "../array.h"
+#include "../square.h"
+#include "../rectangle.h"
+#include "../trapez.h"
+#include "../figure_io.h"
+#include "../figure_parser.h"
+
+// Цель для libFuzzer: разбор из памяти и из потока не должен падать, а позиция
+// ошибки всегда лежит внутри входа.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string_view text(reinterpret_cast<const char*>(data), size);
+
+    try {
+        parseFigures<double>(text);
+    } catch (const ParseError& err) {
+        if (err.position() > size) {
+            std::abort();
+        }
+    } catch (const std::invalid_argument&) {
+    }
+
+    try {
+        size_t pos = 0;
+        Point<int> points[4];
+        parsePoints(text, pos, points, 4);
+        if (pos > size) {
+            std::abort();
+        }
+    } catch (const ParseError& err) {
+        if (err.position() > size) {
+            std::abort();
+        }
+    }
+
+    std::istringstream inpS{std::string(text)};
+    Square<double> square;
+    try {
+        square.Read(inpS);
+    } catch (const ParseError&) {
+        // поток должен вернуться к началу
+        inpS.clear();
+        if (inpS.tellg() != 0) {
+            std::abort();
+        }
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,305 @@
+#ifndef INTERSECTION_H
+#define INTERSECTION_H
+
+#include "figure.h"
+#include "array.h"
+#include "bounding_box.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numbers>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Замкнутый контур из вершин в порядке обхода.
+using Contour = std::vector<Point<double>>;
+
+inline double crossProduct(const Point<double>& o, const Point<double>& a, const Point<double>& b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// Ориентированная площадь: положительна для обхода против часовой стрелки.
+inline double signedArea(const Contour& contour) {
+    double sum = 0.0;
+    for (size_t i = 0; i < contour.size(); ++i) {
+        const Point<double>& a = contour[i];
+        const Point<double>& b = contour[(i + 1) % contour.size()];
+        sum += a.x * b.y - b.x * a.y;
+    }
+    return sum / 2.0;
+}
+
+// Вершины фигуры в порядке обхода против часовой стрелки.
+template<Scalar T>
+Contour toContour(const Figure<T>& figure) {
+    Contour contour(figure.getVertexCount());
+    for (size_t i = 0; i < contour.size(); ++i) {
+        Point<T> p = figure.getVertex(i);
+        contour[i] = Point<double>(static_cast<double>(p.x), static_cast<double>(p.y));
+    }
+    if (signedArea(contour) < 0.0) {
+        std::reverse(contour.begin(), contour.end());
+    }
+    return contour;
+}
+
+// Выпуклость контура, обходимого против часовой стрелки: все повороты влево
+// (соседние ребра на одной прямой допустимы) и суммарный поворот ровно один оборот,
+// иначе самопересекающаяся звезда тоже прошла бы проверку поворотов.
+inline bool isConvex(const Contour& contour) {
+    size_t n = contour.size();
+    if (n < 3) {
+        return false;
+    }
+    double turn = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const Point<double>& a = contour[i];
+        const Point<double>& b = contour[(i + 1) % n];
+        const Point<double>& c = contour[(i + 2) % n];
+        double ux = b.x - a.x, uy = b.y - a.y;
+        double vx = c.x - b.x, vy = c.y - b.y;
+        double cross = ux * vy - uy * vx;
+        if (cross < -1e-12 * std::hypot(ux, uy) * std::hypot(vx, vy)) {
+            return false;
+        }
+        turn += std::atan2(cross, ux * vx + uy * vy);
+    }
+    return std::abs(turn - 2.0 * std::numbers::pi) < 1e-6;
+}
+
+// Контур для алгоритмов, рассчитанных на выпуклые фигуры (отсечение, объединение):
+// на невыпуклой фигуре они молча дали бы неверную площадь, поэтому она отвергается.
+template<Scalar T>
+Contour toConvexContour(const Figure<T>& figure) {
+    Contour contour = toContour(figure);
+    if (!isConvex(contour)) {
+        throw std::invalid_argument("фигура не выпуклая");
+    }
+    return contour;
+}
+
+// Отсечение Сазерленда–Ходжмана: часть subject внутри выпуклого clip.
+// Оба контура должны быть обходом против часовой стрелки.
+// Результат пишется в output; input — рабочий буфер, чтобы не выделять память на каждую пару.
+inline void clipConvex(const Contour& subject, const Contour& clip, Contour& output, Contour& input) {
+    output.assign(subject.begin(), subject.end());
+    for (size_t e = 0; e < clip.size() && !output.empty(); ++e) {
+        const Point<double>& a = clip[e];
+        const Point<double>& b = clip[(e + 1) % clip.size()];
+        input.swap(output);
+        output.clear();
+        for (size_t i = 0; i < input.size(); ++i) {
+            const Point<double>& cur = input[i];
+            const Point<double>& next = input[(i + 1) % input.size()];
+            double sc = crossProduct(a, b, cur);
+            double sn = crossProduct(a, b, next);
+            if (sc >= 0.0) {
+                output.push_back(cur);
+            }
+            if ((sc >= 0.0) != (sn >= 0.0)) {
+                double t = sc / (sc - sn);
+                output.emplace_back(cur.x + t * (next.x - cur.x), cur.y + t * (next.y - cur.y));
+            }
+        }
+    }
+}
+
+inline Contour clipConvex(const Contour& subject, const Contour& clip) {
+    Contour output;
+    Contour input;
+    clipConvex(subject, clip, output, input);
+    return output;
+}
+
+inline double intersectionArea(const Contour& a, const Contour& b) {
+    thread_local Contour common;
+    thread_local Contour scratch;
+    clipConvex(a, b, common, scratch);
+    return common.size() < 3 ? 0.0 : std::abs(signedArea(common));
+}
+
+template<Scalar T>
+double intersectionArea(const Figure<T>& a, const Figure<T>& b) {
+    return intersectionArea(toConvexContour(a), toConvexContour(b));
+}
+
+// Широкая фаза на равномерной сетке: пары индексов (i < j), у которых пересекаются
+// ограничивающие прямоугольники. Размер ячейки равен среднему размеру прямоугольника,
+// но ячеек не больше 4n;
+// пара выдается только в той ячейке, где лежит нижний левый угол пересечения
+// прямоугольников, поэтому дубликатов нет. Ячейки обрабатываются параллельно.
+template<Scalar T>
+std::vector<std::pair<size_t, size_t>> candidatePairs(const std::vector<BoundingBox<T>>& boxes,
+                                                      size_t threads = defaultThreadCount()) {
+    std::vector<std::pair<size_t, size_t>> pairs;
+    if (boxes.size() < 2) {
+        return pairs;
+    }
+
+    BoundingBox<double> world{static_cast<double>(boxes[0].minX), static_cast<double>(boxes[0].minY),
+                              static_cast<double>(boxes[0].maxX), static_cast<double>(boxes[0].maxY)};
+    double extentSum = 0.0;
+    for (const BoundingBox<T>& box : boxes) {
+        world.expand(BoundingBox<double>{static_cast<double>(box.minX), static_cast<double>(box.minY),
+                                         static_cast<double>(box.maxX), static_cast<double>(box.maxY)});
+        extentSum += std::max(static_cast<double>(box.maxX - box.minX), static_cast<double>(box.maxY - box.minY));
+    }
+
+    double width = world.maxX - world.minX;
+    double height = world.maxY - world.minY;
+    double cell = std::max(extentSum / static_cast<double>(boxes.size()),
+                           std::sqrt(width * height / (4.0 * static_cast<double>(boxes.size()))));
+    if (!(cell > 0.0)) {
+        cell = 1.0;
+    }
+    // Ячеек не больше 4n: в вытянутом мире (высота почти 0, ширина огромна) квадратная
+    // ячейка дала бы астрономическое число столбцов, поэтому по каждой оси ячейка
+    // растягивается отдельно, пока сетка не уложится в этот предел.
+    double budget = 4.0 * static_cast<double>(boxes.size());
+    double wantCols = std::floor(width / cell) + 1.0;
+    double wantRows = std::floor(height / cell) + 1.0;
+    if (wantCols * wantRows > budget) {
+        double side = std::sqrt(budget);
+        if (wantRows <= side) {
+            wantCols = std::max(1.0, std::floor(budget / wantRows));
+        } else if (wantCols <= side) {
+            wantRows = std::max(1.0, std::floor(budget / wantCols));
+        } else {
+            wantCols = wantRows = std::floor(side);
+        }
+    }
+    double cellX = std::max(cell, width / wantCols);
+    double cellY = std::max(cell, height / wantRows);
+    size_t cols = static_cast<size_t>(wantCols);
+    size_t rows = static_cast<size_t>(wantRows);
+
+    auto column = [&](double x) {
+        return std::min(cols - 1, static_cast<size_t>((x - world.minX) / cellX));
+    };
+    auto row = [&](double y) {
+        return std::min(rows - 1, static_cast<size_t>((y - world.minY) / cellY));
+    };
+
+    // Ячейки в формате CSR: start[c]..start[c + 1] в members.
+    std::vector<size_t> start(cols * rows + 1, 0);
+    for (const BoundingBox<T>& box : boxes) {
+        for (size_t r = row(box.minY); r <= row(box.maxY); ++r) {
+            for (size_t c = column(box.minX); c <= column(box.maxX); ++c) {
+                ++start[r * cols + c + 1];
+            }
+        }
+    }
+    for (size_t c = 1; c < start.size(); ++c) {
+        start[c] += start[c - 1];
+    }
+    // Копии прямоугольников лежат подряд, чтобы перебор ячейки шел по памяти линейно.
+    // Вместе с ними храним ячейку нижнего левого угла: так как column() и row()
+    // монотонны, ячейка угла пересечения двух прямоугольников — покомпонентный максимум.
+    struct Member {
+        BoundingBox<T> box;
+        size_t index;
+        size_t firstRow;
+        size_t firstColumn;
+    };
+    std::vector<Member> members(start.back());
+    std::vector<size_t> fill(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        size_t firstRow = row(boxes[i].minY);
+        size_t firstColumn = column(boxes[i].minX);
+        for (size_t r = firstRow; r <= row(boxes[i].maxY); ++r) {
+            for (size_t c = firstColumn; c <= column(boxes[i].maxX); ++c) {
+                members[fill[r * cols + c]++] = Member{boxes[i], i, firstRow, firstColumn};
+            }
+        }
+    }
+
+    std::vector<std::vector<std::pair<size_t, size_t>>> found(std::max<size_t>(threads, 1));
+    parallelFor(cols * rows, threads, [&](size_t begin, size_t end, size_t part) {
+        for (size_t c = begin; c < end; ++c) {
+            for (size_t a = start[c]; a < start[c + 1]; ++a) {
+                const Member& first = members[a];
+                for (size_t b = a + 1; b < start[c + 1]; ++b) {
+                    const Member& second = members[b];
+                    bool overlap = (first.box.minX <= second.box.maxX) & (second.box.minX <= first.box.maxX) &
+                                   (first.box.minY <= second.box.maxY) & (second.box.minY <= first.box.maxY);
+                    if (!overlap) {
+                        continue;
+                    }
+                    size_t owner = std::max(first.firstRow, second.firstRow) * cols +
+                                   std::max(first.firstColumn, second.firstColumn);
+                    if (owner == c) {
+                        found[part].emplace_back(first.index, second.index);
+                    }
+                }
+            }
+        }
+    });
+
+    for (std::vector<std::pair<size_t, size_t>>& part : found) {
+        pairs.insert(pairs.end(), part.begin(), part.end());
+    }
+    return pairs;
+}
+
+struct IntersectionPair {
+    size_t first;
+    size_t second;
+    double area;
+};
+
+struct IntersectionStats {
+    size_t figures = 0;
+    size_t candidatePairs = 0;
+    size_t intersectingPairs = 0;
+
+    // Доля пар, отброшенных широкой фазой, от всех n * (n - 1) / 2 пар.
+    double cullingEfficiency() const {
+        double all = static_cast<double>(figures) * (static_cast<double>(figures) - 1.0) / 2.0;
+        return all > 0.0 ? 1.0 - static_cast<double>(candidatePairs) / all : 0.0;
+    }
+};
+
+// Все пары фигур с ненулевой площадью пересечения, отсортированные по (first, second).
+// Точная фаза выполняется параллельно на threads потоках. Фигуры должны быть выпуклыми.
+template<Scalar T>
+std::vector<IntersectionPair> findIntersections(const Array<std::shared_ptr<Figure<T>>>& figures,
+                                                size_t threads = defaultThreadCount(),
+                                                IntersectionStats* stats = nullptr) {
+    std::vector<Contour> contours(figures.getSize());
+    std::vector<BoundingBox<T>> boxes(figures.getSize());
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        contours[i] = toConvexContour(*figures[i]);
+        boxes[i] = boundingBox(*figures[i]);
+    }
+
+    std::vector<std::pair<size_t, size_t>> pairs = candidatePairs(boxes, threads);
+
+    std::vector<std::vector<IntersectionPair>> found(std::max<size_t>(threads, 1));
+    parallelFor(pairs.size(), threads, [&](size_t begin, size_t end, size_t part) {
+        for (size_t k = begin; k < end; ++k) {
+            double area = intersectionArea(contours[pairs[k].first], contours[pairs[k].second]);
+            if (area > 0.0) {
+                found[part].push_back(IntersectionPair{pairs[k].first, pairs[k].second, area});
+            }
+        }
+    });
+
+    std::vector<IntersectionPair> result;
+    for (std::vector<IntersectionPair>& part : found) {
+        result.insert(result.end(), part.begin(), part.end());
+    }
+    std::sort(result.begin(), result.end(), [](const IntersectionPair& l, const IntersectionPair& r) {
+        return l.first != r.first ? l.first < r.first : l.second < r.second;
+    });
+
+    if (stats) {
+        stats->figures = figures.getSize();
+        stats->candidatePairs = pairs.size();
+        stats->intersectingPairs = result.size();
+    }
+    return result;
+}
+
+#endif
\ No newline at end of file
@@ -1,249 +1,453 @@
-#include <iostream>
-#include <limits>
-#include <memory>
-
-#include "point.h"
-#include "figure.h"
-#include "array.h"
-#include "square.h"
-#include "rectangle.h"
-#include "trapez.h"
-
-using ScalarType = double;
-
-void clearInput() {
-    std::cin.clear();
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-}
-
-void addSquare(Array<std::shared_ptr<Figure<ScalarType>>>& figures) {
-    std::cout << "Введите 4 точки для квадрата (x y):" << std::endl;
-
-    try {
-        Point<ScalarType> points[4];
-        for (int i = 0; i < 4; ++i) {
-            std::cin >> points[i].x >> points[i].y;
-        }
-
-        if (!std::cin) {
-            clearInput();
-            std::cout << "Ошибка ввода" << std::endl;
-            return;
-        }
-
-        auto square = std::make_shared<Square<ScalarType>>(
-            points[0], points[1], points[2], points[3]
-        );
-
-        figures.pushBack(square);
-        std::cout << "Квадрат успешно добавлен" << std::endl;
-    } catch (const std::exception& err) {
-        std::cout << "Произошла ошибка: " << err.what() << std::endl;
-        clearInput();
-    }
-}
-
-void addRectangle(Array<std::shared_ptr<Figure<ScalarType>>>& figures) {
-    std::cout << "Введите 4 точки для прямоугольника (x y):" << std::endl;
-
-    try {
-        Point<ScalarType> points[4];
-        for (int i = 0; i < 4; ++i) {
-            std::cin >> points[i].x >> points[i].y;
-        }
-
-        if (!std::cin) {
-            clearInput();
-            std::cout << "Ошибка ввода" << std::endl;
-            return;
-        }
-
-        auto rectangle = std::make_shared<Rectangle<ScalarType>>(
-            points[0], points[1], points[2], points[3]
-        );
-
-        figures.pushBack(rectangle);
-        std::cout << "Прямоугольник успешно добавлен" << std::endl;
-    } catch (const std::exception& err) {
-        std::cout << "Произошла ошибка: " << err.what() << std::endl;
-        clearInput();
-    }
-}
-
-void addTrapezoid(Array<std::shared_ptr<Figure<ScalarType>>>& figures) {
-    std::cout << "Введите 4 точки для трапеции (x y):" << std::endl;
-
-    try {
-        Point<ScalarType> points[4];
-        for (int i = 0; i < 4; ++i) {
-            std::cin >> points[i].x >> points[i].y;
-        }
-
-        if (!std::cin) {
-            clearInput();
-            std::cout << "Ошибка ввода" << std::endl;
-            return;
-        }
-
-        auto trapezoid = std::make_shared<Trapezoid<ScalarType>>(
-            points[0], points[1], points[2], points[3]
-        );
-
-        figures.pushBack(trapezoid);
-        std::cout << "Трапеция успешно добавлена" << std::endl;
-    } catch (const std::exception& err) {
-        std::cout << "Произошла ошибка: " << err.what() << std::endl;
-        clearInput();
-    }
-}
-
-void showFigures(const Array<std::shared_ptr<Figure<ScalarType>>>& figures) {
-    if (figures.isEmpty()) {
-        std::cout << "Массив пуст, добавьте фигуры" << std::endl;
-        return;
-    }
-
-    for (size_t i = 0; i < figures.getSize(); ++i) {
-        std::cout << "\n[" << i << "] ";
-        std::cout << *figures[i] << std::endl;
-
-        Point<ScalarType> center = figures[i]->Center();
-        std::cout << "Центр: (" << center.x << ", " << center.y << ")" << std::endl;
-        std::cout << "Площадь: " << figures[i]->area() << std::endl;
-    }
-}
-
-void totalArea(const Array<std::shared_ptr<Figure<ScalarType>>>& figures) {
-    if (figures.isEmpty()) {
-        std::cout << "Массив пуст" << std::endl;
-        return;
-    }
-
-    double total = 0.0;
-    for (size_t i = 0; i < figures.getSize(); ++i) {
-        total += static_cast<double>(*figures[i]);
-    }
-    std::cout << "Общая площадь: " << total << std::endl;
-}
-
-void removeFigure(Array<std::shared_ptr<Figure<ScalarType>>>& figures) {
-    if (figures.isEmpty()) {
-        std::cout << "Массив пуст" << std::endl;
-        return;
-    }
-
-    std::cout << "Введите индекс (0-" << figures.getSize() - 1 << "): ";
-    size_t index;
-    std::cin >> index;
-
-    if (!std::cin) {
-        clearInput();
-        std::cout << "Некорректный ввод" << std::endl;
-        return;
-    }
-
-    try {
-        figures.remove(index);
-        std::cout << "Фигура удалена по индексу: " << index << std::endl;
-    } catch (const std::exception& err) {
-        std::cout << "Ошибка: " << err.what() << std::endl;
-    }
-}
-
-void clearArray(Array<std::shared_ptr<Figure<ScalarType>>>& figures) {
-    if (figures.isEmpty()) {
-        std::cout << "Массив уже пуст" << std::endl;
-        return;
-    }
-    figures.clear();
-    std::cout << "Массив очищен" << std::endl;
-}
-
-void printMenu() {
-    std::cout << "\n========== МЕНЮ ==========" << std::endl;
-    std::cout << "1. Добавить квадрат" << std::endl;
-    std::cout << "2. Добавить прямоугольник" << std::endl;
-    std::cout << "3. Добавить трапецию" << std::endl;
-    std::cout << "4. Показать все фигуры" << std::endl;
-    std::cout << "5. Показать общую площадь" << std::endl;
-    std::cout << "6. Удалить фигуру по индексу" << std::endl;
-    std::cout << "7. Очистить все фигуры" << std::endl;
-    std::cout << "0. Выход" << std::endl;
-    std::cout << "===========================" << std::endl;
-    std::cout << "Выбор: ";
-}
-
-void demonstrateSquareArray() {
-    std::cout << "\n=== Демонстрация Array<std::shared_ptr<Square<double>>> ===" << std::endl;
-
-    Array<std::shared_ptr<Square<double>>> squares;
-
-    // Добавляем несколько квадратов
-    auto sq1 = std::make_shared<Square<double>>(
-        Point<double>(0, 0), Point<double>(1, 0),
-        Point<double>(1, 1), Point<double>(0, 1)
-    );
-
-    auto sq2 = std::make_shared<Square<double>>(
-        Point<double>(2, 2), Point<double>(4, 2),
-        Point<double>(4, 4), Point<double>(2, 4)
-    );
-
-    squares.pushBack(sq1);
-    squares.pushBack(sq2);
-
-    std::cout << "Добавлено квадратов: " << squares.getSize() << std::endl;
-    for (size_t i = 0; i < squares.getSize(); ++i) {
-        std::cout << "Квадрат " << i << " - площадь: "
-                  << squares[i]->area() << std::endl;
-    }
-}
-
-int main() {
-    Array<std::shared_ptr<Figure<ScalarType>>> figures;
-
-    demonstrateSquareArray();
-
-    int choice;
-    do {
-        printMenu();
-        std::cin >> choice;
-
-        if (!std::cin) {
-            clearInput();
-            std::cout << "Некорректный ввод" << std::endl;
-            continue;
-        }
-
-        switch (choice) {
-            case 1:
-                addSquare(figures);
-                break;
-            case 2:
-                addRectangle(figures);
-                break;
-            case 3:
-                addTrapezoid(figures);
-                break;
-            case 4:
-                showFigures(figures);
-                break;
-            case 5:
-                totalArea(figures);
-                break;
-            case 6:
-                removeFigure(figures);
-                break;
-            case 7:
-                clearArray(figures);
-                break;
-            case 0:
-                std::cout << "Выход из программы" << std::endl;
-                break;
-            default:
-                std::cout << "Неверный выбор" << std::endl;
-        }
-    } while (choice != 0);
-
-    return 0;
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <pthread.h>
+#include <string>
+
+#include "point.h"
+#include "figure.h"
+#include "array.h"
+#include "square.h"
+#include "rectangle.h"
+#include "trapez.h"
+#include "figure_parser.h"
+#include "figure_journal.h"
+#include "durable_store.h"
+#include "async.h"
+#include "summation.h"
+#include "figure_server.h"
+#include "trace.h"
+
+using ScalarType = double;
+
+void clearInput() {
+    std::cin.clear();
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+}
+
+void addSquare(FigureJournal<ScalarType>& journal) {
+    TraceSpan span("addSquare");
+    std::cout << "Введите 4 точки для квадрата (x y):" << std::endl;
+
+    try {
+        Point<ScalarType> points[4];
+        try {
+            TraceSpan parse("readPoints");
+            readPoints(std::cin, points);
+        } catch (const ParseError& err) {
+            clearInput();
+            std::cout << "Ошибка ввода: " << err.what() << std::endl;
+            return;
+        }
+
+        std::shared_ptr<Square<ScalarType>> square;
+        {
+            TraceSpan validate("construct");
+            square = std::make_shared<Square<ScalarType>>(
+                points[0], points[1], points[2], points[3]
+            );
+        }
+
+        {
+            TraceSpan push("journal.pushBack");
+            journal.pushBack(square);
+        }
+        std::cout << "Квадрат успешно добавлен" << std::endl;
+    } catch (const std::exception& err) {
+        std::cout << "Произошла ошибка: " << err.what() << std::endl;
+        clearInput();
+    }
+}
+
+void addRectangle(FigureJournal<ScalarType>& journal) {
+    TraceSpan span("addRectangle");
+    std::cout << "Введите 4 точки для прямоугольника (x y):" << std::endl;
+
+    try {
+        Point<ScalarType> points[4];
+        try {
+            TraceSpan parse("readPoints");
+            readPoints(std::cin, points);
+        } catch (const ParseError& err) {
+            clearInput();
+            std::cout << "Ошибка ввода: " << err.what() << std::endl;
+            return;
+        }
+
+        std::shared_ptr<Rectangle<ScalarType>> rectangle;
+        {
+            TraceSpan validate("construct");
+            rectangle = std::make_shared<Rectangle<ScalarType>>(
+                points[0], points[1], points[2], points[3]
+            );
+        }
+
+        {
+            TraceSpan push("journal.pushBack");
+            journal.pushBack(rectangle);
+        }
+        std::cout << "Прямоугольник успешно добавлен" << std::endl;
+    } catch (const std::exception& err) {
+        std::cout << "Произошла ошибка: " << err.what() << std::endl;
+        clearInput();
+    }
+}
+
+void addTrapezoid(FigureJournal<ScalarType>& journal) {
+    TraceSpan span("addTrapezoid");
+    std::cout << "Введите 4 точки для трапеции (x y):" << std::endl;
+
+    try {
+        Point<ScalarType> points[4];
+        try {
+            TraceSpan parse("readPoints");
+            readPoints(std::cin, points);
+        } catch (const ParseError& err) {
+            clearInput();
+            std::cout << "Ошибка ввода: " << err.what() << std::endl;
+            return;
+        }
+
+        std::shared_ptr<Trapezoid<ScalarType>> trapezoid;
+        {
+            TraceSpan validate("construct");
+            trapezoid = std::make_shared<Trapezoid<ScalarType>>(
+                points[0], points[1], points[2], points[3]
+            );
+        }
+
+        {
+            TraceSpan push("journal.pushBack");
+            journal.pushBack(trapezoid);
+        }
+        std::cout << "Трапеция успешно добавлена" << std::endl;
+    } catch (const std::exception& err) {
+        std::cout << "Произошла ошибка: " << err.what() << std::endl;
+        clearInput();
+    }
+}
+
+void showFigures(const Array<std::shared_ptr<Figure<ScalarType>>>& figures) {
+    TraceSpan span("showFigures");
+    if (figures.isEmpty()) {
+        std::cout << "Массив пуст, добавьте фигуры" << std::endl;
+        return;
+    }
+
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        TraceSpan item("showFigures.figure");
+        std::cout << "\n[" << i << "] ";
+        const Figure<ScalarType>& figure = *figures.atUnchecked(i);
+        std::cout << figure << std::endl;
+
+        Point<ScalarType> center = figure.Center();
+        std::cout << "Центр: (" << center.x << ", " << center.y << ")" << std::endl;
+        std::cout << "Площадь: " << figure.area() << std::endl;
+    }
+}
+
+void totalArea(const Array<std::shared_ptr<Figure<ScalarType>>>& figures) {
+    TraceSpan span("totalArea");
+    if (figures.isEmpty()) {
+        std::cout << "Массив пуст" << std::endl;
+        return;
+    }
+
+    double total;
+    {
+        TraceSpan sum("sumAreas");
+        total = sumAreas(figures, SummationMode::Exact);
+    }
+    std::cout << "Общая площадь: " << total << std::endl;
+}
+
+void removeFigure(FigureJournal<ScalarType>& journal) {
+    TraceSpan span("removeFigure");
+    const Array<std::shared_ptr<Figure<ScalarType>>>& figures = journal.getFigures();
+    if (figures.isEmpty()) {
+        std::cout << "Массив пуст" << std::endl;
+        return;
+    }
+
+    std::cout << "Введите индекс (0-" << figures.getSize() - 1 << "): ";
+    size_t index;
+    std::cin >> index;
+
+    if (!std::cin) {
+        clearInput();
+        std::cout << "Некорректный ввод" << std::endl;
+        return;
+    }
+
+    try {
+        TraceSpan remove("journal.remove");
+        journal.remove(index);
+        std::cout << "Фигура удалена по индексу: " << index << std::endl;
+    } catch (const std::exception& err) {
+        std::cout << "Ошибка: " << err.what() << std::endl;
+    }
+}
+
+void clearArray(FigureJournal<ScalarType>& journal) {
+    TraceSpan span("clearArray");
+    if (journal.getFigures().isEmpty()) {
+        std::cout << "Массив уже пуст" << std::endl;
+        return;
+    }
+    journal.clear();
+    std::cout << "Массив очищен (можно отменить)" << std::endl;
+}
+
+void loadFromFile(FigureJournal<ScalarType>& journal) {
+    TraceSpan span("loadFromFile");
+    std::cout << "Введите путь к файлу: ";
+    std::string path;
+    std::cin >> path;
+
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "Не удалось открыть файл" << std::endl;
+        return;
+    }
+
+    try {
+        ThreadPool pool;
+        Array<std::shared_ptr<Figure<ScalarType>>> loadedFigures;
+        {
+            TraceSpan read("readFigureBatches");
+            for (auto& batch : readFigureBatches<ScalarType>(pool, file)) {
+                TraceSpan collect("collectBatch");
+                for (size_t i = 0; i < batch.getSize(); ++i) {
+                    loadedFigures.pushBack(std::move(batch[i]));
+                }
+            }
+        }
+        size_t loaded = loadedFigures.getSize();
+        TraceSpan append("journal.append");
+        journal.append(std::move(loadedFigures));
+        std::cout << "Загружено фигур: " << loaded << std::endl;
+    } catch (const std::exception& err) {
+        std::cout << "Ошибка: " << err.what() << std::endl;
+    }
+}
+
+void undoChange(FigureJournal<ScalarType>& journal) {
+    TraceSpan span("undoChange");
+    if (!journal.canUndo()) {
+        std::cout << "Нечего отменять" << std::endl;
+        return;
+    }
+    journal.undo();
+    std::cout << "Изменение отменено, фигур: " << journal.getFigures().getSize() << std::endl;
+}
+
+void redoChange(FigureJournal<ScalarType>& journal) {
+    TraceSpan span("redoChange");
+    if (!journal.canRedo()) {
+        std::cout << "Нечего повторять" << std::endl;
+        return;
+    }
+    journal.redo();
+    std::cout << "Изменение повторено, фигур: " << journal.getFigures().getSize() << std::endl;
+}
+
+void printMenu() {
+    std::cout << "\n========== МЕНЮ ==========" << std::endl;
+    std::cout << "1. Добавить квадрат" << std::endl;
+    std::cout << "2. Добавить прямоугольник" << std::endl;
+    std::cout << "3. Добавить трапецию" << std::endl;
+    std::cout << "4. Показать все фигуры" << std::endl;
+    std::cout << "5. Показать общую площадь" << std::endl;
+    std::cout << "6. Удалить фигуру по индексу" << std::endl;
+    std::cout << "7. Очистить все фигуры" << std::endl;
+    std::cout << "8. Загрузить фигуры из файла" << std::endl;
+    std::cout << "9. Отменить последнее изменение" << std::endl;
+    std::cout << "10. Повторить отмененное изменение" << std::endl;
+    std::cout << "0. Выход" << std::endl;
+    std::cout << "===========================" << std::endl;
+    std::cout << "Выбор: ";
+}
+
+void demonstrateSquareArray() {
+    std::cout << "\n=== Демонстрация Array<std::shared_ptr<Square<double>>> ===" << std::endl;
+
+    Array<std::shared_ptr<Square<double>>> squares;
+
+    // Добавляем несколько квадратов
+    auto sq1 = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0),
+        Point<double>(1, 1), Point<double>(0, 1)
+    );
+
+    auto sq2 = std::make_shared<Square<double>>(
+        Point<double>(2, 2), Point<double>(4, 2),
+        Point<double>(4, 4), Point<double>(2, 4)
+    );
+
+    squares.pushBack(sq1);
+    squares.pushBack(sq2);
+
+    std::cout << "Добавлено квадратов: " << squares.getSize() << std::endl;
+    for (size_t i = 0; i < squares.getSize(); ++i) {
+        std::cout << "Квадрат " << i << " - площадь: "
+                  << squares[i]->area() << std::endl;
+    }
+}
+
+// laba4_exe --serve <адрес> [потоков]: сервер фигур без меню до SIGINT или SIGTERM.
+int serve(const std::string& addressText, size_t threads) {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    // Маска ставится до запуска рабочих потоков, чтобы сигналы получал только sigwait.
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    try {
+        SharedFigureStore<ScalarType> figures;
+        FigureServer<ScalarType> server(ServerAddress::parse(addressText), figures, threads);
+        std::cout << "Сервер слушает " << addressText << ", потоков: " << threads << std::endl;
+        int signal = 0;
+        sigwait(&signals, &signal);
+        server.stop();
+        std::cout << "Сервер остановлен, обработано пакетов: " << server.getFrameCount() << std::endl;
+    } catch (const std::exception& err) {
+        std::cout << "Ошибка сервера: " << err.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+std::string tracePath;
+volatile std::sig_atomic_t interrupted = 0;
+
+// Записывает спаны, собранные с --trace, в файл Chrome trace event. Регистрируется
+// через atexit, поэтому трасса сохраняется при любом завершении main и вызове exit.
+void writeTrace() {
+    std::ofstream file(tracePath);
+    Tracer::global().writeChromeTrace(file);
+    if (!file) {
+        std::cout << "Не удалось записать трассу в " << tracePath << std::endl;
+        return;
+    }
+    std::cout << "Трасса записана в " << tracePath << ": спанов " << Tracer::global().getEventCount()
+              << ", потерянных " << Tracer::global().getDroppedCount() << std::endl;
+}
+
+// Ctrl-C прерывает ожидание ввода (без SA_RESTART), и меню завершается как по пункту 0.
+void onInterrupt(int) {
+    interrupted = 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 2 && std::string(argv[1]) == "--serve") {
+        return serve(argv[2], argc > 3 ? std::stoul(argv[3]) : 2);
+    }
+
+    // laba4_exe --trace <файл> [каталог]: спаны операций меню пишутся в файл при выходе,
+    // в том числе по концу ввода, Ctrl-C и ошибке.
+    if (argc > 2 && std::string(argv[1]) == "--trace") {
+        tracePath = argv[2];
+        Tracer::global().enable();
+        std::atexit(writeTrace);
+        struct sigaction action {};
+        action.sa_handler = onInterrupt;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, nullptr);
+        argc -= 2;
+        argv += 2;
+    }
+
+    Array<std::shared_ptr<Figure<ScalarType>>> figures;
+    FigureJournal<ScalarType> journal(figures);
+
+    // laba4_exe <каталог>: фигуры сохраняются в журнал на диске и восстанавливаются при запуске.
+    std::unique_ptr<DurableFigureStore<ScalarType>> store;
+    if (argc > 1) {
+        try {
+            store = std::make_unique<DurableFigureStore<ScalarType>>(argv[1]);
+        } catch (const std::exception& err) {
+            std::cout << "Не удалось открыть хранилище: " << err.what() << std::endl;
+            return 1;
+        }
+        {
+            TraceSpan restore("restoreFigures");
+            for (size_t i = 0; i < store->getFigures().getSize(); ++i) {
+                figures.pushBack(store->getFigures()[i]);
+            }
+        }
+        persistJournal(journal, *store);
+        const RecoveryStats& stats = store->getRecoveryStats();
+        std::cout << "Восстановлено фигур: " << figures.getSize() << " (записей журнала: " << stats.walRecords
+                  << ", " << stats.milliseconds << " мс)" << std::endl;
+    }
+
+    demonstrateSquareArray();
+
+    // Исключение из операции завершает программу через return, чтобы отработал atexit с трассой.
+    int choice = 0;
+    try {
+        do {
+            if (!interrupted) {
+                printMenu();
+                std::cin >> choice;
+            }
+
+            if (interrupted || std::cin.eof()) {
+                choice = 0;
+            } else if (!std::cin) {
+                clearInput();
+                std::cout << "Некорректный ввод" << std::endl;
+                continue;
+            }
+
+            switch (choice) {
+                case 1:
+                    addSquare(journal);
+                    break;
+                case 2:
+                    addRectangle(journal);
+                    break;
+                case 3:
+                    addTrapezoid(journal);
+                    break;
+                case 4:
+                    showFigures(figures);
+                    break;
+                case 5:
+                    totalArea(figures);
+                    break;
+                case 6:
+                    removeFigure(journal);
+                    break;
+                case 7:
+                    clearArray(journal);
+                    break;
+                case 8:
+                    loadFromFile(journal);
+                    break;
+                case 9:
+                    undoChange(journal);
+                    break;
+                case 10:
+                    redoChange(journal);
+                    break;
+                case 0:
+                    if (store) {
+                        TraceSpan commit("store.commit");
+                        store->commit();
+                    }
+                    std::cout << "Выход из программы" << std::endl;
+                    break;
+                default:
+                    std::cout << "Неверный выбор" << std::endl;
+            }
+        } while (choice != 0);
+    } catch (const std::exception& err) {
+        std::cout << "Ошибка: " << err.what() << std::endl;
+        return 1;
+    }
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include "figure.h"
+#include "array.h"
+#include <memory>
+#include <unordered_set>
+
+// Оценка служебной части блока std::make_shared: указатель на vtable,
+// два счетчика ссылок и заголовок блока кучи.
+constexpr size_t SharedControlBlockBytes = sizeof(void*) + 2 * sizeof(int) + sizeof(size_t);
+
+// Полный объем памяти коллекции: буфер массива, блоки управления shared_ptr
+// и сами фигуры. Фигура, на которую ссылаются несколько элементов, считается один раз.
+template<Scalar T>
+size_t memoryUsage(const Array<std::shared_ptr<Figure<T>>>& figures) {
+    size_t total = figures.memoryUsage();
+    std::unordered_set<const Figure<T>*> seen;
+    seen.reserve(figures.getSize());
+    for (const std::shared_ptr<Figure<T>>& item : figures) {
+        const Figure<T>* figure = item.get();
+        if (figure && seen.insert(figure).second) {
+            total += SharedControlBlockBytes + figure->memoryUsage();
+        }
+    }
+    return total;
+}
+
+#endif
\ No newline at end of file
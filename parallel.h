@@ -0,0 +1,50 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+inline size_t defaultThreadCount() {
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+// Делит [0, count) на threads непрерывных кусков и вызывает body(begin, end, part)
+// для каждого в отдельном потоке. Первое исключение из потоков пробрасывается наружу.
+template<typename Body>
+void parallelFor(size_t count, size_t threads, Body&& body) {
+    threads = std::max<size_t>(1, std::min(threads, count));
+    if (threads == 1) {
+        body(size_t(0), count, size_t(0));
+        return;
+    }
+
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t part = 0; part < threads; ++part) {
+        size_t begin = count * part / threads;
+        size_t end = count * (part + 1) / threads;
+        workers.emplace_back([&, begin, end, part] {
+            try {
+                body(begin, end, part);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,499 @@
+#ifndef PARTITIONED_ARRAY_H
+#define PARTITIONED_ARRAY_H
+
+#include "figure.h"
+#include "array.h"
+#include "bounding_box.h"
+#include "figure_kind.h"
+#include "parallel.h"
+#include "summation.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+// Размер строки кэша, на который выравниваются заголовки шардов и рабочих потоков.
+constexpr size_t CacheLineBytes = 64;
+
+// Узлы NUMA и их процессоры из /sys/devices/system/node. Если sysfs недоступна
+// или узел один, получается один узел со всеми процессорами.
+struct NumaTopology {
+    std::vector<std::vector<int>> nodes;
+
+    static std::vector<int> parseCpuList(const std::string& list) {
+        std::vector<int> cpus;
+        size_t pos = 0;
+        while (pos < list.size()) {
+            size_t comma = list.find(',', pos);
+            std::string range = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+            size_t dash = range.find('-');
+            if (!range.empty() && range.find_first_not_of("0123456789-\n") == std::string::npos) {
+                int first = std::stoi(range.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                for (int cpu = first; cpu <= last; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            }
+            if (comma == std::string::npos) {
+                break;
+            }
+            pos = comma + 1;
+        }
+        return cpus;
+    }
+
+    // Номера узлов могут идти с пропусками (например, node0 и node2), поэтому
+    // перебираются все каталоги node<N>, по возрастанию N.
+    static NumaTopology detect(const std::filesystem::path& root = "/sys/devices/system/node") {
+        NumaTopology topology;
+        std::vector<int> ids;
+        std::error_code error;
+        for (const std::filesystem::directory_entry& entry :
+             std::filesystem::directory_iterator(root, error)) {
+            std::string name = entry.path().filename().string();
+            if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+                name.find_first_not_of("0123456789", 4) == std::string::npos) {
+                ids.push_back(std::stoi(name.substr(4)));
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        for (int node : ids) {
+            std::ifstream file(root / ("node" + std::to_string(node)) / "cpulist");
+            std::string list;
+            if (!file || !std::getline(file, list)) {
+                continue;
+            }
+            std::vector<int> cpus = parseCpuList(list);
+            if (!cpus.empty()) {
+                topology.nodes.push_back(std::move(cpus));
+            }
+        }
+        if (topology.nodes.empty()) {
+            std::vector<int> cpus(defaultThreadCount());
+            for (size_t i = 0; i < cpus.size(); ++i) {
+                cpus[i] = static_cast<int>(i);
+            }
+            topology.nodes.push_back(std::move(cpus));
+        }
+        return topology;
+    }
+
+    size_t getCpuCount() const {
+        size_t count = 0;
+        for (const std::vector<int>& cpus : nodes) {
+            count += cpus.size();
+        }
+        return count;
+    }
+};
+
+// Постоянные рабочие потоки, по одному на шард, каждый закреплен за своим процессором.
+// Вся память шарда выделяется и впервые записывается его потоком, поэтому по политике
+// first-touch страницы оказываются на узле этого процессора без libnuma.
+// run и runAll можно звать из нескольких потоков: задания выполняются по очереди.
+class ShardExecutor {
+private:
+    struct alignas(CacheLineBytes) Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+        const std::function<void(size_t)>* task = nullptr;
+        std::exception_ptr error;
+        bool busy = false;
+        bool stop = false;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    // Рабочий поток хранит указатель на одно задание, поэтому задания не должны перекрываться.
+    std::mutex dispatch;
+
+    static void pin(std::thread& thread, int cpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        // Без прав на смену привязки потоки просто работают без нее.
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+    }
+
+    static void loop(Worker& worker, size_t index) {
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        while (true) {
+            worker.wake.wait(lock, [&worker] { return worker.busy || worker.stop; });
+            if (worker.stop) {
+                return;
+            }
+            try {
+                (*worker.task)(index);
+            } catch (...) {
+                worker.error = std::current_exception();
+            }
+            worker.busy = false;
+            worker.finished.notify_one();
+        }
+    }
+
+    void post(size_t index, const std::function<void(size_t)>& task) {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.task = &task;
+        worker.error = nullptr;
+        worker.busy = true;
+        worker.wake.notify_one();
+    }
+
+    std::exception_ptr wait(size_t index) {
+        Worker& worker = *workers[index];
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.finished.wait(lock, [&worker] { return !worker.busy; });
+        return worker.error;
+    }
+
+public:
+    // cpus[i] — процессор i-го потока; -1 — без привязки.
+    explicit ShardExecutor(const std::vector<int>& cpus) {
+        for (size_t i = 0; i < cpus.size(); ++i) {
+            workers.push_back(std::make_unique<Worker>());
+            Worker& worker = *workers.back();
+            worker.thread = std::thread(loop, std::ref(worker), i);
+            if (cpus[i] >= 0) {
+                pin(worker.thread, cpus[i]);
+            }
+        }
+    }
+
+    ShardExecutor(const ShardExecutor&) = delete;
+    ShardExecutor& operator=(const ShardExecutor&) = delete;
+
+    ~ShardExecutor() {
+        for (std::unique_ptr<Worker>& worker : workers) {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->stop = true;
+            }
+            worker->wake.notify_one();
+            worker->thread.join();
+        }
+    }
+
+    // Выполняет task(index) на потоке index и ждет завершения.
+    void run(size_t index, const std::function<void(size_t)>& task) {
+        std::lock_guard<std::mutex> lock(dispatch);
+        post(index, task);
+        if (std::exception_ptr error = wait(index)) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Выполняет task(i) на всех потоках одновременно; первое исключение пробрасывается.
+    void runAll(const std::function<void(size_t)>& task) {
+        std::lock_guard<std::mutex> lock(dispatch);
+        for (size_t i = 0; i < workers.size(); ++i) {
+            post(i, task);
+        }
+        std::exception_ptr first;
+        for (size_t i = 0; i < workers.size(); ++i) {
+            std::exception_ptr error = wait(i);
+            if (error && !first) {
+                first = error;
+            }
+        }
+        if (first) {
+            std::rethrow_exception(first);
+        }
+    }
+
+    size_t getSize() const { return workers.size(); }
+};
+
+// Коллекция фигур, разбитая на шарды. Каждый шард хранит вершины и тип фигур
+// в собственном буфере, который выделяет, растит и сканирует только поток-владелец
+// шарда, закрепленный за процессором своего узла NUMA. Запросы считаются по шардам
+// параллельно и сливаются в конце. Заголовки шардов выровнены по строке кэша, чтобы
+// потоки разных шардов не делили строку при обновлении размера.
+//
+// На машине с одним узлом все шарды на нем же, поведение то же, только без выигрыша.
+// Константные запросы можно звать из нескольких потоков одновременно (исполнитель
+// выполняет их по очереди), изменения — только при отсутствии других вызовов.
+template<Scalar T>
+class PartitionedFigureArray {
+public:
+    // Позиция фигуры: шард и индекс внутри шарда.
+    struct Location {
+        size_t shard;
+        size_t index;
+    };
+
+private:
+    struct Entry {
+        T coords[8];
+        FigureKind kind;
+    };
+
+    struct alignas(CacheLineBytes) Shard {
+        std::unique_ptr<Entry[]> data;
+        size_t size = 0;
+        size_t capacity = 0;
+        size_t node = 0;
+        int cpu = -1;
+    };
+    static_assert(sizeof(Shard) % CacheLineBytes == 0, "заголовки шардов не должны делить строку кэша");
+
+    std::vector<Shard> shards;
+    std::unique_ptr<ShardExecutor> executor;
+    size_t nextShard = 0;
+
+    // Вызывается только потоком-владельцем: буфер выделяется без инициализации,
+    // и все его страницы, включая запас, впервые записывает владелец.
+    static void grow(Shard& shard, size_t minCapacity) {
+        if (minCapacity <= shard.capacity) {
+            return;
+        }
+        size_t newCapacity = std::max(minCapacity, shard.capacity == 0 ? size_t(16) : shard.capacity * 2);
+        std::unique_ptr<Entry[]> newData = std::make_unique_for_overwrite<Entry[]>(newCapacity);
+        std::copy(shard.data.get(), shard.data.get() + shard.size, newData.get());
+        std::fill(newData.get() + shard.size, newData.get() + newCapacity, Entry{});
+        shard.data = std::move(newData);
+        shard.capacity = newCapacity;
+    }
+
+    static Entry encode(const Figure<T>& figure) {
+        if (figure.getVertexCount() != 4) {
+            throw std::invalid_argument("в шардах хранятся только четырехугольники");
+        }
+        Entry entry;
+        for (size_t v = 0; v < 4; ++v) {
+            Point<T> p = figure.getVertex(v);
+            entry.coords[2 * v] = p.x;
+            entry.coords[2 * v + 1] = p.y;
+        }
+        entry.kind = figureKind(figure);
+        return entry;
+    }
+
+    // Вершины берутся относительно первой, как в area() фигур: при больших координатах
+    // произведения не теряют точность на взаимном вычитании.
+    static double area(const Entry& entry) {
+        double x0 = static_cast<double>(entry.coords[0]), y0 = static_cast<double>(entry.coords[1]);
+        double sum = 0.0;
+        for (size_t i = 1; i + 1 < 4; ++i) {
+            double ax = static_cast<double>(entry.coords[2 * i]) - x0, ay = static_cast<double>(entry.coords[2 * i + 1]) - y0;
+            double bx = static_cast<double>(entry.coords[2 * i + 2]) - x0, by = static_cast<double>(entry.coords[2 * i + 3]) - y0;
+            sum += ax * by - bx * ay;
+        }
+        return std::abs(sum) / 2.0;
+    }
+
+    static BoundingBox<T> box(const Entry& entry) {
+        BoundingBox<T> result{entry.coords[0], entry.coords[1], entry.coords[0], entry.coords[1]};
+        for (size_t v = 1; v < 4; ++v) {
+            result.minX = std::min(result.minX, entry.coords[2 * v]);
+            result.minY = std::min(result.minY, entry.coords[2 * v + 1]);
+            result.maxX = std::max(result.maxX, entry.coords[2 * v]);
+            result.maxY = std::max(result.maxY, entry.coords[2 * v + 1]);
+        }
+        return result;
+    }
+
+    const Entry& entryAt(Location location) const {
+        if (location.shard >= shards.size() || location.index >= shards[location.shard].size) {
+            throw std::out_of_range("Index out of range");
+        }
+        return shards[location.shard].data[location.index];
+    }
+
+public:
+    // shardCount шардов распределяются по узлам по кругу, внутри узла — по процессорам.
+    // pin = false оставляет потоки без привязки (например, в контейнере с урезанным cpuset).
+    explicit PartitionedFigureArray(size_t shardCount = defaultThreadCount(), bool pin = true,
+                                    const NumaTopology& topology = NumaTopology::detect())
+        : shards(std::max<size_t>(shardCount, 1)) {
+        std::vector<int> cpus(shards.size(), -1);
+        for (size_t s = 0; s < shards.size(); ++s) {
+            shards[s].node = s % topology.nodes.size();
+            const std::vector<int>& nodeCpus = topology.nodes[shards[s].node];
+            shards[s].cpu = nodeCpus[(s / topology.nodes.size()) % nodeCpus.size()];
+            if (pin) {
+                cpus[s] = shards[s].cpu;
+            }
+        }
+        executor = std::make_unique<ShardExecutor>(cpus);
+    }
+
+    PartitionedFigureArray(const PartitionedFigureArray&) = delete;
+    PartitionedFigureArray& operator=(const PartitionedFigureArray&) = delete;
+
+    // Добавляет фигуру в следующий по кругу шард. Запись делает вызывающий поток,
+    // рост буфера — владелец шарда; рост амортизирован, так что переходов между потоками мало.
+    Location pushBack(const Figure<T>& figure) {
+        Entry entry = encode(figure);
+        size_t s = nextShard;
+        nextShard = (nextShard + 1) % shards.size();
+        Shard& shard = shards[s];
+        if (shard.size == shard.capacity) {
+            executor->run(s, [&shard](size_t) { grow(shard, shard.size + 1); });
+        }
+        shard.data[shard.size] = entry;
+        return Location{s, shard.size++};
+    }
+
+    // Раскладывает коллекцию по шардам непрерывными кусками; каждый шард
+    // заполняет свой поток.
+    void pushBatch(const Array<std::shared_ptr<Figure<T>>>& figures) {
+        size_t count = figures.getSize();
+        size_t parts = shards.size();
+        executor->runAll([&](size_t s) {
+            size_t begin = count * s / parts;
+            size_t end = count * (s + 1) / parts;
+            Shard& shard = shards[s];
+            grow(shard, shard.size + (end - begin));
+            for (size_t i = begin; i < end; ++i) {
+                shard.data[shard.size++] = encode(*figures[i]);
+            }
+        });
+    }
+
+    // Удаление со сдвигом внутри шарда: индексы остальных шардов не меняются.
+    void remove(Location location) {
+        entryAt(location);
+        Shard& shard = shards[location.shard];
+        std::copy(shard.data.get() + location.index + 1, shard.data.get() + shard.size,
+                  shard.data.get() + location.index);
+        --shard.size;
+    }
+
+    void clear() {
+        for (Shard& shard : shards) {
+            shard.size = 0;
+        }
+        nextShard = 0;
+    }
+
+    std::shared_ptr<Figure<T>> figure(Location location) const {
+        const Entry& entry = entryAt(location);
+        Point<T> points[4];
+        for (size_t v = 0; v < 4; ++v) {
+            points[v] = Point<T>(entry.coords[2 * v], entry.coords[2 * v + 1]);
+        }
+        return makeFigure(entry.kind, points);
+    }
+
+    FigureKind getKind(Location location) const { return entryAt(location).kind; }
+
+    size_t getSize() const {
+        size_t total = 0;
+        for (const Shard& shard : shards) {
+            total += shard.size;
+        }
+        return total;
+    }
+
+    bool isEmpty() const { return getSize() == 0; }
+    size_t getShardCount() const { return shards.size(); }
+    size_t getShardSize(size_t shard) const { return shards.at(shard).size; }
+    size_t getShardNode(size_t shard) const { return shards.at(shard).node; }
+
+    double totalArea() const {
+        std::vector<NeumaierSum> partial(shards.size());
+        executor->runAll([&](size_t s) {
+            const Shard& shard = shards[s];
+            for (size_t i = 0; i < shard.size; ++i) {
+                partial[s].add(area(shard.data[i]));
+            }
+        });
+        NeumaierSum total;
+        for (const NeumaierSum& sum : partial) {
+            total.add(sum.value());
+        }
+        return total.value();
+    }
+
+    size_t count(FigureKind kind) const {
+        std::vector<size_t> partial(shards.size(), 0);
+        executor->runAll([&](size_t s) {
+            const Shard& shard = shards[s];
+            size_t found = 0;
+            for (size_t i = 0; i < shard.size; ++i) {
+                found += shard.data[i].kind == kind;
+            }
+            partial[s] = found;
+        });
+        size_t total = 0;
+        for (size_t found : partial) {
+            total += found;
+        }
+        return total;
+    }
+
+    // Общий ограничивающий прямоугольник; для пустой коллекции — logic_error.
+    BoundingBox<T> boundingBox() const {
+        if (isEmpty()) {
+            throw std::logic_error("коллекция пуста");
+        }
+        std::vector<std::pair<bool, BoundingBox<T>>> partial(shards.size());
+        executor->runAll([&](size_t s) {
+            const Shard& shard = shards[s];
+            if (shard.size == 0) {
+                return;
+            }
+            BoundingBox<T> result = box(shard.data[0]);
+            for (size_t i = 1; i < shard.size; ++i) {
+                result.expand(box(shard.data[i]));
+            }
+            partial[s] = {true, result};
+        });
+        std::optional<BoundingBox<T>> result;
+        for (const std::pair<bool, BoundingBox<T>>& part : partial) {
+            if (!part.first) {
+                continue;
+            }
+            if (result) {
+                result->expand(part.second);
+            } else {
+                result = part.second;
+            }
+        }
+        return *result;
+    }
+
+    // Фигуры, чей ограничивающий прямоугольник пересекает query, по шардам и по возрастанию индекса.
+    std::vector<Location> rangeQuery(const BoundingBox<T>& query) const {
+        std::vector<std::vector<Location>> partial(shards.size());
+        executor->runAll([&](size_t s) {
+            const Shard& shard = shards[s];
+            for (size_t i = 0; i < shard.size; ++i) {
+                if (box(shard.data[i]).intersects(query)) {
+                    partial[s].push_back(Location{s, i});
+                }
+            }
+        });
+        std::vector<Location> found;
+        for (const std::vector<Location>& part : partial) {
+            found.insert(found.end(), part.begin(), part.end());
+        }
+        return found;
+    }
+
+    size_t memoryUsage() const {
+        size_t bytes = sizeof(*this) + shards.capacity() * sizeof(Shard);
+        for (const Shard& shard : shards) {
+            bytes += shard.capacity * sizeof(Entry);
+        }
+        return bytes;
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,305 @@
+#ifndef POLYGON_H
+#define POLYGON_H
+
+#include "figure.h"
+#include "figure_parser.h"
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+// Общий пул вершин многоугольников в формате CSR: координаты всех многоугольников
+// лежат подряд в xs и ys, вершины многоугольника id — [offsets[id], offsets[id + 1]).
+// Пул только растет, поэтому вершины многоугольника не меняются после добавления
+// и на них могут ссылаться несколько фигур. Добавление не потокобезопасно.
+template<Scalar T>
+class VertexPool {
+private:
+    std::vector<T> xs;
+    std::vector<T> ys;
+    std::vector<size_t> offsets{0};
+
+    void checkId(size_t id) const {
+        if (id + 1 >= offsets.size()) {
+            throw std::out_of_range("Index out of range");
+        }
+    }
+
+    // Формула площади по вершинам относительно первой, чтобы большие координаты
+    // не съедали точность при вычитании произведений; vertex(k) — k-я вершина.
+    template<typename Vertex>
+    static double areaOf(size_t count, Vertex vertex) {
+        if (count == 0) {
+            return 0.0;
+        }
+        Point<T> first = vertex(0);
+        double x0 = static_cast<double>(first.x), y0 = static_cast<double>(first.y);
+        double sum = 0.0;
+        for (size_t k = 1; k + 1 < count; ++k) {
+            Point<T> a = vertex(k), b = vertex(k + 1);
+            sum += (static_cast<double>(a.x) - x0) * (static_cast<double>(b.y) - y0) -
+                   (static_cast<double>(b.x) - x0) * (static_cast<double>(a.y) - y0);
+        }
+        return std::abs(sum) / 2.0;
+    }
+
+public:
+    void reserve(size_t polygons, size_t vertices) {
+        xs.reserve(vertices);
+        ys.reserve(vertices);
+        offsets.reserve(polygons + 1);
+    }
+
+    size_t add(std::span<const Point<T>> points) {
+        for (const Point<T>& p : points) {
+            xs.push_back(p.x);
+            ys.push_back(p.y);
+        }
+        offsets.push_back(xs.size());
+        return offsets.size() - 2;
+    }
+
+    size_t getPolygonCount() const { return offsets.size() - 1; }
+    size_t getTotalVertexCount() const { return xs.size(); }
+
+    size_t getVertexCount(size_t id) const {
+        checkId(id);
+        return offsets[id + 1] - offsets[id];
+    }
+
+    Point<T> getVertex(size_t id, size_t vertex) const {
+        if (vertex >= getVertexCount(id)) {
+            throw std::out_of_range("Index out of range");
+        }
+        return Point<T>(xs[offsets[id] + vertex], ys[offsets[id] + vertex]);
+    }
+
+    double area(size_t id) const {
+        checkId(id);
+        size_t begin = offsets[id];
+        return areaOf(offsets[id + 1] - begin, [this, begin](size_t k) {
+            return Point<T>(xs[begin + k], ys[begin + k]);
+        });
+    }
+
+    // Площадь еще не добавленных вершин той же формулой.
+    static double area(std::span<const Point<T>> points) {
+        return areaOf(points.size(), [points](size_t k) { return points[k]; });
+    }
+
+    // Среднее вершин, как у Center() остальных фигур.
+    Point<double> center(size_t id) const {
+        checkId(id);
+        size_t begin = offsets[id], end = offsets[id + 1];
+        double sx = 0.0, sy = 0.0;
+        for (size_t k = begin; k < end; ++k) {
+            sx += static_cast<double>(xs[k]);
+            sy += static_cast<double>(ys[k]);
+        }
+        double n = static_cast<double>(std::max<size_t>(end - begin, 1));
+        return Point<double>(sx / n, sy / n);
+    }
+
+    // Площади всех многоугольников пула за один проход по непрерывным массивам
+    // без виртуальных вызовов и проверок индексов. Слагаемые формулы площади
+    // (относительно первой вершины, как в area) копятся в четырех независимых суммах,
+    // чтобы соседние итерации не ждали друг друга.
+    void areas(std::vector<double>& out) const {
+        size_t n = getPolygonCount();
+        out.resize(n);
+        const T* x = xs.data();
+        const T* y = ys.data();
+        for (size_t p = 0; p < n; ++p) {
+            size_t first = offsets[p], last = offsets[p + 1];
+            if (first == last) {
+                out[p] = 0.0;
+                continue;
+            }
+            double x0 = static_cast<double>(x[first]), y0 = static_cast<double>(y[first]);
+            auto cross = [&](size_t k) {
+                return (static_cast<double>(x[k]) - x0) * (static_cast<double>(y[k + 1]) - y0) -
+                       (static_cast<double>(x[k + 1]) - x0) * (static_cast<double>(y[k]) - y0);
+            };
+            double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+            size_t k = first + 1;
+            for (; k + 4 < last; k += 4) {
+                s0 += cross(k);
+                s1 += cross(k + 1);
+                s2 += cross(k + 2);
+                s3 += cross(k + 3);
+            }
+            for (; k + 1 < last; ++k) {
+                s0 += cross(k);
+            }
+            out[p] = std::abs((s0 + s1) + (s2 + s3)) / 2.0;
+        }
+    }
+
+    // Центры (средние вершин) всех многоугольников пула за один проход.
+    void centers(std::vector<Point<double>>& out) const {
+        size_t n = getPolygonCount();
+        out.resize(n);
+        for (size_t p = 0; p < n; ++p) {
+            double sx = 0.0, sy = 0.0;
+            for (size_t k = offsets[p]; k < offsets[p + 1]; ++k) {
+                sx += static_cast<double>(xs[k]);
+                sy += static_cast<double>(ys[k]);
+            }
+            double count = static_cast<double>(std::max<size_t>(offsets[p + 1] - offsets[p], 1));
+            out[p] = Point<double>(sx / count, sy / count);
+        }
+    }
+
+    size_t memoryUsage() const {
+        return sizeof(*this) + (xs.capacity() + ys.capacity()) * sizeof(T) + offsets.capacity() * sizeof(size_t);
+    }
+};
+
+constexpr size_t MaxPolygonVertices = 1 << 20;
+
+// Многоугольник с произвольным числом вершин, хранящий вершины в общем пуле.
+// Копия ссылается на те же вершины пула; Read добавляет в пул новый многоугольник.
+// Многоугольник может быть невыпуклым: площадь и центр от этого не зависят, а
+// пересечения и объединение (intersection.h, union_area.h) такие фигуры отвергают.
+template<Scalar T>
+class Polygon : public Figure<T> {
+private:
+    std::shared_ptr<VertexPool<T>> pool;
+    size_t id = 0;
+
+    // Проверка до добавления в пул, чтобы отвергнутые вершины в нем не оставались.
+    static void validate(std::span<const Point<T>> points) {
+        if (points.size() < 3) {
+            throw std::invalid_argument("у многоугольника должно быть не меньше трех вершин");
+        }
+        if (VertexPool<T>::area(points) < 1e-9) {
+            throw std::invalid_argument("точки колинеарны");
+        }
+    }
+
+    void validate() const {
+        if (getVertexCount() < 3) {
+            throw std::invalid_argument("у многоугольника должно быть не меньше трех вершин");
+        }
+        if (pool->area(id) < 1e-9) {
+            throw std::invalid_argument("точки колинеарны");
+        }
+    }
+
+public:
+    Polygon() = default;
+
+    Polygon(std::shared_ptr<VertexPool<T>> vertexPool, std::span<const Point<T>> points)
+        : pool(std::move(vertexPool)) {
+        validate(points);
+        id = pool->add(points);
+    }
+
+    // Многоугольник с собственным пулом.
+    explicit Polygon(std::span<const Point<T>> points)
+        : Polygon(std::make_shared<VertexPool<T>>(), points) {}
+
+    Polygon(std::initializer_list<Point<T>> points)
+        : Polygon(std::span<const Point<T>>(points.begin(), points.size())) {}
+
+    // Обертка над уже добавленным в пул многоугольником.
+    Polygon(std::shared_ptr<VertexPool<T>> vertexPool, size_t polygonId)
+        : pool(std::move(vertexPool)), id(polygonId) {
+        validate();
+    }
+
+    Point<T> Center() const override {
+        if (!pool) {
+            return Point<T>();
+        }
+        Point<double> c = pool->center(id);
+        return Point<T>(static_cast<T>(c.x), static_cast<T>(c.y));
+    }
+
+    T area() const override {
+        return pool ? static_cast<T>(pool->area(id)) : T(0);
+    }
+
+    size_t getVertexCount() const override {
+        return pool ? pool->getVertexCount(id) : 0;
+    }
+
+    Point<T> getVertex(size_t index) const override {
+        if (index >= getVertexCount()) {
+            throw std::out_of_range("Index out of range");
+        }
+        return pool->getVertex(id, index);
+    }
+
+    // Собственные вершины и смещение в пуле; сам пул общий и не учитывается.
+    size_t memoryUsage() const override {
+        return sizeof(*this) + getVertexCount() * 2 * sizeof(T) + sizeof(size_t);
+    }
+
+    explicit operator double() const override {
+        return static_cast<double>(this->area());
+    }
+
+    bool operator==(const Polygon& other) const {
+        return std::abs(static_cast<double>(this->area() - other.area())) < 1e-9;
+    }
+
+    void Print(std::ostream& outS) const override {
+        outS << "точки многоугольника: ";
+        for (size_t i = 0; i < getVertexCount(); ++i) {
+            Point<T> p = getVertex(i);
+            outS << "(" << p.x << ", " << p.y << ") ";
+        }
+    }
+
+    // Формат: число вершин, затем пары координат. Позиции ошибок отсчитываются от начала чтения.
+    void Read(std::istream& inpS) override {
+        std::istream::pos_type start = inpS.tellg();
+        try {
+            size_t offset = 0;
+            if (inpS && inpS.rdbuf()) {
+                skipStreamSpaces(inpS.rdbuf(), offset);
+            }
+            size_t countPosition = offset;
+            size_t count;
+            readNumbers(inpS, &count, 1, offset);
+            if (count < 3) {
+                throw ParseError("у многоугольника должно быть не меньше трех вершин", countPosition);
+            }
+            if (count > MaxPolygonVertices) {
+                throw ParseError("слишком много вершин", countPosition);
+            }
+            std::vector<T> values(2 * count);
+            readNumbers(inpS, values.data(), values.size(), offset);
+            std::vector<Point<T>> points(count);
+            for (size_t i = 0; i < count; ++i) {
+                points[i] = Point<T>(values[2 * i], values[2 * i + 1]);
+            }
+            if (!pool) {
+                pool = std::make_shared<VertexPool<T>>();
+            }
+            id = pool->add(points);
+        } catch (const ParseError&) {
+            inpS.clear();
+            if (start != std::istream::pos_type(-1)) {
+                inpS.seekg(start);
+            }
+            inpS.setstate(std::ios::failbit);
+            throw;
+        }
+    }
+
+    std::unique_ptr<Figure<T>> clone() const override {
+        return std::make_unique<Polygon<T>>(*this);
+    }
+
+    const std::shared_ptr<VertexPool<T>>& getPool() const { return pool; }
+    size_t getId() const { return id; }
+
+    ~Polygon() override = default;
+};
+
+#endif
\ No newline at end of file
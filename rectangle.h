@@ -1,115 +1,143 @@
-#ifndef RECTANGLE_H
-#define RECTANGLE_H
-
-#include "figure.h"
-#include <memory>
-#include <cmath>
-#include <stdexcept>
-
-template<Scalar T>
-class Rectangle : public Figure<T> {
-private:
-    std::unique_ptr<Point<T>> dots[4];
-
-public:
-    Rectangle() {
-        for (int i = 0; i < 4; ++i) {
-            dots[i] = std::make_unique<Point<T>>();
-        }
-    }
-
-    Rectangle(const Point<T>& p1, const Point<T>& p2, const Point<T>& p3, const Point<T>& p4) {
-        dots[0] = std::make_unique<Point<T>>(p1);
-        dots[1] = std::make_unique<Point<T>>(p2);
-        dots[2] = std::make_unique<Point<T>>(p3);
-        dots[3] = std::make_unique<Point<T>>(p4);
-
-        if (area() < 1e-9) {
-            throw std::invalid_argument("точки колинеарны");
-        }
-    }
-
-    Rectangle(const Rectangle& other) {
-        for (int i = 0; i < 4; ++i) {
-            dots[i] = std::make_unique<Point<T>>(*other.dots[i]);
-        }
-    }
-
-    Rectangle(Rectangle&& other) noexcept {
-        for (int i = 0; i < 4; ++i) {
-            dots[i] = std::move(other.dots[i]);
-        }
-    }
-
-    Rectangle& operator=(const Rectangle& other) {
-        if (this != &other) {
-            for (int i = 0; i < 4; ++i) {
-                dots[i] = std::make_unique<Point<T>>(*other.dots[i]);
-            }
-        }
-        return *this;
-    }
-
-    Rectangle& operator=(Rectangle&& other) noexcept {
-        if (this != &other) {
-            for (int i = 0; i < 4; ++i) {
-                dots[i] = std::move(other.dots[i]);
-            }
-        }
-        return *this;
-    }
-
-    Point<T> Center() const override {
-        T centerX = (dots[0]->x + dots[1]->x + dots[2]->x + dots[3]->x) / T(4);
-        T centerY = (dots[0]->y + dots[1]->y + dots[2]->y + dots[3]->y) / T(4);
-        return Point<T>(centerX, centerY);
-    }
-
-    T area() const override {
-        T sum = T(0);
-        for (int i = 0; i < 4; ++i) {
-            int j = (i + 1) % 4;
-            sum += dots[i]->x * dots[j]->y;
-            sum -= dots[j]->x * dots[i]->y;
-        }
-        return std::abs(sum) / T(2);
-    }
-
-    explicit operator double() const override {
-        return static_cast<double>(this->area());
-    }
-
-    bool operator==(const Rectangle& other) const {
-        return std::abs(static_cast<double>(this->area() - other.area())) < 1e-9;
-    }
-
-    void Print(std::ostream& outS) const override {
-        outS << "точки четырехугольника ";
-        for (int i = 0; i < 4; ++i) {
-            outS << "(" << dots[i]->x << ", " << dots[i]->y << ") ";
-        }
-    }
-
-    void Read(std::istream& inpS) override {
-        Point<T> temp[4];
-        for (int i = 0; i < 4; ++i) {
-            inpS >> temp[i].x >> temp[i].y;
-        }
-
-        if (!inpS) {
-            throw std::runtime_error("не удалось создать");
-        }
-
-        for (int i = 0; i < 4; ++i) {
-            dots[i] = std::make_unique<Point<T>>(temp[i]);
-        }
-    }
-
-    std::unique_ptr<Figure<T>> clone() const override {
-        return std::make_unique<Rectangle<T>>(*this);
-    }
-
-    ~Rectangle() override = default;
-};
-
+#ifndef RECTANGLE_H
+#define RECTANGLE_H
+
+#include "figure.h"
+#include "figure_parser.h"
+#include "figure_batch.h"
+#include <memory>
+#include <cmath>
+#include <stdexcept>
+
+template<Scalar T>
+class Rectangle : public Figure<T> {
+private:
+    std::unique_ptr<Point<T>> dots[4];
+
+public:
+    Rectangle() {
+        for (int i = 0; i < 4; ++i) {
+            dots[i] = std::make_unique<Point<T>>();
+        }
+    }
+
+    Rectangle(const Point<T>& p1, const Point<T>& p2, const Point<T>& p3, const Point<T>& p4) {
+        dots[0] = std::make_unique<Point<T>>(p1);
+        dots[1] = std::make_unique<Point<T>>(p2);
+        dots[2] = std::make_unique<Point<T>>(p3);
+        dots[3] = std::make_unique<Point<T>>(p4);
+
+        if (area() < 1e-9) {
+            throw std::invalid_argument("точки колинеарны");
+        }
+    }
+
+    // Для makeBatch: вершины уже проверены, площадь не пересчитывается.
+    Rectangle(detail::PrevalidatedTag, const Point<T>& p1, const Point<T>& p2, const Point<T>& p3, const Point<T>& p4) {
+        dots[0] = std::make_unique<Point<T>>(p1);
+        dots[1] = std::make_unique<Point<T>>(p2);
+        dots[2] = std::make_unique<Point<T>>(p3);
+        dots[3] = std::make_unique<Point<T>>(p4);
+    }
+
+    // Пакет из xs.size() / 4 прямоугольников, вершины строки r — (xs[4r + k], ys[4r + k]).
+    // Все строки проверяются одним проходом, допустимые фигуры добавляются в out по порядку;
+    // возвращается маска отклоненных строк.
+    static BatchMask makeBatch(std::span<const T> xs, std::span<const T> ys, Array<std::shared_ptr<Figure<T>>>& out) {
+        return detail::makeBatch<Rectangle<T>>(xs, ys, out);
+    }
+
+    Rectangle(const Rectangle& other) {
+        for (int i = 0; i < 4; ++i) {
+            dots[i] = std::make_unique<Point<T>>(*other.dots[i]);
+        }
+    }
+
+    Rectangle(Rectangle&& other) noexcept {
+        for (int i = 0; i < 4; ++i) {
+            dots[i] = std::move(other.dots[i]);
+        }
+    }
+
+    Rectangle& operator=(const Rectangle& other) {
+        if (this != &other) {
+            for (int i = 0; i < 4; ++i) {
+                dots[i] = std::make_unique<Point<T>>(*other.dots[i]);
+            }
+        }
+        return *this;
+    }
+
+    Rectangle& operator=(Rectangle&& other) noexcept {
+        if (this != &other) {
+            for (int i = 0; i < 4; ++i) {
+                dots[i] = std::move(other.dots[i]);
+            }
+        }
+        return *this;
+    }
+
+    Point<T> Center() const override {
+        T centerX = (dots[0]->x + dots[1]->x + dots[2]->x + dots[3]->x) / T(4);
+        T centerY = (dots[0]->y + dots[1]->y + dots[2]->y + dots[3]->y) / T(4);
+        return Point<T>(centerX, centerY);
+    }
+
+    T area() const override {
+        // Вершины берутся относительно первой: при больших координатах
+        // произведения не теряют точность на взаимном вычитании.
+        T sum = T(0);
+        for (int i = 1; i + 1 < 4; ++i) {
+            T ax = dots[i]->x - dots[0]->x, ay = dots[i]->y - dots[0]->y;
+            T bx = dots[i + 1]->x - dots[0]->x, by = dots[i + 1]->y - dots[0]->y;
+            sum += ax * by - bx * ay;
+        }
+        return std::abs(sum) / T(2);
+    }
+
+    size_t getVertexCount() const override {
+        return 4;
+    }
+
+    Point<T> getVertex(size_t index) const override {
+        if (index >= 4) {
+            throw std::out_of_range("Index out of range");
+        }
+        return *dots[index];
+    }
+
+    size_t memoryUsage() const override {
+        return sizeof(*this) + 4 * heapBlockSize(sizeof(Point<T>));
+    }
+
+    explicit operator double() const override {
+        return static_cast<double>(this->area());
+    }
+
+    bool operator==(const Rectangle& other) const {
+        return std::abs(static_cast<double>(this->area() - other.area())) < 1e-9;
+    }
+
+    void Print(std::ostream& outS) const override {
+        outS << "точки четырехугольника ";
+        for (int i = 0; i < 4; ++i) {
+            outS << "(" << dots[i]->x << ", " << dots[i]->y << ") ";
+        }
+    }
+
+    void Read(std::istream& inpS) override {
+        Point<T> temp[4];
+        readPoints(inpS, temp);
+
+        for (int i = 0; i < 4; ++i) {
+            dots[i] = std::make_unique<Point<T>>(temp[i]);
+        }
+    }
+
+    std::unique_ptr<Figure<T>> clone() const override {
+        return std::make_unique<Rectangle<T>>(*this);
+    }
+
+    ~Rectangle() override = default;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#!/usr/bin/env bash
+# Воспроизводимый замер: запускает команду N раз на закрепленном ядре и печатает
+# медиану, среднее, дисперсию и стандартное отклонение времени (мс).
+# Использование: perf_harness.sh [-n запусков] [-c ядро] [-w прогревов] -- команда [аргументы]
+set -euo pipefail
+
+runs=10
+cpu=0
+warmup=1
+while [[ $# -gt 0 && $1 != "--" ]]; do
+    case $1 in
+        -n) runs=$2; shift 2 ;;
+        -c) cpu=$2; shift 2 ;;
+        -w) warmup=$2; shift 2 ;;
+        *) echo "неизвестный параметр $1" >&2; exit 1 ;;
+    esac
+done
+[[ ${1:-} == "--" ]] && shift
+[[ $# -gt 0 ]] || { echo "не указана команда" >&2; exit 1; }
+
+pin=()
+if command -v taskset > /dev/null; then
+    pin=(taskset -c "$cpu")
+else
+    echo "taskset не найден, запуск без закрепления" >&2
+fi
+
+governor=/sys/devices/system/cpu/cpu$cpu/cpufreq/scaling_governor
+if [[ -r $governor && $(cat "$governor") != performance ]]; then
+    echo "внимание: регулятор частоты cpu$cpu = $(cat "$governor"), а не performance" >&2
+fi
+
+for ((i = 0; i < warmup; ++i)); do
+    "${pin[@]}" "$@" > /dev/null
+done
+
+times=()
+for ((i = 0; i < runs; ++i)); do
+    start=$(date +%s%N)
+    "${pin[@]}" "$@" > /dev/null
+    end=$(date +%s%N)
+    times+=($(( (end - start) / 1000 )))
+done
+
+printf '%s\n' "${times[@]}" | sort -n | awk -v runs="$runs" '
+    { t[NR] = $1 / 1000.0; sum += t[NR] }
+    END {
+        mean = sum / NR;
+        for (i = 1; i <= NR; ++i) var += (t[i] - mean) ^ 2;
+        var = NR > 1 ? var / (NR - 1) : 0;
+        median = NR % 2 ? t[(NR + 1) / 2] : (t[NR / 2] + t[NR / 2 + 1]) / 2;
+        printf "runs %d  median %.3f ms  mean %.3f ms  variance %.3f ms^2  stddev %.3f ms  min %.3f  max %.3f\n",
+               runs, median, mean, var, sqrt(var), t[1], t[NR];
+    }'
@@ -0,0 +1,18 @@
+#!/usr/bin/env bash
+# Полный цикл PGO: инструментированная сборка -> обучающая нагрузка -> сборка по профилю.
+# Запускать из корня проекта; результат в build/pgo. Оба шага собираются в одном
+# каталоге, потому что gcc ищет профиль по пути объектного файла.
+set -euo pipefail
+
+cmake --preset pgo-generate
+cmake --build --preset pgo-generate -j"$(nproc)"
+rm -rf build/pgo-data
+"$(dirname "$0")/pgo_training.sh" build/pgo
+
+# clang пишет сырые .profraw, их нужно слить в default.profdata
+if ls build/pgo-data/*.profraw > /dev/null 2>&1; then
+    llvm-profdata merge -output=build/pgo-data/default.profdata build/pgo-data/*.profraw
+fi
+
+cmake --preset pgo-use
+cmake --build --preset pgo-use -j"$(nproc)"
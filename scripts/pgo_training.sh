@@ -0,0 +1,38 @@
+#!/usr/bin/env bash
+# Обучающая нагрузка для PGO: прогоняет через меню laba4_exe добавление, вывод,
+# подсчет площади, удаление и загрузку фигур, затем основные сценарии laba4_bench.
+# Использование: pgo_training.sh <каталог сборки> [число фигур]
+set -euo pipefail
+
+build_dir=${1:?"укажите каталог сборки"}
+count=${2:-20000}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+awk -v n="$count" 'BEGIN {
+    srand(42);
+    for (i = 0; i < n; ++i) {
+        x = int(rand() * 2000) - 1000; y = int(rand() * 2000) - 1000; w = 1 + int(rand() * 9);
+        printf "T %d %d %d %d %d %d %d %d\n", x, y, x + 4 * w, y, x + 3 * w, y + w, x + w, y + w;
+    }
+}' > "$work/figures.txt"
+
+awk -v n="$count" -v file="$work/figures.txt" 'BEGIN {
+    srand(7);
+    print 8; print file;
+    for (i = 0; i < n; ++i) {
+        x = int(rand() * 2000) - 1000; y = int(rand() * 2000) - 1000; w = 1 + int(rand() * 9);
+        kind = i % 3;
+        if (kind == 0) { print 1; printf "%d %d %d %d %d %d %d %d\n", x, y, x + w, y, x + w, y + w, x, y + w; }
+        if (kind == 1) { print 2; printf "%d %d %d %d %d %d %d %d\n", x, y, x + 2 * w, y, x + 2 * w, y + w, x, y + w; }
+        if (kind == 2) { print 3; printf "%d %d %d %d %d %d %d %d\n", x, y, x + 4 * w, y, x + 3 * w, y + w, x + w, y + w; }
+        if (i % 100 == 0) { print 5; print 6; print 0; }
+    }
+    print 4; print 5; print 7; print 0;
+}' > "$work/menu.txt"
+
+"$build_dir/laba4_exe" < "$work/menu.txt" > /dev/null
+
+for suite in dedup aggregate intersections union; do
+    "$build_dir/laba4_bench" "$suite" 100000 > /dev/null
+done
@@ -0,0 +1,522 @@
+#ifndef SHM_STORE_H
+#define SHM_STORE_H
+
+#include "figure.h"
+#include "bounding_box.h"
+#include "figure_kind.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Запись четырехугольника в разделяемой памяти: вершины и заранее посчитанные
+// площадь, центр и ограничивающий прямоугольник, чтобы читателям ничего не вычислять.
+// Ровно две строки кэша, без указателей.
+struct ShmFigureRecord {
+    double xs[4];
+    double ys[4];
+    double area;
+    double centerX;
+    double centerY;
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+    uint8_t kind;
+    uint8_t reserved[7];
+
+    Point<double> center() const { return Point<double>(centerX, centerY); }
+    BoundingBox<double> box() const { return BoundingBox<double>{minX, minY, maxX, maxY}; }
+};
+
+static_assert(sizeof(ShmFigureRecord) == 128);
+static_assert(std::is_trivially_copyable_v<ShmFigureRecord>);
+
+namespace detail {
+
+constexpr uint64_t ShmMagic = 0x3441424F4C53484DULL;
+constexpr uint32_t ShmVersion = 2;
+
+// Заголовок сегмента. Все ссылки внутри сегмента — смещения от его начала,
+// поэтому процессы могут отображать сегмент по любым адресам.
+struct ShmHeader {
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity;
+    uint64_t recordsOffset;
+    // Процесс-писатель: по нему читатели узнают, что писатель умер посреди записи.
+    std::atomic<int64_t> writerPid;
+    // Счетчик seqlock: нечетный, пока писатель меняет записи.
+    alignas(64) std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> count;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+constexpr size_t ShmRecordsOffset = (sizeof(ShmHeader) + 63) / 64 * 64;
+
+[[noreturn]] inline void throwShmError(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Писатель и читатели должны быть в одном пространстве имен PID.
+inline bool processAlive(int64_t pid) {
+    return pid > 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+}
+
+// Отображение сегмента shm_open; закрывается вместе с объектом.
+class ShmMapping {
+private:
+    void* address = MAP_FAILED;
+    size_t length = 0;
+
+public:
+    ShmMapping() = default;
+
+    ShmMapping(int fd, size_t bytes, bool writable) : length(bytes) {
+        address = mmap(nullptr, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            throwShmError("ошибка отображения разделяемой памяти");
+        }
+        close(fd);
+    }
+
+    ShmMapping(const ShmMapping&) = delete;
+    ShmMapping& operator=(const ShmMapping&) = delete;
+
+    ~ShmMapping() {
+        if (address != MAP_FAILED) {
+            munmap(address, length);
+        }
+    }
+
+    char* data() const { return static_cast<char*>(address); }
+    size_t size() const { return length; }
+};
+
+// Монопольный flock сегмента, который писатель держит все время работы. Ядро снимает
+// его при завершении процесса, поэтому по нему видно, брошен ли сегмент.
+class ShmWriterLock {
+private:
+    int fd = -1;
+
+public:
+    ShmWriterLock() = default;
+    ShmWriterLock(const ShmWriterLock&) = delete;
+    ShmWriterLock& operator=(const ShmWriterLock&) = delete;
+
+    ~ShmWriterLock() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    // Блокировка принадлежит открытому файлу, поэтому держится копией дескриптора,
+    // а сам segmentFd можно закрыть после отображения.
+    bool hold(int segmentFd, bool wait) {
+        if (flock(segmentFd, LOCK_EX | (wait ? 0 : LOCK_NB)) != 0) {
+            return false;
+        }
+        fd = fcntl(segmentFd, F_DUPFD_CLOEXEC, 0);
+        if (fd < 0) {
+            throwShmError("не удалось заблокировать сегмент");
+        }
+        return true;
+    }
+};
+
+inline size_t shmSegmentBytes(size_t capacity) {
+    return ShmRecordsOffset + capacity * sizeof(ShmFigureRecord);
+}
+
+}
+
+// Хранилище четырехугольников в именованном сегменте POSIX (shm_open + mmap)
+// с одним писателем и любым числом читающих процессов (ShmFigureView).
+//
+// Записи лежат массивом фиксированной емкости за заголовком. Каждое изменение
+// (или пакет изменений в batch) публикуется через seqlock: писатель делает счетчик
+// нечетным, меняет записи и делает его четным, а читатель повторяет чтение, если
+// счетчик был нечетным или изменился за время чтения. Так читатели видят только
+// целые версии коллекции без блокировок и без копирования сегмента.
+// Писатель удаляет имя сегмента в деструкторе; уже открытые отображения остаются.
+class ShmFigureStore {
+private:
+    std::string name;
+    detail::ShmWriterLock lock;
+    detail::ShmMapping mapping;
+    detail::ShmHeader* header;
+    ShmFigureRecord* records;
+    size_t writeDepth = 0;
+
+    // Удаляет сегмент segmentName, если это хранилище фигур, брошенное писателем. Удаляется
+    // только сегмент, на котором взята блокировка: если имя уже указывает на новый сегмент
+    // (его успел пересоздать другой писатель), он не трогается. false — сегмент занят или чужой.
+    static bool removeAbandoned(const std::string& segmentName) {
+        int fd = shm_open(segmentName.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            return errno == ENOENT;
+        }
+        detail::ShmWriterLock probe;
+        struct stat locked;
+        if (!probe.hold(fd, false) || fstat(fd, &locked) != 0 ||
+            static_cast<size_t>(locked.st_size) < detail::ShmRecordsOffset) {
+            close(fd);
+            return false;
+        }
+        detail::ShmMapping existing(fd, detail::ShmRecordsOffset, false);
+        const detail::ShmHeader* old = reinterpret_cast<const detail::ShmHeader*>(existing.data());
+        bool ours = old->magic.load(std::memory_order_acquire) == detail::ShmMagic && old->version == detail::ShmVersion;
+
+        int current = shm_open(segmentName.c_str(), O_RDONLY, 0);
+        struct stat named;
+        bool same = current >= 0 && fstat(current, &named) == 0 && named.st_dev == locked.st_dev &&
+                    named.st_ino == locked.st_ino;
+        if (current >= 0) {
+            close(current);
+        }
+        if (!same) {
+            return true;
+        }
+        if (ours) {
+            shm_unlink(segmentName.c_str());
+        }
+        return ours;
+    }
+
+    int openSegment(const std::string& segmentName, size_t capacity) {
+        if (segmentName.size() < 2 || segmentName[0] != '/' || segmentName.find('/', 1) != std::string::npos) {
+            throw std::invalid_argument("имя сегмента должно иметь вид /имя");
+        }
+        if (capacity == 0) {
+            throw std::invalid_argument("емкость должна быть положительной");
+        }
+        int fd = -1;
+        for (int attempt = 0; fd < 0; ++attempt) {
+            fd = shm_open(segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd >= 0) {
+                break;
+            }
+            if (errno != EEXIST) {
+                detail::throwShmError("не удалось создать сегмент " + segmentName);
+            }
+            if (attempt == 16 || !removeAbandoned(segmentName)) {
+                throw std::runtime_error("сегмент " + segmentName + " уже существует и занят другим писателем");
+            }
+        }
+        // Ждать можно только другого писателя, который сейчас проверяет этот сегмент в removeAbandoned.
+        if (!lock.hold(fd, true) || ftruncate(fd, static_cast<off_t>(detail::shmSegmentBytes(capacity))) != 0) {
+            int error = errno;
+            close(fd);
+            shm_unlink(segmentName.c_str());
+            errno = error;
+            detail::throwShmError("не удалось задать размер сегмента");
+        }
+        return fd;
+    }
+
+    void beginWrite() {
+        if (writeDepth++ == 0) {
+            header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+    }
+
+    void endWrite() {
+        if (--writeDepth == 0) {
+            header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+    }
+
+    template<Scalar T>
+    static ShmFigureRecord makeRecord(const Figure<T>& figure) {
+        if (figure.getVertexCount() != 4) {
+            throw std::invalid_argument("в разделяемом хранилище только четырехугольники");
+        }
+        ShmFigureRecord record{};
+        for (size_t v = 0; v < 4; ++v) {
+            Point<T> p = figure.getVertex(v);
+            record.xs[v] = static_cast<double>(p.x);
+            record.ys[v] = static_cast<double>(p.y);
+        }
+        Point<T> center = figure.Center();
+        BoundingBox<T> box = boundingBox(figure);
+        record.area = static_cast<double>(figure.area());
+        record.centerX = static_cast<double>(center.x);
+        record.centerY = static_cast<double>(center.y);
+        record.minX = static_cast<double>(box.minX);
+        record.minY = static_cast<double>(box.minY);
+        record.maxX = static_cast<double>(box.maxX);
+        record.maxY = static_cast<double>(box.maxY);
+        record.kind = static_cast<uint8_t>(figureKind(figure));
+        return record;
+    }
+
+    void checkIndex(size_t index) const {
+        if (index >= getSize()) {
+            throw std::out_of_range("Index out of range");
+        }
+    }
+
+public:
+    // Создает сегмент segmentName (вида "/имя") под capacity фигур. Если сегмент с этим именем
+    // уже есть, он заменяется, только когда его писатель завершился (блокировка писателя
+    // снята), иначе std::runtime_error. Одновременный запуск писателей безопасен: брошенный
+    // сегмент заменит только один из них.
+    ShmFigureStore(const std::string& segmentName, size_t capacity)
+        : name(segmentName),
+          mapping(openSegment(segmentName, capacity), detail::shmSegmentBytes(capacity), true) {
+        header = new (mapping.data()) detail::ShmHeader;
+        header->version = detail::ShmVersion;
+        header->recordSize = sizeof(ShmFigureRecord);
+        header->capacity = capacity;
+        header->recordsOffset = detail::ShmRecordsOffset;
+        header->writerPid.store(static_cast<int64_t>(getpid()), std::memory_order_relaxed);
+        header->sequence.store(0, std::memory_order_relaxed);
+        header->count.store(0, std::memory_order_relaxed);
+        records = reinterpret_cast<ShmFigureRecord*>(mapping.data() + detail::ShmRecordsOffset);
+        header->magic.store(detail::ShmMagic, std::memory_order_release);
+    }
+
+    ShmFigureStore(const ShmFigureStore&) = delete;
+    ShmFigureStore& operator=(const ShmFigureStore&) = delete;
+
+    ~ShmFigureStore() {
+        shm_unlink(name.c_str());
+    }
+
+    template<Scalar T>
+    size_t pushBack(const Figure<T>& figure) {
+        ShmFigureRecord record = makeRecord(figure);
+        size_t index = getSize();
+        if (index >= header->capacity) {
+            throw std::length_error("разделяемое хранилище заполнено");
+        }
+        beginWrite();
+        records[index] = record;
+        header->count.store(index + 1, std::memory_order_relaxed);
+        endWrite();
+        return index;
+    }
+
+    template<Scalar T>
+    void set(size_t index, const Figure<T>& figure) {
+        checkIndex(index);
+        ShmFigureRecord record = makeRecord(figure);
+        beginWrite();
+        records[index] = record;
+        endWrite();
+    }
+
+    // Удаление за O(1): на место удаленной записи переносится последняя.
+    void remove(size_t index) {
+        checkIndex(index);
+        size_t last = getSize() - 1;
+        beginWrite();
+        records[index] = records[last];
+        header->count.store(last, std::memory_order_relaxed);
+        endWrite();
+    }
+
+    void clear() {
+        beginWrite();
+        header->count.store(0, std::memory_order_relaxed);
+        endWrite();
+    }
+
+    // Все изменения внутри body читатели увидят одной версией. Если body бросит
+    // исключение, уже сделанные изменения тоже публикуются.
+    template<typename F>
+    void batch(F&& body) {
+        beginWrite();
+        try {
+            body(*this);
+        } catch (...) {
+            endWrite();
+            throw;
+        }
+        endWrite();
+    }
+
+    size_t getSize() const { return header->count.load(std::memory_order_relaxed); }
+    size_t getCapacity() const { return header->capacity; }
+    uint64_t getVersion() const { return header->sequence.load(std::memory_order_relaxed) / 2; }
+    const std::string& getName() const { return name; }
+};
+
+// Читатель сегмента ShmFigureStore из любого процесса: запросы идут прямо по
+// отображенной памяти, без копии коллекции и разбора.
+class ShmFigureView {
+private:
+    detail::ShmMapping mapping;
+    const detail::ShmHeader* header;
+    const ShmFigureRecord* records;
+    size_t capacity;
+    mutable uint64_t retries = 0;
+    std::chrono::milliseconds timeout{5000};
+
+    // Вызывается при каждом повторе чтения: бросает, если писатель умер посреди записи
+    // или чтение не удалось за timeout. first — время первого повтора этого чтения.
+    void checkRetry(uint64_t sequence, std::chrono::steady_clock::time_point& first) const {
+        ++retries;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (first == std::chrono::steady_clock::time_point()) {
+            first = now;
+            return;
+        }
+        if ((sequence & 1) && !detail::processAlive(header->writerPid.load(std::memory_order_relaxed)) &&
+            header->sequence.load(std::memory_order_acquire) == sequence) {
+            throw std::runtime_error("писатель сегмента завершился, не закончив запись");
+        }
+        if (now - first > timeout) {
+            throw std::runtime_error("не удалось прочитать целую версию сегмента за отведенное время");
+        }
+    }
+
+    struct Segment {
+        int fd;
+        size_t bytes;
+    };
+
+    static Segment openSegment(const std::string& segmentName) {
+        int fd = shm_open(segmentName.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            detail::throwShmError("не удалось открыть сегмент " + segmentName);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            detail::throwShmError("не удалось узнать размер сегмента");
+        }
+        size_t bytes = static_cast<size_t>(info.st_size);
+        if (bytes < detail::ShmRecordsOffset) {
+            close(fd);
+            throw std::runtime_error("сегмент " + segmentName + " не является хранилищем фигур");
+        }
+        return Segment{fd, bytes};
+    }
+
+    ShmFigureView(Segment segment, const std::string& segmentName) : mapping(segment.fd, segment.bytes, false) {
+        header = reinterpret_cast<const detail::ShmHeader*>(mapping.data());
+        if (header->magic.load(std::memory_order_acquire) != detail::ShmMagic ||
+            header->version != detail::ShmVersion || header->recordSize != sizeof(ShmFigureRecord) ||
+            header->recordsOffset != detail::ShmRecordsOffset ||
+            detail::shmSegmentBytes(header->capacity) > segment.bytes) {
+            throw std::runtime_error("сегмент " + segmentName + " не является хранилищем фигур");
+        }
+        capacity = header->capacity;
+        records = reinterpret_cast<const ShmFigureRecord*>(mapping.data() + header->recordsOffset);
+    }
+
+public:
+    explicit ShmFigureView(const std::string& segmentName) : ShmFigureView(openSegment(segmentName), segmentName) {}
+
+    ShmFigureView(const ShmFigureView&) = delete;
+    ShmFigureView& operator=(const ShmFigureView&) = delete;
+
+    // Вызывает body(std::span<const ShmFigureRecord>) над целой версией коллекции и
+    // возвращает его результат. Пока писатель пишет, body может увидеть порванные записи
+    // и будет вызван снова, поэтому он не должен иметь побочных эффектов и бросать
+    // исключения из-за значений записей. Если писатель умер посреди записи или целую
+    // версию не удалось прочитать за getReadTimeout(), бросается std::runtime_error.
+    template<typename F>
+    auto read(F&& body) const {
+        std::chrono::steady_clock::time_point first{};
+        for (;;) {
+            uint64_t before = header->sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                checkRetry(before, first);
+                std::this_thread::yield();
+                continue;
+            }
+            size_t count = std::min<size_t>(header->count.load(std::memory_order_relaxed), capacity);
+            auto result = body(std::span<const ShmFigureRecord>(records, count));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header->sequence.load(std::memory_order_relaxed) == before) {
+                return result;
+            }
+            checkRetry(before, first);
+        }
+    }
+
+    // Копия записи index из целой версии коллекции.
+    ShmFigureRecord record(size_t index) const {
+        struct Found {
+            ShmFigureRecord record;
+            bool found;
+        };
+        Found result = read([index](std::span<const ShmFigureRecord> all) {
+            Found found{};
+            if (index < all.size()) {
+                std::memcpy(&found.record, &all[index], sizeof(ShmFigureRecord));
+                found.found = true;
+            }
+            return found;
+        });
+        if (!result.found) {
+            throw std::out_of_range("Index out of range");
+        }
+        return result.record;
+    }
+
+    double area(size_t index) const { return record(index).area; }
+    Point<double> center(size_t index) const { return record(index).center(); }
+    BoundingBox<double> box(size_t index) const { return record(index).box(); }
+    FigureKind kind(size_t index) const { return static_cast<FigureKind>(record(index).kind); }
+
+    size_t getSize() const {
+        return read([](std::span<const ShmFigureRecord> all) { return all.size(); });
+    }
+
+    double totalArea() const {
+        return read([](std::span<const ShmFigureRecord> all) {
+            double total = 0.0;
+            for (const ShmFigureRecord& r : all) {
+                total += r.area;
+            }
+            return total;
+        });
+    }
+
+    // Число фигур, чей ограничивающий прямоугольник пересекает query.
+    size_t countIntersecting(const BoundingBox<double>& query) const {
+        return read([&query](std::span<const ShmFigureRecord> all) {
+            size_t count = 0;
+            for (const ShmFigureRecord& r : all) {
+                count += static_cast<size_t>(r.minX <= query.maxX) & static_cast<size_t>(query.minX <= r.maxX) &
+                         static_cast<size_t>(r.minY <= query.maxY) & static_cast<size_t>(query.minY <= r.maxY);
+            }
+            return count;
+        });
+    }
+
+    uint64_t getVersion() const { return header->sequence.load(std::memory_order_acquire) / 2; }
+    size_t getCapacity() const { return capacity; }
+    void setReadTimeout(std::chrono::milliseconds limit) { timeout = limit; }
+    std::chrono::milliseconds getReadTimeout() const { return timeout; }
+    // Сколько раз чтения этого объекта повторялись из-за параллельной записи.
+    uint64_t getRetryCount() const { return retries; }
+};
+
+#endif
\ No newline at end of file
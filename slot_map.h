@@ -0,0 +1,167 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Дескриптор элемента SlotMap: номер слота и его поколение на момент вставки.
+// Дескриптор по умолчанию ни на что не указывает.
+struct SlotHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    bool operator==(const SlotHandle& other) const = default;
+};
+
+// Коллекция с устойчивыми дескрипторами вместо сдвигающихся индексов.
+//
+// Значения лежат плотно в values (обход без пропусков), слот дескриптора хранит позицию
+// значения и поколение. Удаление переносит последнее значение на место удаленного,
+// увеличивает поколение слота и кладет слот в список свободных, так что вставка, удаление
+// и поиск стоят O(1), а старые дескрипторы слота перестают совпадать по поколению.
+// Порядок плотного обхода после удалений не сохраняется.
+template<typename T>
+class SlotMap {
+private:
+    static constexpr uint32_t NoSlot = std::numeric_limits<uint32_t>::max();
+
+    struct Slot {
+        // Позиция значения в values у занятого слота, следующий свободный слот у свободного.
+        uint32_t position;
+        // Нечетное у занятого слота, четное у свободного.
+        uint32_t generation;
+    };
+
+    std::vector<T> values;
+    std::vector<uint32_t> owners;
+    std::vector<Slot> slots;
+    uint32_t freeHead = NoSlot;
+
+    const Slot* findSlot(SlotHandle handle) const {
+        if (handle.index >= slots.size()) {
+            return nullptr;
+        }
+        const Slot& slot = slots[handle.index];
+        return slot.generation == handle.generation && (slot.generation & 1) ? &slot : nullptr;
+    }
+
+public:
+    SlotMap() = default;
+
+    void reserve(size_t capacity) {
+        values.reserve(capacity);
+        owners.reserve(capacity);
+        slots.reserve(capacity);
+    }
+
+    SlotHandle insert(T value) {
+        uint32_t index;
+        if (freeHead != NoSlot) {
+            index = freeHead;
+            freeHead = slots[index].position;
+        } else {
+            if (slots.size() >= NoSlot) {
+                throw std::length_error("слишком много слотов");
+            }
+            index = static_cast<uint32_t>(slots.size());
+            slots.push_back(Slot{0, 0});
+        }
+        Slot& slot = slots[index];
+        slot.position = static_cast<uint32_t>(values.size());
+        ++slot.generation;
+        values.push_back(std::move(value));
+        owners.push_back(index);
+        return SlotHandle{index, slot.generation};
+    }
+
+    // Удаляет элемент; false, если дескриптор устарел или пуст.
+    bool remove(SlotHandle handle) {
+        if (!findSlot(handle)) {
+            return false;
+        }
+        Slot& slot = slots[handle.index];
+        uint32_t position = slot.position;
+        uint32_t last = static_cast<uint32_t>(values.size() - 1);
+        if (position != last) {
+            values[position] = std::move(values[last]);
+            owners[position] = owners[last];
+            slots[owners[position]].position = position;
+        }
+        values.pop_back();
+        owners.pop_back();
+        // Слот с исчерпанным поколением больше не выдается, чтобы дескрипторы не повторялись.
+        if (++slot.generation != std::numeric_limits<uint32_t>::max() - 1) {
+            slot.position = freeHead;
+            freeHead = handle.index;
+        }
+        return true;
+    }
+
+    bool contains(SlotHandle handle) const { return findSlot(handle) != nullptr; }
+
+    // Указатель на элемент или nullptr, если дескриптор устарел.
+    T* find(SlotHandle handle) {
+        const Slot* slot = findSlot(handle);
+        return slot ? &values[slot->position] : nullptr;
+    }
+
+    const T* find(SlotHandle handle) const {
+        const Slot* slot = findSlot(handle);
+        return slot ? &values[slot->position] : nullptr;
+    }
+
+    T& operator[](SlotHandle handle) {
+        T* value = find(handle);
+        if (!value) {
+            throw std::invalid_argument("устаревший дескриптор");
+        }
+        return *value;
+    }
+
+    const T& operator[](SlotHandle handle) const {
+        const T* value = find(handle);
+        if (!value) {
+            throw std::invalid_argument("устаревший дескриптор");
+        }
+        return *value;
+    }
+
+    // Дескриптор элемента на позиции плотного обхода.
+    SlotHandle handleAt(size_t position) const {
+        if (position >= values.size()) {
+            throw std::out_of_range("Index out of range");
+        }
+        uint32_t index = owners[position];
+        return SlotHandle{index, slots[index].generation};
+    }
+
+    // Все слоты освобождаются, а выданные дескрипторы становятся устаревшими.
+    void clear() {
+        while (!values.empty()) {
+            remove(handleAt(values.size() - 1));
+        }
+    }
+
+    T* begin() { return values.data(); }
+    T* end() { return values.data() + values.size(); }
+    const T* begin() const { return values.data(); }
+    const T* end() const { return values.data() + values.size(); }
+    std::span<T> span() { return values; }
+    std::span<const T> span() const { return values; }
+
+    size_t getSize() const { return values.size(); }
+    size_t getSlotCount() const { return slots.size(); }
+    bool isEmpty() const { return values.empty(); }
+
+    // Байты, занятые значениями и таблицей слотов (без памяти, на которую ссылаются элементы).
+    size_t memoryUsage() const {
+        return sizeof(*this) + values.capacity() * sizeof(T) + owners.capacity() * sizeof(uint32_t) +
+               slots.capacity() * sizeof(Slot);
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,361 @@
+#ifndef SUMMATION_H
+#define SUMMATION_H
+
+#include "figure.h"
+#include "array.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+// Режимы суммирования площадей. Для n слагаемых с суммой модулей A погрешность:
+// Naive — до (n - 1) * eps * A, Neumaier — до 2 * eps * |S| + n * eps^2 * A,
+// Pairwise — до (log2(n / 128) + 34) * eps * A, Exact — точная сумма, округленная один раз.
+enum class SummationMode : uint8_t {
+    Naive,
+    Neumaier,
+    Pairwise,
+    Exact
+};
+
+// Пакетные add(span) ведут SumLanes независимых сумм: соседние слагаемые не ждут
+// друг друга, и компилятор может держать суммы в векторных регистрах. Поэтому
+// результат пакетного сложения может отличаться от поэлементного в пределах погрешности режима.
+constexpr size_t SumLanes = 4;
+
+class NaiveSum {
+private:
+    double sum = 0.0;
+
+public:
+    void add(double value) { sum += value; }
+
+    void add(std::span<const double> values) {
+        const double* v = values.data();
+        size_t full = values.size() - values.size() % SumLanes;
+        double lanes[SumLanes] = {};
+        for (size_t i = 0; i < full; i += SumLanes) {
+            for (size_t l = 0; l < SumLanes; ++l) {
+                lanes[l] += v[i + l];
+            }
+        }
+        for (size_t i = full; i < values.size(); ++i) {
+            lanes[0] += v[i];
+        }
+        sum += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    double value() const { return sum; }
+    void reset() { sum = 0.0; }
+};
+
+// Компенсированное суммирование Ноймайера: погрешность порядка eps * |сумма| плюс
+// n * eps^2 * (сумма модулей слагаемых), то есть до очень больших n почти не зависит
+// от их числа. Поэтому сумму можно долго поддерживать инкрементально (в том числе
+// вычитая ранее добавленные значения); но если слагаемые почти взаимно сокращаются,
+// относительная погрешность результата все же растет.
+class NeumaierSum {
+private:
+    double sum;
+    double compensation;
+
+public:
+    NeumaierSum() : sum(0.0), compensation(0.0) {}
+
+    void add(double value) {
+        double t = sum + value;
+        if (std::abs(sum) >= std::abs(value)) {
+            compensation += (sum - t) + value;
+        } else {
+            compensation += (value - t) + sum;
+        }
+        sum = t;
+    }
+
+    // В полосах ошибка сложения считается без ветвления (TwoSum Кнута): она так же точна,
+    // как у Ноймайера, а цикл векторизуется.
+    void add(std::span<const double> values) {
+        const double* data = values.data();
+        size_t full = values.size() - values.size() % SumLanes;
+        double sums[SumLanes] = {};
+        double compensations[SumLanes] = {};
+        for (size_t i = 0; i < full; i += SumLanes) {
+            for (size_t l = 0; l < SumLanes; ++l) {
+                double v = data[i + l];
+                double t = sums[l] + v;
+                double vPart = t - sums[l];
+                compensations[l] += (sums[l] - (t - vPart)) + (v - vPart);
+                sums[l] = t;
+            }
+        }
+        for (size_t l = 0; l < SumLanes; ++l) {
+            add(sums[l]);
+            compensation += compensations[l];
+        }
+        for (size_t i = full; i < values.size(); ++i) {
+            add(data[i]);
+        }
+    }
+
+    double value() const { return sum + compensation; }
+
+    void reset() {
+        sum = 0.0;
+        compensation = 0.0;
+    }
+};
+
+// Попарное суммирование в потоке: блоки по BlockSize слагаемых складываются
+// по полосам, а суммы блоков сливаются как разряды двоичного счетчика,
+// так что каждое слагаемое проходит не больше log2(n / BlockSize) сложений сумм блоков.
+class PairwiseSum {
+public:
+    static constexpr size_t BlockSize = 128;
+
+private:
+    struct Partial {
+        double sum;
+        size_t blocks;
+    };
+
+    std::array<double, BlockSize> pending{};
+    size_t pendingCount = 0;
+    std::vector<Partial> stack;
+
+    static double blockSum(const double* values, size_t count) {
+        NaiveSum sum;
+        sum.add(std::span<const double>(values, count));
+        return sum.value();
+    }
+
+    void pushBlock(double sum) {
+        Partial partial{sum, 1};
+        while (!stack.empty() && stack.back().blocks == partial.blocks) {
+            partial.sum = stack.back().sum + partial.sum;
+            partial.blocks *= 2;
+            stack.pop_back();
+        }
+        stack.push_back(partial);
+    }
+
+public:
+    void add(double value) {
+        pending[pendingCount++] = value;
+        if (pendingCount == BlockSize) {
+            pushBlock(blockSum(pending.data(), BlockSize));
+            pendingCount = 0;
+        }
+    }
+
+    void add(std::span<const double> values) {
+        size_t i = 0;
+        while (pendingCount != 0 && i < values.size()) {
+            add(values[i++]);
+        }
+        for (; i + BlockSize <= values.size(); i += BlockSize) {
+            pushBlock(blockSum(values.data() + i, BlockSize));
+        }
+        for (; i < values.size(); ++i) {
+            add(values[i]);
+        }
+    }
+
+    double value() const {
+        double sum = blockSum(pending.data(), pendingCount);
+        for (size_t i = stack.size(); i > 0; --i) {
+            sum = stack[i - 1].sum + sum;
+        }
+        return sum;
+    }
+
+    void reset() {
+        pendingCount = 0;
+        stack.clear();
+    }
+};
+
+// Точная сумма на суперсумматоре: все конечные double — целые кратные 2^-1074,
+// поэтому сумма копится в длинном целом из 32-битных разрядов (каждый в int64_t,
+// с запасом на 2^30 слагаемых до переноса) и округляется к ближайшему один раз в value().
+// Сложение разрядов не векторизуется, пакетного ускорения у этого режима нет.
+class ExactSum {
+private:
+    static constexpr int Bias = 1074;
+    static constexpr size_t DigitBits = 32;
+    // 2046 позиций младшего бита и 53 бита мантиссы плюс два разряда под переносы.
+    static constexpr size_t DigitCount = (2046 + 53 + DigitBits - 1) / DigitBits + 2;
+    static constexpr size_t CarryInterval = size_t(1) << 30;
+
+    std::array<int64_t, DigitCount> digits{};
+    size_t sinceCarry = 0;
+    double special = 0.0;
+
+    static void carry(std::array<int64_t, DigitCount>& number) {
+        for (size_t i = 0; i + 1 < DigitCount; ++i) {
+            int64_t high = number[i] >> DigitBits;
+            number[i] -= high * (int64_t(1) << DigitBits);
+            number[i + 1] += high;
+        }
+    }
+
+public:
+    void add(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        int exponent = static_cast<int>((bits >> 52) & 0x7FF);
+        uint64_t mantissa = bits & ((uint64_t(1) << 52) - 1);
+        if (exponent == 0x7FF) {
+            special += value;
+            return;
+        }
+        if (exponent == 0) {
+            exponent = 1;
+        } else {
+            mantissa |= uint64_t(1) << 52;
+        }
+        // value = ±mantissa * 2^(exponent - 1075), позиция младшего бита от 2^-1074.
+        size_t position = static_cast<size_t>(exponent - 1);
+        unsigned __int128 shifted = static_cast<unsigned __int128>(mantissa) << (position % DigitBits);
+        size_t index = position / DigitBits;
+        int64_t sign = (bits >> 63) ? -1 : 1;
+        const uint64_t mask = (uint64_t(1) << DigitBits) - 1;
+        digits[index] += sign * static_cast<int64_t>(static_cast<uint64_t>(shifted) & mask);
+        digits[index + 1] += sign * static_cast<int64_t>(static_cast<uint64_t>(shifted >> DigitBits) & mask);
+        digits[index + 2] += sign * static_cast<int64_t>(static_cast<uint64_t>(shifted >> (2 * DigitBits)));
+        if (++sinceCarry == CarryInterval) {
+            carry(digits);
+            sinceCarry = 0;
+        }
+    }
+
+    void add(std::span<const double> values) {
+        for (double v : values) {
+            add(v);
+        }
+    }
+
+    double value() const {
+        if (special != 0.0 || std::isnan(special)) {
+            return special;
+        }
+        std::array<int64_t, DigitCount> number = digits;
+        carry(number);
+        bool negative = number[DigitCount - 1] < 0;
+        if (negative) {
+            for (int64_t& d : number) {
+                d = -d;
+            }
+            carry(number);
+        }
+        size_t top = DigitCount;
+        while (top > 0 && number[top - 1] == 0) {
+            --top;
+        }
+        if (top == 0) {
+            return 0.0;
+        }
+        // Три старших разряда дают 65+ значащих бит, младшие учитываются одним
+        // липким битом, поэтому приведение к double округляет так же, как точная сумма.
+        size_t high = top - 1;
+        unsigned __int128 mantissa = 0;
+        for (size_t k = 0; k < 3; ++k) {
+            mantissa <<= DigitBits;
+            if (high >= k) {
+                mantissa |= static_cast<uint64_t>(number[high - k]);
+            }
+        }
+        bool sticky = false;
+        for (size_t k = 0; k + 3 <= high; ++k) {
+            sticky = sticky || number[k] != 0;
+        }
+        if (sticky) {
+            mantissa |= 1;
+        }
+        int scale = static_cast<int>(high * DigitBits) - 2 * static_cast<int>(DigitBits) - Bias;
+        double result = std::ldexp(static_cast<double>(mantissa), scale);
+        return negative ? -result : result;
+    }
+
+    void reset() {
+        digits.fill(0);
+        sinceCarry = 0;
+        special = 0.0;
+    }
+};
+
+// Сумма значений выбранным режимом с пакетными (полосными) проходами.
+inline double sum(std::span<const double> values, SummationMode mode) {
+    switch (mode) {
+        case SummationMode::Naive: {
+            NaiveSum s;
+            s.add(values);
+            return s.value();
+        }
+        case SummationMode::Neumaier: {
+            NeumaierSum s;
+            s.add(values);
+            return s.value();
+        }
+        case SummationMode::Pairwise: {
+            PairwiseSum s;
+            s.add(values);
+            return s.value();
+        }
+        case SummationMode::Exact: {
+            ExactSum s;
+            s.add(values);
+            return s.value();
+        }
+    }
+    throw std::invalid_argument("неизвестный режим суммирования");
+}
+
+namespace detail {
+
+template<typename Sum, Scalar T>
+double sumAreasWith(Sum& sum, const Array<std::shared_ptr<Figure<T>>>& figures) {
+    constexpr size_t Chunk = 256;
+    double areas[Chunk];
+    for (size_t begin = 0; begin < figures.getSize(); begin += Chunk) {
+        size_t count = std::min(Chunk, figures.getSize() - begin);
+        for (size_t i = 0; i < count; ++i) {
+            areas[i] = static_cast<double>(*figures.atUnchecked(begin + i));
+        }
+        sum.add(std::span<const double>(areas, count));
+    }
+    return sum.value();
+}
+
+}
+
+// Общая площадь коллекции: площади собираются порциями и складываются пакетно.
+template<Scalar T>
+double sumAreas(const Array<std::shared_ptr<Figure<T>>>& figures, SummationMode mode = SummationMode::Neumaier) {
+    switch (mode) {
+        case SummationMode::Naive: {
+            NaiveSum s;
+            return detail::sumAreasWith(s, figures);
+        }
+        case SummationMode::Neumaier: {
+            NeumaierSum s;
+            return detail::sumAreasWith(s, figures);
+        }
+        case SummationMode::Pairwise: {
+            PairwiseSum s;
+            return detail::sumAreasWith(s, figures);
+        }
+        case SummationMode::Exact: {
+            ExactSum s;
+            return detail::sumAreasWith(s, figures);
+        }
+    }
+    throw std::invalid_argument("неизвестный режим суммирования");
+}
+
+#endif
\ No newline at end of file
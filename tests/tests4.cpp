@@ -1,469 +1,2718 @@
-#include <gtest/gtest.h>
-#include <memory>
-#include <sstream>
-#include <cmath>
-
-#include "../point.h"
-#include "../figure.h"
-#include "../array.h"
-#include "../square.h"
-#include "../rectangle.h"
-#include "../trapez.h"
-
-// Point tests
-TEST(PointTest, DefaultConstructor) {
-    Point<double> p;
-    EXPECT_DOUBLE_EQ(p.x, 0.0);
-    EXPECT_DOUBLE_EQ(p.y, 0.0);
-}
-
-TEST(PointTest, ParameterizedConstructor) {
-    Point<double> p(3.5, 4.5);
-    EXPECT_DOUBLE_EQ(p.x, 3.5);
-    EXPECT_DOUBLE_EQ(p.y, 4.5);
-}
-
-TEST(PointTest, CopyWorks) {
-    Point<double> p1(3.5, 4.5);
-    Point<double> p2(p1);
-    EXPECT_DOUBLE_EQ(p2.x, 3.5);
-    EXPECT_DOUBLE_EQ(p2.y, 4.5);
-}
-
-TEST(PointTest, IntType) {
-    Point<int> p(3, 4);
-    EXPECT_EQ(p.x, 3);
-    EXPECT_EQ(p.y, 4);
-}
-
-// Square tests
-TEST(SquareTest, DefaultWorks) {
-    Square<double> sq;
-    EXPECT_NO_THROW(sq.Center());
-}
-
-TEST(SquareTest, CreateSquare) {
-    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
-    Square<double> sq(p1, p2, p3, p4);
-    EXPECT_NEAR(sq.area(), 1.0, 1e-9);
-}
-
-TEST(SquareTest, AreaCalc) {
-    Point<double> p1(0, 0), p2(2, 0), p3(2, 2), p4(0, 2);
-    Square<double> sq(p1, p2, p3, p4);
-    EXPECT_NEAR(sq.area(), 4.0, 1e-9);
-}
-
-TEST(SquareTest, CenterCalc) {
-    Point<double> p1(0, 0), p2(2, 0), p3(2, 2), p4(0, 2);
-    Square<double> sq(p1, p2, p3, p4);
-    Point<double> center = sq.Center();
-    EXPECT_NEAR(center.x, 1.0, 1e-9);
-    EXPECT_NEAR(center.y, 1.0, 1e-9);
-}
-
-TEST(SquareTest, CopyWorks) {
-    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
-    Square<double> sq1(p1, p2, p3, p4);
-    Square<double> sq2(sq1);
-    EXPECT_NEAR(sq1.area(), sq2.area(), 1e-9);
-    EXPECT_TRUE(sq1 == sq2);
-}
-
-TEST(SquareTest, MoveWorks) {
-    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
-    Square<double> sq1(p1, p2, p3, p4);
-    double a = sq1.area();
-    Square<double> sq2(std::move(sq1));
-    EXPECT_NEAR(sq2.area(), a, 1e-9);
-}
-
-TEST(SquareTest, AssignWorks) {
-    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
-    Square<double> sq1(p1, p2, p3, p4);
-    Square<double> sq2;
-    sq2 = sq1;
-    EXPECT_NEAR(sq1.area(), sq2.area(), 1e-9);
-}
-
-TEST(SquareTest, MoveAssign) {
-    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
-    Square<double> sq1(p1, p2, p3, p4);
-    double a = sq1.area();
-    Square<double> sq2;
-    sq2 = std::move(sq1);
-    EXPECT_NEAR(sq2.area(), a, 1e-9);
-}
-
-TEST(SquareTest, EqualityCheck) {
-    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
-    Square<double> sq1(p1, p2, p3, p4);
-    Square<double> sq2(p1, p2, p3, p4);
-    EXPECT_TRUE(sq1 == sq2);
-}
-
-TEST(SquareTest, ConvertToDouble) {
-    Point<double> p1(0, 0), p2(2, 0), p3(2, 2), p4(0, 2);
-    Square<double> sq(p1, p2, p3, p4);
-    double a = static_cast<double>(sq);
-    EXPECT_NEAR(a, 4.0, 1e-9);
-}
-
-TEST(SquareTest, BadSquare) {
-    Point<double> p1(0, 0), p2(1, 0), p3(2, 0), p4(3, 0);
-    EXPECT_THROW(Square<double>(p1, p2, p3, p4), std::invalid_argument);
-}
-
-TEST(SquareTest, PrintCheck) {
-    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
-    Square<double> sq(p1, p2, p3, p4);
-    std::ostringstream oss;
-    oss << sq;
-    std::string s = oss.str();
-    EXPECT_FALSE(s.empty());
-    EXPECT_NE(s.find("Square"), std::string::npos);
-}
-
-// Rectangle tests
-TEST(RectangleTest, CreateRect) {
-    Point<double> p1(0, 0), p2(3, 0), p3(3, 2), p4(0, 2);
-    Rectangle<double> r(p1, p2, p3, p4);
-    EXPECT_NEAR(r.area(), 6.0, 1e-9);
-}
-
-TEST(RectangleTest, AreaCalc) {
-    Point<double> p1(0, 0), p2(4, 0), p3(4, 3), p4(0, 3);
-    Rectangle<double> r(p1, p2, p3, p4);
-    EXPECT_NEAR(r.area(), 12.0, 1e-9);
-}
-
-TEST(RectangleTest, CenterCalc) {
-    Point<double> p1(0, 0), p2(4, 0), p3(4, 2), p4(0, 2);
-    Rectangle<double> r(p1, p2, p3, p4);
-    Point<double> c = r.Center();
-    EXPECT_NEAR(c.x, 2.0, 1e-9);
-    EXPECT_NEAR(c.y, 1.0, 1e-9);
-}
-
-TEST(RectangleTest, CopyWorks) {
-    Point<double> p1(0, 0), p2(3, 0), p3(3, 2), p4(0, 2);
-    Rectangle<double> r1(p1, p2, p3, p4);
-    Rectangle<double> r2(r1);
-    EXPECT_NEAR(r1.area(), r2.area(), 1e-9);
-}
-
-TEST(RectangleTest, EqualityCheck) {
-    Point<double> p1(0, 0), p2(3, 0), p3(3, 2), p4(0, 2);
-    Rectangle<double> r1(p1, p2, p3, p4);
-    Rectangle<double> r2(p1, p2, p3, p4);
-    EXPECT_TRUE(r1 == r2);
-}
-
-TEST(RectangleTest, BadRect) {
-    Point<double> p1(0, 0), p2(1, 0), p3(2, 0), p4(3, 0);
-    EXPECT_THROW(Rectangle<double>(p1, p2, p3, p4), std::invalid_argument);
-}
-
-// Trapezoid tests
-TEST(TrapezoidTest, CreateTrap) {
-    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
-    Trapezoid<double> t(p1, p2, p3, p4);
-    EXPECT_GT(t.area(), 0.0);
-}
-
-TEST(TrapezoidTest, AreaCalc) {
-    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
-    Trapezoid<double> t(p1, p2, p3, p4);
-    EXPECT_NEAR(t.area(), 6.0, 1e-9);
-}
-
-TEST(TrapezoidTest, CenterCalc) {
-    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
-    Trapezoid<double> t(p1, p2, p3, p4);
-    Point<double> c = t.Center();
-    EXPECT_NEAR(c.x, 2.0, 1e-9);
-    EXPECT_NEAR(c.y, 1.0, 1e-9);
-}
-
-TEST(TrapezoidTest, CopyWorks) {
-    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
-    Trapezoid<double> t1(p1, p2, p3, p4);
-    Trapezoid<double> t2(t1);
-    EXPECT_NEAR(t1.area(), t2.area(), 1e-9);
-}
-
-TEST(TrapezoidTest, EqualityCheck) {
-    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
-    Trapezoid<double> t1(p1, p2, p3, p4);
-    Trapezoid<double> t2(p1, p2, p3, p4);
-    EXPECT_TRUE(t1 == t2);
-}
-
-TEST(TrapezoidTest, BadTrap) {
-    Point<double> p1(0, 0), p2(1, 0), p3(2, 0), p4(3, 0);
-    EXPECT_THROW(Trapezoid<double>(p1, p2, p3, p4), std::invalid_argument);
-}
-
-// Array tests
-TEST(ArrayTest, DefaultWorks) {
-    Array<int> arr;
-    EXPECT_EQ(arr.getSize(), 0);
-    EXPECT_TRUE(arr.isEmpty());
-}
-
-TEST(ArrayTest, CreateWithCapacity) {
-    Array<int> arr(10);
-    EXPECT_EQ(arr.getSize(), 0);
-    EXPECT_EQ(arr.getCapacity(), 10);
-}
-
-TEST(ArrayTest, AddElements) {
-    Array<int> arr;
-    arr.pushBack(1);
-    arr.pushBack(2);
-    arr.pushBack(3);
-    EXPECT_EQ(arr.getSize(), 3);
-    EXPECT_EQ(arr[0], 1);
-    EXPECT_EQ(arr[1], 2);
-    EXPECT_EQ(arr[2], 3);
-}
-
-TEST(ArrayTest, AutoResize) {
-    Array<int> arr(2);
-    arr.pushBack(1);
-    arr.pushBack(2);
-    arr.pushBack(3);
-    EXPECT_EQ(arr.getSize(), 3);
-    EXPECT_GE(arr.getCapacity(), 3);
-}
-
-TEST(ArrayTest, RemoveElement) {
-    Array<int> arr;
-    arr.pushBack(1);
-    arr.pushBack(2);
-    arr.pushBack(3);
-    arr.remove(1);
-    EXPECT_EQ(arr.getSize(), 2);
-    EXPECT_EQ(arr[0], 1);
-    EXPECT_EQ(arr[1], 3);
-}
-
-TEST(ArrayTest, RemoveBadIndex) {
-    Array<int> arr;
-    arr.pushBack(1);
-    EXPECT_THROW(arr.remove(5), std::out_of_range);
-}
-
-TEST(ArrayTest, ClearAll) {
-    Array<int> arr;
-    arr.pushBack(1);
-    arr.pushBack(2);
-    arr.pushBack(3);
-    arr.clear();
-    EXPECT_EQ(arr.getSize(), 0);
-    EXPECT_TRUE(arr.isEmpty());
-}
-
-TEST(ArrayTest, AccessByIndex) {
-    Array<int> arr;
-    arr.pushBack(10);
-    arr.pushBack(20);
-    EXPECT_EQ(arr[0], 10);
-    EXPECT_EQ(arr[1], 20);
-}
-
-TEST(ArrayTest, BadIndexAccess) {
-    Array<int> arr;
-    arr.pushBack(1);
-    EXPECT_THROW(arr[5], std::out_of_range);
-}
-
-TEST(ArrayTest, MoveWorks) {
-    Array<int> arr1;
-    arr1.pushBack(1);
-    arr1.pushBack(2);
-    Array<int> arr2(std::move(arr1));
-    EXPECT_EQ(arr2.getSize(), 2);
-    EXPECT_EQ(arr2[0], 1);
-    EXPECT_EQ(arr2[1], 2);
-    EXPECT_EQ(arr1.getSize(), 0);
-}
-
-TEST(ArrayTest, MoveAssign) {
-    Array<int> arr1;
-    arr1.pushBack(1);
-    arr1.pushBack(2);
-    Array<int> arr2;
-    arr2 = std::move(arr1);
-    EXPECT_EQ(arr2.getSize(), 2);
-    EXPECT_EQ(arr2[0], 1);
-    EXPECT_EQ(arr2[1], 2);
-    EXPECT_EQ(arr1.getSize(), 0);
-}
-
-// Array with figures
-TEST(ArrayWithFigures, AddSquares) {
-    Array<std::shared_ptr<Figure<double>>> figs;
-    auto s1 = std::make_shared<Square<double>>(
-        Point<double>(0, 0), Point<double>(1, 0),
-        Point<double>(1, 1), Point<double>(0, 1)
-    );
-    auto s2 = std::make_shared<Square<double>>(
-        Point<double>(0, 0), Point<double>(2, 0),
-        Point<double>(2, 2), Point<double>(0, 2)
-    );
-    figs.pushBack(s1);
-    figs.pushBack(s2);
-    EXPECT_EQ(figs.getSize(), 2);
-    EXPECT_NEAR(figs[0]->area(), 1.0, 1e-9);
-    EXPECT_NEAR(figs[1]->area(), 4.0, 1e-9);
-}
-
-TEST(ArrayWithFigures, MixedTypes) {
-    Array<std::shared_ptr<Figure<double>>> figs;
-    auto sq = std::make_shared<Square<double>>(
-        Point<double>(0, 0), Point<double>(1, 0),
-        Point<double>(1, 1), Point<double>(0, 1)
-    );
-    auto rc = std::make_shared<Rectangle<double>>(
-        Point<double>(0, 0), Point<double>(3, 0),
-        Point<double>(3, 2), Point<double>(0, 2)
-    );
-    auto tr = std::make_shared<Trapezoid<double>>(
-        Point<double>(0, 0), Point<double>(4, 0),
-        Point<double>(3, 2), Point<double>(1, 2)
-    );
-    figs.pushBack(sq);
-    figs.pushBack(rc);
-    figs.pushBack(tr);
-    EXPECT_EQ(figs.getSize(), 3);
-    double total = 0.0;
-    for (size_t i = 0; i < figs.getSize(); ++i) {
-        total += static_cast<double>(*figs[i]);
-    }
-    EXPECT_GT(total, 0.0);
-}
-
-TEST(ArrayWithFigures, RemoveFig) {
-    Array<std::shared_ptr<Figure<double>>> figs;
-    auto s1 = std::make_shared<Square<double>>(
-        Point<double>(0, 0), Point<double>(1, 0),
-        Point<double>(1, 1), Point<double>(0, 1)
-    );
-    auto s2 = std::make_shared<Square<double>>(
-        Point<double>(0, 0), Point<double>(2, 0),
-        Point<double>(2, 2), Point<double>(0, 2)
-    );
-    figs.pushBack(s1);
-    figs.pushBack(s2);
-    EXPECT_EQ(figs.getSize(), 2);
-    figs.remove(0);
-    EXPECT_EQ(figs.getSize(), 1);
-    EXPECT_NEAR(figs[0]->area(), 4.0, 1e-9);
-}
-
-TEST(ArrayWithFigures, ClearFigs) {
-    Array<std::shared_ptr<Figure<double>>> figs;
-    auto sq = std::make_shared<Square<double>>(
-        Point<double>(0, 0), Point<double>(1, 0),
-        Point<double>(1, 1), Point<double>(0, 1)
-    );
-    figs.pushBack(sq);
-    figs.pushBack(sq);
-    EXPECT_EQ(figs.getSize(), 2);
-    figs.clear();
-    EXPECT_EQ(figs.getSize(), 0);
-    EXPECT_TRUE(figs.isEmpty());
-}
-
-// Specific type arrays
-TEST(SpecificArrays, OnlySquares) {
-    Array<std::shared_ptr<Square<double>>> squares;
-    auto s1 = std::make_shared<Square<double>>(
-        Point<double>(0, 0), Point<double>(1, 0),
-        Point<double>(1, 1), Point<double>(0, 1)
-    );
-    auto s2 = std::make_shared<Square<double>>(
-        Point<double>(0, 0), Point<double>(2, 0),
-        Point<double>(2, 2), Point<double>(0, 2)
-    );
-    squares.pushBack(s1);
-    squares.pushBack(s2);
-    EXPECT_EQ(squares.getSize(), 2);
-    EXPECT_NEAR(squares[0]->area(), 1.0, 1e-9);
-    EXPECT_NEAR(squares[1]->area(), 4.0, 1e-9);
-}
-
-TEST(SpecificArrays, OnlyRectangles) {
-    Array<std::shared_ptr<Rectangle<double>>> rects;
-    auto r1 = std::make_shared<Rectangle<double>>(
-        Point<double>(0, 0), Point<double>(2, 0),
-        Point<double>(2, 1), Point<double>(0, 1)
-    );
-    auto r2 = std::make_shared<Rectangle<double>>(
-        Point<double>(0, 0), Point<double>(3, 0),
-        Point<double>(3, 2), Point<double>(0, 2)
-    );
-    rects.pushBack(r1);
-    rects.pushBack(r2);
-    EXPECT_EQ(rects.getSize(), 2);
-    EXPECT_NEAR(rects[0]->area(), 2.0, 1e-9);
-    EXPECT_NEAR(rects[1]->area(), 6.0, 1e-9);
-}
-
-// Clone tests
-TEST(CloneTest, SquareClone) {
-    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
-    Square<double> s1(p1, p2, p3, p4);
-    auto s2 = s1.clone();
-    EXPECT_NEAR(s1.area(), s2->area(), 1e-9);
-}
-
-TEST(CloneTest, RectClone) {
-    Point<double> p1(0, 0), p2(3, 0), p3(3, 2), p4(0, 2);
-    Rectangle<double> r1(p1, p2, p3, p4);
-    auto r2 = r1.clone();
-    EXPECT_NEAR(r1.area(), r2->area(), 1e-9);
-}
-
-TEST(CloneTest, TrapClone) {
-    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
-    Trapezoid<double> t1(p1, p2, p3, p4);
-    auto t2 = t1.clone();
-    EXPECT_NEAR(t1.area(), t2->area(), 1e-9);
-}
-
-// Integration test
-TEST(Integration, FullWorkflow) {
-    Array<std::shared_ptr<Figure<double>>> figs;
-    auto sq = std::make_shared<Square<double>>(
-        Point<double>(0, 0), Point<double>(1, 0),
-        Point<double>(1, 1), Point<double>(0, 1)
-    );
-    auto rc = std::make_shared<Rectangle<double>>(
-        Point<double>(0, 0), Point<double>(3, 0),
-        Point<double>(3, 2), Point<double>(0, 2)
-    );
-    auto tr = std::make_shared<Trapezoid<double>>(
-        Point<double>(0, 0), Point<double>(4, 0),
-        Point<double>(3, 2), Point<double>(1, 2)
-    );
-    figs.pushBack(sq);
-    figs.pushBack(rc);
-    figs.pushBack(tr);
-    EXPECT_EQ(figs.getSize(), 3);
-    double total = 0.0;
-    for (size_t i = 0; i < figs.getSize(); ++i) {
-        total += static_cast<double>(*figs[i]);
-    }
-    EXPECT_GT(total, 0.0);
-    figs.remove(1);
-    EXPECT_EQ(figs.getSize(), 2);
-    figs.clear();
-    EXPECT_TRUE(figs.isEmpty());
-}
-
-int main(int argc, char **argv) {
-    testing::InitGoogleTest(&argc, argv);
-    return RUN_ALL_TESTS();
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <cmath>
+#include <random>
+#include <filesystem>
+#include <atomic>
+#include <functional>
+#include <fstream>
+#include <thread>
+#include <limits>
+#include <sys/wait.h>
+
+#include "../point.h"
+#include "../figure.h"
+#include "../array.h"
+#include "../square.h"
+#include "../rectangle.h"
+#include "../trapez.h"
+#include "../figure_index.h"
+#include "../memory_usage.h"
+#include "../compact_store.h"
+#include "../aggregate_array.h"
+#include "../async.h"
+#include "../intersection.h"
+#include "../union_area.h"
+#include "../convex_hull.h"
+#include "../figure_parser.h"
+#include "../figure_journal.h"
+#include "../durable_store.h"
+#include "../partitioned_array.h"
+#include "../tile_pyramid.h"
+#include "../polygon.h"
+#include "../summation.h"
+#include "../workload.h"
+#include "../figure_server.h"
+#include "../chunked_array.h"
+#include "../figure_batch.h"
+#include "../figure_query.h"
+#include "../slot_map.h"
+#include "../shm_store.h"
+#include "../trace.h"
+
+// Point tests
+TEST(PointTest, DefaultConstructor) {
+    Point<double> p;
+    EXPECT_DOUBLE_EQ(p.x, 0.0);
+    EXPECT_DOUBLE_EQ(p.y, 0.0);
+}
+
+TEST(PointTest, ParameterizedConstructor) {
+    Point<double> p(3.5, 4.5);
+    EXPECT_DOUBLE_EQ(p.x, 3.5);
+    EXPECT_DOUBLE_EQ(p.y, 4.5);
+}
+
+TEST(PointTest, CopyWorks) {
+    Point<double> p1(3.5, 4.5);
+    Point<double> p2(p1);
+    EXPECT_DOUBLE_EQ(p2.x, 3.5);
+    EXPECT_DOUBLE_EQ(p2.y, 4.5);
+}
+
+TEST(PointTest, IntType) {
+    Point<int> p(3, 4);
+    EXPECT_EQ(p.x, 3);
+    EXPECT_EQ(p.y, 4);
+}
+
+// Square tests
+TEST(SquareTest, DefaultWorks) {
+    Square<double> sq;
+    EXPECT_NO_THROW(sq.Center());
+}
+
+TEST(SquareTest, CreateSquare) {
+    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
+    Square<double> sq(p1, p2, p3, p4);
+    EXPECT_NEAR(sq.area(), 1.0, 1e-9);
+}
+
+TEST(SquareTest, AreaCalc) {
+    Point<double> p1(0, 0), p2(2, 0), p3(2, 2), p4(0, 2);
+    Square<double> sq(p1, p2, p3, p4);
+    EXPECT_NEAR(sq.area(), 4.0, 1e-9);
+}
+
+TEST(SquareTest, CenterCalc) {
+    Point<double> p1(0, 0), p2(2, 0), p3(2, 2), p4(0, 2);
+    Square<double> sq(p1, p2, p3, p4);
+    Point<double> center = sq.Center();
+    EXPECT_NEAR(center.x, 1.0, 1e-9);
+    EXPECT_NEAR(center.y, 1.0, 1e-9);
+}
+
+TEST(SquareTest, CopyWorks) {
+    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
+    Square<double> sq1(p1, p2, p3, p4);
+    Square<double> sq2(sq1);
+    EXPECT_NEAR(sq1.area(), sq2.area(), 1e-9);
+    EXPECT_TRUE(sq1 == sq2);
+}
+
+TEST(SquareTest, MoveWorks) {
+    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
+    Square<double> sq1(p1, p2, p3, p4);
+    double a = sq1.area();
+    Square<double> sq2(std::move(sq1));
+    EXPECT_NEAR(sq2.area(), a, 1e-9);
+}
+
+TEST(SquareTest, AssignWorks) {
+    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
+    Square<double> sq1(p1, p2, p3, p4);
+    Square<double> sq2;
+    sq2 = sq1;
+    EXPECT_NEAR(sq1.area(), sq2.area(), 1e-9);
+}
+
+TEST(SquareTest, MoveAssign) {
+    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
+    Square<double> sq1(p1, p2, p3, p4);
+    double a = sq1.area();
+    Square<double> sq2;
+    sq2 = std::move(sq1);
+    EXPECT_NEAR(sq2.area(), a, 1e-9);
+}
+
+TEST(SquareTest, EqualityCheck) {
+    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
+    Square<double> sq1(p1, p2, p3, p4);
+    Square<double> sq2(p1, p2, p3, p4);
+    EXPECT_TRUE(sq1 == sq2);
+}
+
+TEST(SquareTest, ConvertToDouble) {
+    Point<double> p1(0, 0), p2(2, 0), p3(2, 2), p4(0, 2);
+    Square<double> sq(p1, p2, p3, p4);
+    double a = static_cast<double>(sq);
+    EXPECT_NEAR(a, 4.0, 1e-9);
+}
+
+TEST(SquareTest, BadSquare) {
+    Point<double> p1(0, 0), p2(1, 0), p3(2, 0), p4(3, 0);
+    EXPECT_THROW(Square<double>(p1, p2, p3, p4), std::invalid_argument);
+}
+
+TEST(SquareTest, PrintCheck) {
+    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
+    Square<double> sq(p1, p2, p3, p4);
+    std::ostringstream oss;
+    oss << sq;
+    std::string s = oss.str();
+    EXPECT_FALSE(s.empty());
+    EXPECT_NE(s.find("Square"), std::string::npos);
+}
+
+// Rectangle tests
+TEST(RectangleTest, CreateRect) {
+    Point<double> p1(0, 0), p2(3, 0), p3(3, 2), p4(0, 2);
+    Rectangle<double> r(p1, p2, p3, p4);
+    EXPECT_NEAR(r.area(), 6.0, 1e-9);
+}
+
+TEST(RectangleTest, AreaCalc) {
+    Point<double> p1(0, 0), p2(4, 0), p3(4, 3), p4(0, 3);
+    Rectangle<double> r(p1, p2, p3, p4);
+    EXPECT_NEAR(r.area(), 12.0, 1e-9);
+}
+
+TEST(RectangleTest, CenterCalc) {
+    Point<double> p1(0, 0), p2(4, 0), p3(4, 2), p4(0, 2);
+    Rectangle<double> r(p1, p2, p3, p4);
+    Point<double> c = r.Center();
+    EXPECT_NEAR(c.x, 2.0, 1e-9);
+    EXPECT_NEAR(c.y, 1.0, 1e-9);
+}
+
+TEST(RectangleTest, CopyWorks) {
+    Point<double> p1(0, 0), p2(3, 0), p3(3, 2), p4(0, 2);
+    Rectangle<double> r1(p1, p2, p3, p4);
+    Rectangle<double> r2(r1);
+    EXPECT_NEAR(r1.area(), r2.area(), 1e-9);
+}
+
+TEST(RectangleTest, EqualityCheck) {
+    Point<double> p1(0, 0), p2(3, 0), p3(3, 2), p4(0, 2);
+    Rectangle<double> r1(p1, p2, p3, p4);
+    Rectangle<double> r2(p1, p2, p3, p4);
+    EXPECT_TRUE(r1 == r2);
+}
+
+TEST(RectangleTest, BadRect) {
+    Point<double> p1(0, 0), p2(1, 0), p3(2, 0), p4(3, 0);
+    EXPECT_THROW(Rectangle<double>(p1, p2, p3, p4), std::invalid_argument);
+}
+
+// Trapezoid tests
+TEST(TrapezoidTest, CreateTrap) {
+    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
+    Trapezoid<double> t(p1, p2, p3, p4);
+    EXPECT_GT(t.area(), 0.0);
+}
+
+TEST(TrapezoidTest, AreaCalc) {
+    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
+    Trapezoid<double> t(p1, p2, p3, p4);
+    EXPECT_NEAR(t.area(), 6.0, 1e-9);
+}
+
+TEST(TrapezoidTest, CenterCalc) {
+    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
+    Trapezoid<double> t(p1, p2, p3, p4);
+    Point<double> c = t.Center();
+    EXPECT_NEAR(c.x, 2.0, 1e-9);
+    EXPECT_NEAR(c.y, 1.0, 1e-9);
+}
+
+TEST(TrapezoidTest, CopyWorks) {
+    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
+    Trapezoid<double> t1(p1, p2, p3, p4);
+    Trapezoid<double> t2(t1);
+    EXPECT_NEAR(t1.area(), t2.area(), 1e-9);
+}
+
+TEST(TrapezoidTest, EqualityCheck) {
+    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
+    Trapezoid<double> t1(p1, p2, p3, p4);
+    Trapezoid<double> t2(p1, p2, p3, p4);
+    EXPECT_TRUE(t1 == t2);
+}
+
+TEST(TrapezoidTest, BadTrap) {
+    Point<double> p1(0, 0), p2(1, 0), p3(2, 0), p4(3, 0);
+    EXPECT_THROW(Trapezoid<double>(p1, p2, p3, p4), std::invalid_argument);
+}
+
+// Array tests
+TEST(ArrayTest, DefaultWorks) {
+    Array<int> arr;
+    EXPECT_EQ(arr.getSize(), 0);
+    EXPECT_TRUE(arr.isEmpty());
+}
+
+TEST(ArrayTest, CreateWithCapacity) {
+    Array<int> arr(10);
+    EXPECT_EQ(arr.getSize(), 0);
+    EXPECT_EQ(arr.getCapacity(), 10);
+}
+
+TEST(ArrayTest, AddElements) {
+    Array<int> arr;
+    arr.pushBack(1);
+    arr.pushBack(2);
+    arr.pushBack(3);
+    EXPECT_EQ(arr.getSize(), 3);
+    EXPECT_EQ(arr[0], 1);
+    EXPECT_EQ(arr[1], 2);
+    EXPECT_EQ(arr[2], 3);
+}
+
+TEST(ArrayTest, AutoResize) {
+    Array<int> arr(2);
+    arr.pushBack(1);
+    arr.pushBack(2);
+    arr.pushBack(3);
+    EXPECT_EQ(arr.getSize(), 3);
+    EXPECT_GE(arr.getCapacity(), 3);
+}
+
+TEST(ArrayTest, RemoveElement) {
+    Array<int> arr;
+    arr.pushBack(1);
+    arr.pushBack(2);
+    arr.pushBack(3);
+    arr.remove(1);
+    EXPECT_EQ(arr.getSize(), 2);
+    EXPECT_EQ(arr[0], 1);
+    EXPECT_EQ(arr[1], 3);
+}
+
+TEST(ArrayTest, RemoveBadIndex) {
+    Array<int> arr;
+    arr.pushBack(1);
+    EXPECT_THROW(arr.remove(5), std::out_of_range);
+}
+
+TEST(ArrayTest, ClearAll) {
+    Array<int> arr;
+    arr.pushBack(1);
+    arr.pushBack(2);
+    arr.pushBack(3);
+    arr.clear();
+    EXPECT_EQ(arr.getSize(), 0);
+    EXPECT_TRUE(arr.isEmpty());
+}
+
+TEST(ArrayTest, AccessByIndex) {
+    Array<int> arr;
+    arr.pushBack(10);
+    arr.pushBack(20);
+    EXPECT_EQ(arr[0], 10);
+    EXPECT_EQ(arr[1], 20);
+}
+
+TEST(ArrayTest, BadIndexAccess) {
+    Array<int> arr;
+    arr.pushBack(1);
+    EXPECT_THROW(arr[5], std::out_of_range);
+}
+
+TEST(ArrayTest, MoveWorks) {
+    Array<int> arr1;
+    arr1.pushBack(1);
+    arr1.pushBack(2);
+    Array<int> arr2(std::move(arr1));
+    EXPECT_EQ(arr2.getSize(), 2);
+    EXPECT_EQ(arr2[0], 1);
+    EXPECT_EQ(arr2[1], 2);
+    EXPECT_EQ(arr1.getSize(), 0);
+}
+
+TEST(ArrayTest, MoveAssign) {
+    Array<int> arr1;
+    arr1.pushBack(1);
+    arr1.pushBack(2);
+    Array<int> arr2;
+    arr2 = std::move(arr1);
+    EXPECT_EQ(arr2.getSize(), 2);
+    EXPECT_EQ(arr2[0], 1);
+    EXPECT_EQ(arr2[1], 2);
+    EXPECT_EQ(arr1.getSize(), 0);
+}
+
+// Array with figures
+TEST(ArrayWithFigures, AddSquares) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    auto s1 = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0),
+        Point<double>(1, 1), Point<double>(0, 1)
+    );
+    auto s2 = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(2, 0),
+        Point<double>(2, 2), Point<double>(0, 2)
+    );
+    figs.pushBack(s1);
+    figs.pushBack(s2);
+    EXPECT_EQ(figs.getSize(), 2);
+    EXPECT_NEAR(figs[0]->area(), 1.0, 1e-9);
+    EXPECT_NEAR(figs[1]->area(), 4.0, 1e-9);
+}
+
+TEST(ArrayWithFigures, MixedTypes) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    auto sq = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0),
+        Point<double>(1, 1), Point<double>(0, 1)
+    );
+    auto rc = std::make_shared<Rectangle<double>>(
+        Point<double>(0, 0), Point<double>(3, 0),
+        Point<double>(3, 2), Point<double>(0, 2)
+    );
+    auto tr = std::make_shared<Trapezoid<double>>(
+        Point<double>(0, 0), Point<double>(4, 0),
+        Point<double>(3, 2), Point<double>(1, 2)
+    );
+    figs.pushBack(sq);
+    figs.pushBack(rc);
+    figs.pushBack(tr);
+    EXPECT_EQ(figs.getSize(), 3);
+    double total = 0.0;
+    for (size_t i = 0; i < figs.getSize(); ++i) {
+        total += static_cast<double>(*figs[i]);
+    }
+    EXPECT_GT(total, 0.0);
+}
+
+TEST(ArrayWithFigures, RemoveFig) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    auto s1 = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0),
+        Point<double>(1, 1), Point<double>(0, 1)
+    );
+    auto s2 = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(2, 0),
+        Point<double>(2, 2), Point<double>(0, 2)
+    );
+    figs.pushBack(s1);
+    figs.pushBack(s2);
+    EXPECT_EQ(figs.getSize(), 2);
+    figs.remove(0);
+    EXPECT_EQ(figs.getSize(), 1);
+    EXPECT_NEAR(figs[0]->area(), 4.0, 1e-9);
+}
+
+TEST(ArrayWithFigures, ClearFigs) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    auto sq = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0),
+        Point<double>(1, 1), Point<double>(0, 1)
+    );
+    figs.pushBack(sq);
+    figs.pushBack(sq);
+    EXPECT_EQ(figs.getSize(), 2);
+    figs.clear();
+    EXPECT_EQ(figs.getSize(), 0);
+    EXPECT_TRUE(figs.isEmpty());
+}
+
+// Specific type arrays
+TEST(SpecificArrays, OnlySquares) {
+    Array<std::shared_ptr<Square<double>>> squares;
+    auto s1 = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0),
+        Point<double>(1, 1), Point<double>(0, 1)
+    );
+    auto s2 = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(2, 0),
+        Point<double>(2, 2), Point<double>(0, 2)
+    );
+    squares.pushBack(s1);
+    squares.pushBack(s2);
+    EXPECT_EQ(squares.getSize(), 2);
+    EXPECT_NEAR(squares[0]->area(), 1.0, 1e-9);
+    EXPECT_NEAR(squares[1]->area(), 4.0, 1e-9);
+}
+
+TEST(SpecificArrays, OnlyRectangles) {
+    Array<std::shared_ptr<Rectangle<double>>> rects;
+    auto r1 = std::make_shared<Rectangle<double>>(
+        Point<double>(0, 0), Point<double>(2, 0),
+        Point<double>(2, 1), Point<double>(0, 1)
+    );
+    auto r2 = std::make_shared<Rectangle<double>>(
+        Point<double>(0, 0), Point<double>(3, 0),
+        Point<double>(3, 2), Point<double>(0, 2)
+    );
+    rects.pushBack(r1);
+    rects.pushBack(r2);
+    EXPECT_EQ(rects.getSize(), 2);
+    EXPECT_NEAR(rects[0]->area(), 2.0, 1e-9);
+    EXPECT_NEAR(rects[1]->area(), 6.0, 1e-9);
+}
+
+// Clone tests
+TEST(CloneTest, SquareClone) {
+    Point<double> p1(0, 0), p2(1, 0), p3(1, 1), p4(0, 1);
+    Square<double> s1(p1, p2, p3, p4);
+    auto s2 = s1.clone();
+    EXPECT_NEAR(s1.area(), s2->area(), 1e-9);
+}
+
+TEST(CloneTest, RectClone) {
+    Point<double> p1(0, 0), p2(3, 0), p3(3, 2), p4(0, 2);
+    Rectangle<double> r1(p1, p2, p3, p4);
+    auto r2 = r1.clone();
+    EXPECT_NEAR(r1.area(), r2->area(), 1e-9);
+}
+
+TEST(CloneTest, TrapClone) {
+    Point<double> p1(0, 0), p2(4, 0), p3(3, 2), p4(1, 2);
+    Trapezoid<double> t1(p1, p2, p3, p4);
+    auto t2 = t1.clone();
+    EXPECT_NEAR(t1.area(), t2->area(), 1e-9);
+}
+
+// Integration test
+TEST(Integration, FullWorkflow) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    auto sq = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0),
+        Point<double>(1, 1), Point<double>(0, 1)
+    );
+    auto rc = std::make_shared<Rectangle<double>>(
+        Point<double>(0, 0), Point<double>(3, 0),
+        Point<double>(3, 2), Point<double>(0, 2)
+    );
+    auto tr = std::make_shared<Trapezoid<double>>(
+        Point<double>(0, 0), Point<double>(4, 0),
+        Point<double>(3, 2), Point<double>(1, 2)
+    );
+    figs.pushBack(sq);
+    figs.pushBack(rc);
+    figs.pushBack(tr);
+    EXPECT_EQ(figs.getSize(), 3);
+    double total = 0.0;
+    for (size_t i = 0; i < figs.getSize(); ++i) {
+        total += static_cast<double>(*figs[i]);
+    }
+    EXPECT_GT(total, 0.0);
+    figs.remove(1);
+    EXPECT_EQ(figs.getSize(), 2);
+    figs.clear();
+    EXPECT_TRUE(figs.isEmpty());
+}
+
+// FigureKey / FigureIndex tests
+TEST(FigureKeyTest, SameForRotatedVertexOrder) {
+    Square<double> a(Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1));
+    Square<double> b(Point<double>(1, 1), Point<double>(0, 1), Point<double>(0, 0), Point<double>(1, 0));
+    Square<double> c(Point<double>(0, 1), Point<double>(1, 1), Point<double>(1, 0), Point<double>(0, 0));
+    EXPECT_TRUE(makeFigureKey(a) == makeFigureKey(b));
+    EXPECT_TRUE(makeFigureKey(a) == makeFigureKey(c));
+    EXPECT_EQ(FigureKeyHash{}(makeFigureKey(a)), FigureKeyHash{}(makeFigureKey(c)));
+}
+
+TEST(FigureKeyTest, DiffersForSameAreaOtherPlace) {
+    Square<double> a(Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1));
+    Square<double> b(Point<double>(5, 5), Point<double>(6, 5), Point<double>(6, 6), Point<double>(5, 6));
+    EXPECT_TRUE(a == b);
+    EXPECT_FALSE(makeFigureKey(a) == makeFigureKey(b));
+}
+
+TEST(FigureKeyTest, NearDuplicateWithinEps) {
+    Square<double> a(Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1));
+    Square<double> b(Point<double>(1e-5, 0), Point<double>(1, 1e-5), Point<double>(1, 1), Point<double>(0, 1));
+    EXPECT_TRUE(makeFigureKey(a, 1e-3) == makeFigureKey(b, 1e-3));
+    EXPECT_FALSE(makeFigureKey(a, 1e-9) == makeFigureKey(b, 1e-9));
+}
+
+TEST(FigureIndexTest, FindAfterBuild) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    for (int i = 0; i < 100; ++i) {
+        figs.pushBack(std::make_shared<Square<double>>(
+            Point<double>(i, 0), Point<double>(i + 1, 0),
+            Point<double>(i + 1, 1), Point<double>(i, 1)));
+    }
+    FigureIndex<double> index;
+    index.build(figs);
+    EXPECT_EQ(index.getSize(), 100);
+
+    Rectangle<double> probe(Point<double>(43, 1), Point<double>(42, 1), Point<double>(42, 0), Point<double>(43, 0));
+    auto found = index.find(probe);
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(*found, 42);
+
+    Square<double> missing(Point<double>(0, 5), Point<double>(1, 5), Point<double>(1, 6), Point<double>(0, 6));
+    EXPECT_FALSE(index.find(missing).has_value());
+}
+
+TEST(FigureIndexTest, RemoveDuplicates) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    auto sq = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1));
+    auto tr = std::make_shared<Trapezoid<double>>(
+        Point<double>(0, 0), Point<double>(4, 0), Point<double>(3, 2), Point<double>(1, 2));
+    figs.pushBack(sq);
+    figs.pushBack(tr);
+    figs.pushBack(sq->clone());
+    figs.pushBack(tr);
+    EXPECT_EQ(removeDuplicates(figs), 2);
+    EXPECT_EQ(figs.getSize(), 2);
+    EXPECT_EQ(figs[0], sq);
+    EXPECT_EQ(figs[1], tr);
+}
+
+TEST(FigureIndexTest, NearDuplicatesAcrossCellBoundary) {
+    const double eps = 1e-3;
+    auto square = [](double x, double y) {
+        return std::make_shared<Square<double>>(Point<double>(x, y), Point<double>(x + 1, y),
+                                                Point<double>(x + 1, y + 1), Point<double>(x, y + 1));
+    };
+    // Среднее вершин a лежит у самой границы ячейки 2 * eps, у b — сразу за ней по обеим осям.
+    auto a = square(0.0019999, 0.0019999);
+    auto b = square(0.0020001, 0.0020001);
+    EXPECT_FALSE(makeFigureKey(*a, eps) == makeFigureKey(*b, eps));
+
+    FigureIndex<double> index(eps);
+    EXPECT_FALSE(index.insert(*a, 7).has_value());
+    ASSERT_TRUE(index.find(*b).has_value());
+    EXPECT_EQ(*index.find(*b), 7u);
+
+    // Тот же ключ, но вершины далеко: повернутый квадрат с тем же центром не дубликат.
+    Square<double> diamond(Point<double>(0.5019, -0.2052), Point<double>(1.209, 0.5019),
+                           Point<double>(0.5019, 1.209), Point<double>(-0.2052, 0.5019));
+    EXPECT_TRUE(makeFigureKey(diamond, eps) == makeFigureKey(*a, eps));
+    EXPECT_FALSE(index.find(diamond).has_value());
+    EXPECT_FALSE(index.find(*square(0.0035, 0.002)).has_value());
+
+    Array<std::shared_ptr<Figure<double>>> figs;
+    figs.pushBack(a);
+    figs.pushBack(b);
+    figs.pushBack(square(0.0035, 0.002));
+    EXPECT_EQ(removeDuplicates(figs, eps), 1);
+    EXPECT_EQ(figs.getSize(), 2);
+    EXPECT_EQ(figs[0], a);
+}
+
+// Memory usage / compact storage tests
+TEST(MemoryUsageTest, ArrayCountsCapacity) {
+    Array<int> arr(10);
+    EXPECT_EQ(arr.memoryUsage(), sizeof(arr) + 10 * sizeof(int));
+}
+
+TEST(MemoryUsageTest, FiguresCountedOnce) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    auto sq = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1));
+    figs.pushBack(sq);
+    size_t single = memoryUsage(figs);
+    EXPECT_EQ(single, figs.memoryUsage() + SharedControlBlockBytes + sq->memoryUsage());
+    figs.pushBack(sq);
+    EXPECT_EQ(memoryUsage(figs), figs.memoryUsage() + SharedControlBlockBytes + sq->memoryUsage());
+    EXPECT_GE(sq->memoryUsage(), sizeof(*sq) + 4 * sizeof(Point<double>));
+}
+
+Array<std::shared_ptr<Figure<double>>> makeScatteredFigures(size_t n) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    for (size_t i = 0; i < n; ++i) {
+        double x = std::fmod(i * 37.17, 2000.0) - 1000.0;
+        double y = std::fmod(i * 91.31, 1500.0) - 700.0;
+        double w = 1.0 + std::fmod(i * 0.37, 9.0);
+        if (i % 2 == 0) {
+            figs.pushBack(std::make_shared<Rectangle<double>>(
+                Point<double>(x, y), Point<double>(x + w, y),
+                Point<double>(x + w, y + 2 * w), Point<double>(x, y + 2 * w)));
+        } else {
+            figs.pushBack(std::make_shared<Trapezoid<double>>(
+                Point<double>(x, y), Point<double>(x + 4 * w, y),
+                Point<double>(x + 3 * w, y + w), Point<double>(x + w, y + w)));
+        }
+    }
+    return figs;
+}
+
+template<typename Coord>
+void checkCompactErrorBounds(const Array<std::shared_ptr<Figure<double>>>& figs) {
+    auto store = CompactFigureStore<Coord>::fromFigures(figs);
+    ASSERT_EQ(store.getSize(), figs.getSize());
+    double e = store.coordinateErrorBound();
+    for (size_t i = 0; i < figs.getSize(); ++i) {
+        for (size_t v = 0; v < 4; ++v) {
+            Point<double> original = figs[i]->getVertex(v);
+            Point<double> widened = store.getVertex(i, v);
+            EXPECT_LE(std::abs(original.x - widened.x), e);
+            EXPECT_LE(std::abs(original.y - widened.y), e);
+        }
+        EXPECT_LE(std::abs(figs[i]->area() - store.area(i)), store.areaErrorBound(i));
+        EXPECT_EQ(store.getKind(i), figureKind(*figs[i]));
+    }
+}
+
+TEST(CompactStoreTest, FloatErrorBound) {
+    checkCompactErrorBounds<float>(makeScatteredFigures(1000));
+}
+
+TEST(CompactStoreTest, Int16ErrorBound) {
+    checkCompactErrorBounds<int16_t>(makeScatteredFigures(1000));
+}
+
+TEST(CompactStoreTest, RoundTripFigure) {
+    auto figs = makeScatteredFigures(10);
+    auto store = CompactFigureStore<float>::fromFigures(figs);
+    auto restored = store.figure(3);
+    EXPECT_NEAR(restored->area(), figs[3]->area(), store.areaErrorBound(3));
+    EXPECT_EQ(figureKind(*restored), FigureKind::Trapezoid);
+}
+
+TEST(CompactStoreTest, FloatNonUnitStep) {
+    auto figs = makeScatteredFigures(100);
+    CompactFigureStore<float> store(10.0, -20.0, 0.5);
+    double area = 0.0;
+    for (size_t i = 0; i < figs.getSize(); ++i) {
+        store.pushBack(*figs[i]);
+        area += figs[i]->area();
+    }
+    double bound = store.coordinateErrorBound();
+    for (size_t i = 0; i < figs.getSize(); ++i) {
+        for (size_t v = 0; v < 4; ++v) {
+            EXPECT_NEAR(store.getVertex(i, v).x, figs[i]->getVertex(v).x, bound);
+            EXPECT_NEAR(store.getVertex(i, v).y, figs[i]->getVertex(v).y, bound);
+        }
+        EXPECT_NEAR(store.area(i), figs[i]->area(), store.areaErrorBound(i));
+    }
+    EXPECT_NEAR(store.totalArea(), area, 1e-6 * area);
+}
+
+TEST(CompactStoreTest, Int16OutOfRange) {
+    CompactFigureStore<int16_t> store(0.0, 0.0, 1.0);
+    Square<double> far(Point<double>(40000, 0), Point<double>(40001, 0),
+                       Point<double>(40001, 1), Point<double>(40000, 1));
+    EXPECT_THROW(store.pushBack(far), std::out_of_range);
+    EXPECT_TRUE(store.isEmpty());
+}
+
+TEST(CompactStoreTest, TenTimesSmaller) {
+    auto figs = makeScatteredFigures(1000);
+    auto store = CompactFigureStore<int16_t>::fromFigures(figs);
+    EXPECT_GE(memoryUsage(figs), 10 * store.memoryUsage());
+}
+
+// AggregateArray tests
+TEST(AggregateArrayTest, TracksInsertRemoveClear) {
+    AggregateArray<double> agg;
+    agg.pushBack(std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1)));
+    agg.pushBack(std::make_shared<Rectangle<double>>(
+        Point<double>(-2, 0), Point<double>(1, 0), Point<double>(1, 2), Point<double>(-2, 2)));
+    agg.pushBack(std::make_shared<Trapezoid<double>>(
+        Point<double>(0, 0), Point<double>(4, 0), Point<double>(3, 2), Point<double>(1, 2)));
+
+    EXPECT_NEAR(agg.totalArea(), 13.0, 1e-12);
+    EXPECT_EQ(agg.count(FigureKind::Square), 1);
+    EXPECT_EQ(agg.count(FigureKind::Trapezoid), 1);
+    EXPECT_NEAR(agg.minArea(), 1.0, 1e-12);
+    EXPECT_NEAR(agg.maxArea(), 6.0, 1e-12);
+    BoundingBox<double> box = agg.boundingBox();
+    EXPECT_DOUBLE_EQ(box.minX, -2.0);
+    EXPECT_DOUBLE_EQ(box.maxX, 4.0);
+    EXPECT_DOUBLE_EQ(box.maxY, 2.0);
+
+    agg.remove(1);
+    EXPECT_NEAR(agg.totalArea(), 7.0, 1e-12);
+    EXPECT_EQ(agg.count(FigureKind::Rectangle), 0);
+    EXPECT_DOUBLE_EQ(agg.boundingBox().minX, 0.0);
+
+    agg.clear();
+    EXPECT_TRUE(agg.isEmpty());
+    EXPECT_DOUBLE_EQ(agg.totalArea(), 0.0);
+    EXPECT_THROW(agg.minArea(), std::logic_error);
+}
+
+TEST(AggregateArrayTest, MatchesFullRescan) {
+    AggregateArray<double> agg;
+    auto scattered = makeScatteredFigures(500);
+    size_t seed = 12345;
+    for (int step = 0; step < 5000; ++step) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        if (agg.getSize() > 0 && (seed >> 33) % 3 == 0) {
+            agg.remove((seed >> 20) % agg.getSize());
+        } else {
+            agg.pushBack(scattered[(seed >> 40) % scattered.getSize()]);
+        }
+        if (step % 250 == 0 && !agg.isEmpty()) {
+            double total = 0.0, minA = agg[0]->area(), maxA = minA;
+            BoundingBox<double> box = boundingBox(*agg[0]);
+            size_t squares = 0;
+            for (size_t i = 0; i < agg.getSize(); ++i) {
+                total += agg[i]->area();
+                minA = std::min(minA, agg[i]->area());
+                maxA = std::max(maxA, agg[i]->area());
+                box.expand(boundingBox(*agg[i]));
+                squares += figureKind(*agg[i]) == FigureKind::Square;
+            }
+            EXPECT_NEAR(agg.totalArea(), total, 1e-9 * total);
+            EXPECT_DOUBLE_EQ(agg.minArea(), minA);
+            EXPECT_DOUBLE_EQ(agg.maxArea(), maxA);
+            EXPECT_DOUBLE_EQ(agg.boundingBox().minX, box.minX);
+            EXPECT_DOUBLE_EQ(agg.boundingBox().maxY, box.maxY);
+            EXPECT_EQ(agg.count(FigureKind::Square), squares);
+        }
+    }
+}
+
+TEST(AggregateArrayTest, LazyHeapStaysBoundedUnderChurn) {
+    // Удаляются в основном значения не с вершины: без перестройки они копились бы бесконечно.
+    LazyHeap<int, std::greater<int>> heap;
+    std::vector<int> live;
+    std::mt19937 rng(28);
+    for (int i = 0; i < 100; ++i) {
+        live.push_back(static_cast<int>(rng() % 1000));
+        heap.push(live.back());
+    }
+    size_t maxStored = 0;
+    for (int step = 0; step < 100000; ++step) {
+        size_t victim = rng() % live.size();
+        heap.erase(live[victim]);
+        live[victim] = static_cast<int>(rng() % 1000);
+        heap.push(live[victim]);
+        maxStored = std::max(maxStored, heap.getStoredCount());
+        if (step % 1000 == 0) {
+            EXPECT_EQ(heap.top(), *std::min_element(live.begin(), live.end()));
+        }
+    }
+    EXPECT_LE(maxStored, 3 * live.size() + 1);
+}
+
+TEST(AggregateArrayTest, CompensatedSumDoesNotDrift) {
+    NeumaierSum sum;
+    sum.add(1e16);
+    for (int i = 0; i < 1000; ++i) {
+        sum.add(1.0);
+    }
+    sum.add(-1e16);
+    EXPECT_DOUBLE_EQ(sum.value(), 1000.0);
+}
+
+// Coroutine layer tests
+Task<int> addOnPool(ThreadPool& pool, int a, int b) {
+    co_await pool.schedule();
+    co_return a + b;
+}
+
+Task<int> failOnPool(ThreadPool& pool) {
+    co_await pool.schedule();
+    throw std::runtime_error("boom");
+    co_return 0;
+}
+
+Task<int> sumOfTasks(ThreadPool& pool) {
+    Task<int> a = addOnPool(pool, 1, 2);
+    Task<int> b = addOnPool(pool, 3, 4);
+    co_return co_await a + co_await b;
+}
+
+Generator<int> countTo(int n) {
+    for (int i = 1; i <= n; ++i) {
+        co_yield i;
+    }
+}
+
+TEST(AsyncTest, TaskRunsOnPool) {
+    ThreadPool pool(2);
+    EXPECT_EQ(syncWait(addOnPool(pool, 2, 3)), 5);
+    EXPECT_EQ(syncWait(sumOfTasks(pool)), 10);
+}
+
+TEST(AsyncTest, TaskPropagatesException) {
+    ThreadPool pool(1);
+    EXPECT_THROW(syncWait(failOnPool(pool)), std::runtime_error);
+}
+
+TEST(AsyncTest, GeneratorYieldsInOrder) {
+    int expected = 1;
+    for (int value : countTo(5)) {
+        EXPECT_EQ(value, expected++);
+    }
+    EXPECT_EQ(expected, 6);
+}
+
+TEST(AsyncTest, QueriesMatchSequential) {
+    ThreadPool pool(3);
+    auto figs = makeScatteredFigures(2000);
+    double total = 0.0;
+    std::vector<size_t> expected;
+    BoundingBox<double> box{-100.0, -100.0, 200.0, 50.0};
+    for (size_t i = 0; i < figs.getSize(); ++i) {
+        total += figs[i]->area();
+        if (boundingBox(*figs[i]).intersects(box)) {
+            expected.push_back(i);
+        }
+    }
+    EXPECT_NEAR(syncWait(totalAreaAsync(pool, figs, 100)), total, 1e-9 * total);
+    EXPECT_EQ(syncWait(rangeQueryAsync(pool, figs, box, 100)), expected);
+}
+
+TEST(AsyncTest, BatchReaderMatchesSyncRead) {
+    auto figs = makeScatteredFigures(500);
+    std::stringstream text;
+    writeFigures(text, figs);
+
+    ThreadPool pool(2);
+    std::istringstream input(text.str());
+    size_t count = 0, batches = 0;
+    for (auto& batch : readFigureBatches<double>(pool, input, 1024)) {
+        ++batches;
+        for (size_t i = 0; i < batch.getSize(); ++i, ++count) {
+            EXPECT_EQ(figureKind(*batch[i]), figureKind(*figs[count]));
+            EXPECT_DOUBLE_EQ(batch[i]->area(), figs[count]->area());
+        }
+    }
+    EXPECT_EQ(count, figs.getSize());
+    EXPECT_GT(batches, 1);
+}
+
+TEST(AsyncTest, BatchReaderReportsFileOffsets) {
+    auto figs = makeScatteredFigures(500);
+    std::stringstream text;
+    writeFigures(text, figs);
+    std::string content = text.str();
+    size_t bad = content.rfind('\n', content.size() - 2) + 1;
+    content.insert(bad, "X ");
+
+    ThreadPool pool(2);
+    std::istringstream input(content);
+    try {
+        for (auto& batch : readFigureBatches<double>(pool, input, 1024)) {
+            (void)batch;
+        }
+        FAIL() << "ожидалась ParseError";
+    } catch (const ParseError& err) {
+        EXPECT_GT(bad, 1024u);
+        EXPECT_EQ(err.position(), bad);
+    }
+}
+
+// Intersection tests
+TEST(IntersectionTest, OverlappingSquares) {
+    Square<double> a(Point<double>(0, 0), Point<double>(2, 0), Point<double>(2, 2), Point<double>(0, 2));
+    Square<double> b(Point<double>(1, 1), Point<double>(1, 3), Point<double>(3, 3), Point<double>(3, 1));
+    EXPECT_NEAR(intersectionArea(a, b), 1.0, 1e-12);
+    EXPECT_NEAR(intersectionArea(b, a), 1.0, 1e-12);
+}
+
+TEST(IntersectionTest, DisjointAndContained) {
+    Square<double> a(Point<double>(0, 0), Point<double>(4, 0), Point<double>(4, 4), Point<double>(0, 4));
+    Square<double> far(Point<double>(10, 10), Point<double>(11, 10), Point<double>(11, 11), Point<double>(10, 11));
+    Trapezoid<double> inside(Point<double>(1, 1), Point<double>(3, 1), Point<double>(2.5, 2), Point<double>(1.5, 2));
+    EXPECT_DOUBLE_EQ(intersectionArea(a, far), 0.0);
+    EXPECT_NEAR(intersectionArea(a, inside), inside.area(), 1e-12);
+}
+
+TEST(IntersectionTest, RotatedSquare) {
+    Square<double> a(Point<double>(-1, -1), Point<double>(1, -1), Point<double>(1, 1), Point<double>(-1, 1));
+    Square<double> diamond(Point<double>(0, -1), Point<double>(1, 0), Point<double>(0, 1), Point<double>(-1, 0));
+    EXPECT_NEAR(intersectionArea(a, diamond), 2.0, 1e-12);
+}
+
+TEST(IntersectionTest, FindIntersectionsMatchesBruteForce) {
+    auto figs = makeScatteredFigures(300);
+    IntersectionStats stats;
+    auto pairs = findIntersections(figs, 3, &stats);
+
+    std::vector<IntersectionPair> expected;
+    for (size_t i = 0; i < figs.getSize(); ++i) {
+        for (size_t j = i + 1; j < figs.getSize(); ++j) {
+            double area = intersectionArea(*figs[i], *figs[j]);
+            if (area > 0.0) {
+                expected.push_back(IntersectionPair{i, j, area});
+            }
+        }
+    }
+    ASSERT_EQ(pairs.size(), expected.size());
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        EXPECT_EQ(pairs[k].first, expected[k].first);
+        EXPECT_EQ(pairs[k].second, expected[k].second);
+        EXPECT_NEAR(pairs[k].area, expected[k].area, 1e-9);
+    }
+    EXPECT_EQ(stats.intersectingPairs, expected.size());
+    EXPECT_GE(stats.candidatePairs, expected.size());
+    EXPECT_GT(stats.cullingEfficiency(), 0.9);
+}
+
+TEST(IntersectionTest, ThinWorldKeepsGridSmall) {
+    // Мир шириной 1e12 и нулевой высоты: квадратные ячейки размером с фигуру дали бы 1e11 столбцов.
+    std::vector<BoundingBox<double>> boxes;
+    std::mt19937_64 rng(30);
+    for (int i = 0; i < 2000; ++i) {
+        double x = static_cast<double>(rng() % 1000000000000ULL);
+        boxes.push_back(BoundingBox<double>{x, 0.0, x + 1.0, 0.0});
+    }
+    for (int i = 0; i < 50; ++i) {
+        boxes.push_back(BoundingBox<double>{boxes[i].minX + 0.5, 0.0, boxes[i].maxX + 0.5, 0.0});
+    }
+    std::vector<std::pair<size_t, size_t>> pairs = candidatePairs(boxes, 2);
+    std::sort(pairs.begin(), pairs.end());
+    std::vector<std::pair<size_t, size_t>> expected;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        for (size_t j = i + 1; j < boxes.size(); ++j) {
+            if (boxes[i].intersects(boxes[j])) {
+                expected.emplace_back(i, j);
+            }
+        }
+    }
+    EXPECT_EQ(pairs, expected);
+    EXPECT_GE(pairs.size(), 50u);
+}
+
+// Union area / convex hull tests
+TEST(UnionAreaTest, OverlapCountedOnce) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    figs.pushBack(std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(2, 0), Point<double>(2, 2), Point<double>(0, 2)));
+    figs.pushBack(std::make_shared<Square<double>>(
+        Point<double>(1, 1), Point<double>(1, 3), Point<double>(3, 3), Point<double>(3, 1)));
+    figs.pushBack(std::make_shared<Rectangle<double>>(
+        Point<double>(10, 0), Point<double>(13, 0), Point<double>(13, 1), Point<double>(10, 1)));
+    EXPECT_NEAR(unionArea(figs), 4.0 + 4.0 - 1.0 + 3.0, 1e-9);
+}
+
+TEST(UnionAreaTest, DuplicatesAndSharedEdges) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    auto sq = std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1));
+    figs.pushBack(sq);
+    figs.pushBack(sq);
+    figs.pushBack(std::make_shared<Square<double>>(
+        Point<double>(1, 0), Point<double>(2, 0), Point<double>(2, 1), Point<double>(1, 1)));
+    figs.pushBack(std::make_shared<Trapezoid<double>>(
+        Point<double>(0.25, 0.25), Point<double>(0.75, 0.25), Point<double>(0.6, 0.5), Point<double>(0.4, 0.5)));
+    EXPECT_NEAR(unionArea(figs), 2.0, 1e-9);
+}
+
+TEST(UnionAreaTest, MatchesInclusionExclusionForPairs) {
+    auto figs = makeScatteredFigures(400);
+    double total = 0.0;
+    for (size_t i = 0; i < figs.getSize(); ++i) {
+        total += figs[i]->area();
+    }
+    auto pairs = findIntersections(figs, 1);
+    for (const IntersectionPair& p : pairs) {
+        total -= p.area;
+    }
+    // В этом наборе нет тройных перекрытий, поэтому формула включений-исключений точна.
+    EXPECT_NEAR(unionArea(figs, 3), total, 1e-6);
+}
+
+TEST(ConvexHullTest, HullOfFigures) {
+    Array<std::shared_ptr<Figure<double>>> figs;
+    figs.pushBack(std::make_shared<Square<double>>(
+        Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1)));
+    figs.pushBack(std::make_shared<Square<double>>(
+        Point<double>(4, 4), Point<double>(5, 4), Point<double>(5, 5), Point<double>(4, 5)));
+    figs.pushBack(std::make_shared<Trapezoid<double>>(
+        Point<double>(1, 1), Point<double>(3, 1), Point<double>(2.5, 2), Point<double>(1.5, 2)));
+    Contour hull = convexHull(figs, 2);
+    ASSERT_EQ(hull.size(), 7);
+    EXPECT_NEAR(signedArea(hull), 11.0, 1e-12);
+}
+
+TEST(ConvexHullTest, ParallelMatchesSequential) {
+    auto figs = makeScatteredFigures(1000);
+    Contour points;
+    for (size_t i = 0; i < figs.getSize(); ++i) {
+        Contour c = toContour(*figs[i]);
+        points.insert(points.end(), c.begin(), c.end());
+    }
+    Contour sequential = convexHull(points);
+    Contour parallel = convexHull(figs, 4);
+    ASSERT_EQ(sequential.size(), parallel.size());
+    for (size_t i = 0; i < sequential.size(); ++i) {
+        EXPECT_DOUBLE_EQ(sequential[i].x, parallel[i].x);
+        EXPECT_DOUBLE_EQ(sequential[i].y, parallel[i].y);
+    }
+}
+
+TEST(ParserTest, ParsesNumbersAndPoints) {
+    std::string_view text = "  0 0\t+4 0\n4 4 -0.5e1 4 ";
+    size_t pos = 0;
+    Point<double> points[4];
+    parsePoints(text, pos, points, 4);
+    EXPECT_EQ(points[1].x, 4.0);
+    EXPECT_EQ(points[3].x, -5.0);
+    EXPECT_EQ(points[3].y, 4.0);
+    EXPECT_EQ(pos, text.size() - 1);
+}
+
+TEST(ParserTest, ReportsErrorPosition) {
+    size_t pos = 0;
+    Point<double> points[4];
+    try {
+        parsePoints<double>("0 0 1 1x 2 2 3 3", pos, points, 4);
+        FAIL();
+    } catch (const ParseError& err) {
+        EXPECT_EQ(err.position(), 6u);
+    }
+    EXPECT_EQ(pos, 0u);
+    EXPECT_THROW(parsePoints<double>("0 0 1 1 inf 2 3 3", pos, points, 4), ParseError);
+    EXPECT_THROW(parsePoints<double>("0 0 1", pos, points, 4), ParseError);
+    Point<int> ints[4];
+    EXPECT_THROW(parsePoints<int>("0 0 1 99999999999 2 2 3 3", pos, ints, 4), ParseError);
+}
+
+TEST(ParserTest, ReadRestoresStreamOnError) {
+    std::istringstream input("0 0 4 0 4 4 0 oops");
+    Square<double> square;
+    EXPECT_THROW(square.Read(input), ParseError);
+    EXPECT_TRUE(input.fail());
+    input.clear();
+    EXPECT_EQ(input.tellg(), 0);
+
+    std::istringstream good("0 0 4 0 4 4 0 4 tail");
+    square.Read(good);
+    EXPECT_DOUBLE_EQ(square.area(), 16.0);
+    std::string rest;
+    good >> rest;
+    EXPECT_EQ(rest, "tail");
+}
+
+TEST(ParserTest, ParseFiguresMatchesStreamRead) {
+    Array<std::shared_ptr<Figure<double>>> figures = makeScatteredFigures(50);
+    std::ostringstream text;
+    writeFigures(text, figures);
+
+    std::istringstream input(text.str());
+    Array<std::shared_ptr<Figure<double>>> streamed = readFigures<double>(input);
+    Array<std::shared_ptr<Figure<double>>> parsed = parseFigures<double>(text.str());
+    ASSERT_EQ(parsed.getSize(), figures.getSize());
+    ASSERT_EQ(streamed.getSize(), figures.getSize());
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        EXPECT_EQ(figureKind(*parsed[i]), figureKind(*figures[i]));
+        EXPECT_EQ(parsed[i]->area(), figures[i]->area());
+        EXPECT_EQ(streamed[i]->area(), figures[i]->area());
+    }
+
+    try {
+        parseFigures<double>("S 0 0 1 0 1 1 0 1\nX 0 0 1 0 1 1 0 1\n");
+        FAIL();
+    } catch (const ParseError& err) {
+        EXPECT_EQ(err.position(), 18u);
+    }
+}
+
+TEST(ParserTest, StreamPositionsAreByteOffsets) {
+    std::istringstream spaced("0\t\t0   1\n 1x 2 2 3 3");
+    double values[8];
+    try {
+        readNumbers(spaced, values, 8);
+        FAIL();
+    } catch (const ParseError& err) {
+        EXPECT_EQ(err.position(), 10u);
+    }
+
+    // Длинная мантисса не помещается в буфер слова, но остается допустимым числом.
+    std::string longNumber = "1." + std::string(100, '5');
+    std::istringstream longInput(longNumber + " 7 " + std::string(80, '9') + "x");
+    readNumbers(longInput, values, 2);
+    EXPECT_DOUBLE_EQ(values[0], std::stod(longNumber));
+    EXPECT_DOUBLE_EQ(values[1], 7.0);
+    try {
+        readNumbers(longInput, values, 1);
+        FAIL();
+    } catch (const ParseError& err) {
+        EXPECT_EQ(err.position(), 1u);
+    }
+
+    const char* text = "S 0 0 1 0 1 1 0 1\n\t X 0 0 1 0 1 1 0 1\n";
+    std::istringstream figures(text);
+    try {
+        readFigures<double>(figures);
+        FAIL();
+    } catch (const ParseError& err) {
+        EXPECT_EQ(err.position(), 20u);
+    }
+    try {
+        parseFigures<double>(text);
+        FAIL();
+    } catch (const ParseError& err) {
+        EXPECT_EQ(err.position(), 20u);
+    }
+
+    std::istringstream badCount("S 0 0 1 0 1 1 0 1\nP  2 0 0 1 1");
+    try {
+        readFigures<double>(badCount);
+        FAIL();
+    } catch (const ParseError& err) {
+        EXPECT_EQ(err.position(), 21u);
+    }
+}
+
+TEST(ArrayTest, InsertShiftsTail) {
+    Array<int> values;
+    values.pushBack(1);
+    values.pushBack(3);
+    values.insert(1, 2);
+    values.insert(3, 4);
+    ASSERT_EQ(values.getSize(), 4u);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(values[i], i + 1);
+    }
+    EXPECT_THROW(values.insert(6, 0), std::out_of_range);
+}
+
+TEST(FigureJournalTest, UndoRedoRestoresEveryVersion) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    FigureJournal<double> journal(figures);
+    Array<std::shared_ptr<Figure<double>>> source = makeScatteredFigures(6);
+
+    for (size_t i = 0; i < 4; ++i) {
+        journal.pushBack(source[i]);
+    }
+    journal.remove(1);
+    journal.clear();
+    Array<std::shared_ptr<Figure<double>>> batch;
+    batch.pushBack(source[4]);
+    batch.pushBack(source[5]);
+    journal.append(std::move(batch));
+    EXPECT_EQ(figures.getSize(), 2u);
+
+    journal.undo();
+    EXPECT_TRUE(figures.isEmpty());
+    journal.undo();
+    ASSERT_EQ(figures.getSize(), 3u);
+    EXPECT_EQ(figures[0], source[0]);
+    EXPECT_EQ(figures[1], source[2]);
+    journal.undo();
+    ASSERT_EQ(figures.getSize(), 4u);
+    EXPECT_EQ(figures[1], source[1]);
+
+    journal.redo();
+    journal.redo();
+    journal.redo();
+    ASSERT_EQ(figures.getSize(), 2u);
+    EXPECT_EQ(figures[1], source[5]);
+    EXPECT_THROW(journal.redo(), std::logic_error);
+
+    journal.checkout(0);
+    EXPECT_TRUE(figures.isEmpty());
+    EXPECT_THROW(journal.undo(), std::logic_error);
+
+    // Новое изменение после отмены отбрасывает ветку повтора.
+    journal.checkout(2);
+    journal.pushBack(source[5]);
+    EXPECT_FALSE(journal.canRedo());
+    EXPECT_EQ(journal.getRecordCount(), 3u);
+    EXPECT_THROW(journal.remove(10), std::out_of_range);
+    EXPECT_EQ(journal.getRecordCount(), 3u);
+}
+
+TEST(FigureJournalTest, CheckpointsMatchPlainReplay) {
+    Array<std::shared_ptr<Figure<double>>> source = makeScatteredFigures(200);
+    Array<std::shared_ptr<Figure<double>>> plainFigures;
+    Array<std::shared_ptr<Figure<double>>> checkedFigures;
+    FigureJournal<double> plain(plainFigures);
+    FigureJournal<double> checked(checkedFigures, 16);
+
+    std::mt19937 rng(7);
+    for (size_t step = 0; step < 300; ++step) {
+        unsigned action = rng() % 10;
+        size_t index = rng();
+        for (FigureJournal<double>* journal : {&plain, &checked}) {
+            size_t size = journal->getFigures().getSize();
+            if (action == 0) {
+                journal->clear();
+            } else if (action < 4 && size > 0) {
+                journal->remove(index % size);
+            } else {
+                journal->pushBack(source[step % source.getSize()]);
+            }
+        }
+    }
+    EXPECT_GT(checked.getCheckpointCount(), 10u);
+
+    for (size_t version : {250u, 3u, 170u, 300u, 0u, 99u}) {
+        plain.checkout(version);
+        checked.checkout(version);
+        ASSERT_EQ(plainFigures.getSize(), checkedFigures.getSize()) << version;
+        for (size_t i = 0; i < plainFigures.getSize(); ++i) {
+            EXPECT_EQ(plainFigures[i], checkedFigures[i]);
+        }
+    }
+}
+
+TEST(FigureJournalTest, MemoryGrowsWithChangesNotSize) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    Array<std::shared_ptr<Figure<double>>> source = makeScatteredFigures(10000);
+    for (size_t i = 0; i < source.getSize(); ++i) {
+        figures.pushBack(source[i]);
+    }
+    FigureJournal<double> journal(figures);
+    size_t empty = journal.memoryUsage();
+    for (size_t i = 0; i < 10; ++i) {
+        journal.remove(i);
+    }
+    EXPECT_LT(journal.memoryUsage() - empty, 1000u);
+
+    journal.clear();
+    EXPECT_TRUE(figures.isEmpty());
+    journal.undo();
+    EXPECT_EQ(figures.getSize(), source.getSize() - 10);
+}
+
+TEST(FigureJournalTest, CheckoutForwardThroughCheckpointKeepsClearContents) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    Array<std::shared_ptr<Figure<double>>> source = makeScatteredFigures(2);
+    FigureJournal<double> journal(figures, 2);
+    journal.pushBack(source[0]);
+    journal.clear();
+    journal.pushBack(source[1]);
+
+    journal.checkout(0);
+    journal.checkout(3);
+    ASSERT_EQ(figures.getSize(), 1u);
+    EXPECT_EQ(figures[0], source[1]);
+    journal.undo();
+    EXPECT_TRUE(figures.isEmpty());
+    journal.undo();
+    ASSERT_EQ(figures.getSize(), 1u);
+    EXPECT_EQ(figures[0], source[0]);
+    journal.undo();
+    EXPECT_TRUE(figures.isEmpty());
+}
+
+TEST(FigureJournalTest, DeltaCheckpointsFollowBranchesAndStaySmall) {
+    Array<std::shared_ptr<Figure<double>>> source = makeScatteredFigures(3000);
+    Array<std::shared_ptr<Figure<double>>> plainFigures;
+    Array<std::shared_ptr<Figure<double>>> checkedFigures;
+    for (size_t i = 0; i < 2000; ++i) {
+        plainFigures.pushBack(source[i]);
+        checkedFigures.pushBack(source[i]);
+    }
+    FigureJournal<double> plain(plainFigures);
+    FigureJournal<double> checked(checkedFigures, 8);
+
+    std::mt19937 rng(11);
+    for (size_t round = 0; round < 40; ++round) {
+        for (size_t step = 0; step < 25; ++step) {
+            unsigned action = rng() % 20;
+            size_t index = rng();
+            for (FigureJournal<double>* journal : {&plain, &checked}) {
+                size_t size = journal->getFigures().getSize();
+                if (action == 0) {
+                    journal->clear();
+                } else if (action < 12 && size > 0) {
+                    journal->remove(index % size);
+                } else if (action < 14) {
+                    Array<std::shared_ptr<Figure<double>>> batch;
+                    batch.pushBack(source[index % 3000]);
+                    batch.pushBack(source[(index + 1) % 3000]);
+                    journal->append(std::move(batch));
+                } else {
+                    journal->pushBack(source[index % 3000]);
+                }
+            }
+        }
+        // Дальний переход и новая ветка истории от него.
+        size_t version = rng() % (plain.getRecordCount() + 1);
+        plain.checkout(version);
+        checked.checkout(version);
+        ASSERT_EQ(plainFigures.getSize(), checkedFigures.getSize()) << version;
+        for (size_t i = 0; i < plainFigures.getSize(); ++i) {
+            ASSERT_EQ(plainFigures[i], checkedFigures[i]) << version;
+        }
+    }
+    size_t end = plain.getRecordCount();
+    for (size_t version : {size_t(0), end, end / 3, size_t(1), end - 1, end / 2}) {
+        plain.checkout(version);
+        checked.checkout(version);
+        ASSERT_EQ(plainFigures.getSize(), checkedFigures.getSize()) << version;
+        for (size_t i = 0; i < plainFigures.getSize(); ++i) {
+            ASSERT_EQ(plainFigures[i], checkedFigures[i]) << version;
+        }
+    }
+    // Снимки хранят изменения, а не копии коллекции из тысяч фигур на каждый снимок.
+    EXPECT_EQ(checked.getCheckpointCount(), checked.getRecordCount() / 8);
+    EXPECT_GT(checked.getCheckpointCount(), 4u);
+
+    // Снимки хранят изменения, а не копию коллекции из тысяч фигур на каждый снимок.
+    Array<std::shared_ptr<Figure<double>>> large;
+    for (size_t i = 0; i < source.getSize(); ++i) {
+        large.pushBack(source[i]);
+    }
+    FigureJournal<double> frequent(large, 8);
+    size_t before = frequent.memoryUsage();
+    for (size_t i = 0; i < 80; ++i) {
+        frequent.remove(i * 31 % large.getSize());
+    }
+    EXPECT_EQ(frequent.getCheckpointCount(), 10u);
+    EXPECT_LT(frequent.memoryUsage() - before, 80 * 200u);
+}
+
+TEST(FigureJournalTest, RejectedCheckoutJumpKeepsCollection) {
+    Array<std::shared_ptr<Figure<double>>> source = makeScatteredFigures(1000);
+    Array<std::shared_ptr<Figure<double>>> figures;
+    for (size_t i = 0; i < source.getSize(); ++i) {
+        figures.pushBack(source[i]);
+    }
+    FigureJournal<double> journal(figures, 4);
+    for (size_t i = 0; i < 8; ++i) {
+        journal.remove(0);
+    }
+    bool failing = true;
+    journal.setObserver([&](JournalOp op, bool reverted, size_t, size_t) {
+        if (failing && op == JournalOp::Clear && reverted) {
+            throw std::runtime_error("ошибка записи");
+        }
+    });
+    EXPECT_THROW(journal.checkout(0), std::runtime_error);
+    EXPECT_EQ(figures.getSize(), source.getSize() - journal.getVersion());
+    EXPECT_EQ(figures[0], source[journal.getVersion()]);
+
+    failing = false;
+    journal.checkout(0);
+    ASSERT_EQ(figures.getSize(), source.getSize());
+    EXPECT_EQ(figures[0], source[0]);
+    journal.checkout(8);
+    EXPECT_EQ(figures[0], source[8]);
+}
+
+std::filesystem::path freshStoreDirectory(const char* name) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(directory);
+    return directory;
+}
+
+TEST(DurableStoreTest, RecoversOperationsAndSnapshot) {
+    std::filesystem::path directory = freshStoreDirectory("laba4_store_recover");
+    Array<std::shared_ptr<Figure<double>>> source = makeScatteredFigures(20);
+    {
+        DurableFigureStore<double> store(directory, DurableOptions{SyncPolicy::Group, 4, 1 << 20, 0});
+        for (size_t i = 0; i < 10; ++i) {
+            store.pushBack(source[i]);
+        }
+        store.remove(3);
+        store.insert(0, source[15]);
+        store.compact();
+        store.clear();
+        for (size_t i = 10; i < 15; ++i) {
+            store.pushBack(source[i]);
+        }
+        store.remove(0);
+    }
+    DurableFigureStore<double> store(directory);
+    const auto& figures = store.getFigures();
+    ASSERT_EQ(figures.getSize(), 4u);
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(figures[i]->area(), source[11 + i]->area());
+        EXPECT_EQ(figureKind(*figures[i]), figureKind(*source[11 + i]));
+    }
+    EXPECT_EQ(store.getRecoveryStats().snapshotFigures, 10u);
+    EXPECT_EQ(store.getRecoveryStats().walRecords, 7u);
+    std::filesystem::remove_all(directory);
+}
+
+TEST(DurableStoreTest, TruncatesTornTail) {
+    std::filesystem::path directory = freshStoreDirectory("laba4_store_torn");
+    Array<std::shared_ptr<Figure<double>>> source = makeScatteredFigures(5);
+    {
+        DurableFigureStore<double> store(directory, DurableOptions{SyncPolicy::Always, 1, 1 << 20, 0});
+        for (size_t i = 0; i < 5; ++i) {
+            store.pushBack(source[i]);
+        }
+    }
+    std::filesystem::path wal = directory / "wal.log";
+    std::filesystem::resize_file(wal, std::filesystem::file_size(wal) - 3);
+    {
+        DurableFigureStore<double> store(directory);
+        EXPECT_EQ(store.getFigures().getSize(), 4u);
+        EXPECT_GT(store.getRecoveryStats().truncatedBytes, 0u);
+        store.pushBack(source[4]);
+    }
+    DurableFigureStore<double> store(directory);
+    EXPECT_EQ(store.getFigures().getSize(), 5u);
+    EXPECT_EQ(store.getRecoveryStats().truncatedBytes, 0u);
+    EXPECT_THROW(DurableFigureStore<float> wrongType(directory), std::runtime_error);
+    std::filesystem::remove_all(directory);
+}
+
+TEST(DurableStoreTest, FollowsJournalUndoRedo) {
+    std::filesystem::path directory = freshStoreDirectory("laba4_store_journal");
+    Array<std::shared_ptr<Figure<double>>> source = makeScatteredFigures(6);
+    Array<std::shared_ptr<Figure<double>>> figures;
+    {
+        DurableFigureStore<double> store(directory);
+        FigureJournal<double> journal(figures);
+        persistJournal(journal, store);
+        for (size_t i = 0; i < 5; ++i) {
+            journal.pushBack(source[i]);
+        }
+        journal.remove(2);
+        journal.clear();
+        journal.undo();
+        journal.undo();
+        journal.redo();
+        journal.pushBack(source[5]);
+        journal.undo();
+    }
+    DurableFigureStore<double> store(directory);
+    ASSERT_EQ(store.getFigures().getSize(), figures.getSize());
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        EXPECT_EQ(store.getFigures()[i]->area(), figures[i]->area());
+    }
+    std::filesystem::remove_all(directory);
+}
+
+TEST(DurableStoreTest, RejectedChangeLeavesJournalAndStoreInSync) {
+    std::filesystem::path directory = freshStoreDirectory("laba4_store_reject");
+    Array<std::shared_ptr<Figure<double>>> source = makeScatteredFigures(3);
+    Array<std::shared_ptr<Figure<double>>> figures;
+    {
+        DurableFigureStore<double> store(directory);
+        FigureJournal<double> journal(figures);
+        persistJournal(journal, store);
+        journal.pushBack(source[0]);
+
+        Array<std::shared_ptr<Figure<double>>> batch;
+        batch.pushBack(source[1]);
+        batch.pushBack(std::make_shared<Polygon<double>>(
+            std::initializer_list<Point<double>>{{0, 0}, {2, 0}, {3, 1}, {2, 2}, {0, 2}}));
+        batch.pushBack(source[2]);
+        EXPECT_THROW(journal.append(std::move(batch)), std::invalid_argument);
+        EXPECT_THROW(journal.pushBack(std::make_shared<Polygon<double>>(
+                         std::initializer_list<Point<double>>{{0, 0}, {1, 0}, {0, 1}})),
+                     std::invalid_argument);
+
+        EXPECT_EQ(figures.getSize(), 1u);
+        EXPECT_EQ(store.getFigures().getSize(), 1u);
+        EXPECT_EQ(journal.getVersion(), 1u);
+        journal.undo();
+        EXPECT_TRUE(figures.isEmpty());
+        journal.redo();
+    }
+    DurableFigureStore<double> store(directory);
+    ASSERT_EQ(store.getFigures().getSize(), 1u);
+    EXPECT_EQ(store.getFigures()[0]->area(), source[0]->area());
+    std::filesystem::remove_all(directory);
+}
+
+TEST(PartitionedArrayTest, ParsesCpuLists) {
+    EXPECT_EQ(NumaTopology::parseCpuList("0-3,8,10-11\n"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    NumaTopology topology = NumaTopology::detect();
+    ASSERT_FALSE(topology.nodes.empty());
+    EXPECT_GE(topology.getCpuCount(), 1u);
+}
+
+TEST(PartitionedArrayTest, DetectsSparseNodeIds) {
+    std::filesystem::path root = std::filesystem::temp_directory_path() / "laba4_numa_nodes";
+    std::filesystem::remove_all(root);
+    for (const char* node : {"node0", "node2", "node10"}) {
+        std::filesystem::create_directories(root / node);
+    }
+    std::filesystem::create_directories(root / "power");
+    std::ofstream(root / "node0" / "cpulist") << "0-1\n";
+    std::ofstream(root / "node2" / "cpulist") << "2,3\n";
+    std::ofstream(root / "node10" / "cpulist") << "4\n";
+
+    NumaTopology topology = NumaTopology::detect(root);
+    EXPECT_EQ(topology.nodes, (std::vector<std::vector<int>>{{0, 1}, {2, 3}, {4}}));
+    std::filesystem::remove_all(root);
+}
+
+TEST(PartitionedArrayTest, AreaFarFromOriginMatchesFigures) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    double area = 0.0;
+    for (int i = 0; i < 16; ++i) {
+        double x = 1e8 + 0.37 * i, y = -3e8 + 0.11 * i;
+        figures.pushBack(std::make_shared<Rectangle<double>>(Point<double>(x, y), Point<double>(x + 1.5, y),
+                                                             Point<double>(x + 1.5, y + 0.25), Point<double>(x, y + 0.25)));
+        area += figures[i]->area();
+    }
+    NumaTopology topology{{{0}}};
+    PartitionedFigureArray<double> partitioned(2, false, topology);
+    partitioned.pushBatch(figures);
+    EXPECT_DOUBLE_EQ(area, 16 * 0.375);
+    EXPECT_DOUBLE_EQ(partitioned.totalArea(), area);
+}
+
+TEST(PartitionedArrayTest, ShardLocalQueriesMatchFlatScan) {
+    Array<std::shared_ptr<Figure<double>>> figures = makeScatteredFigures(1000);
+    // Два узла по два процессора, без привязки: проверка раскладки на любой машине.
+    NumaTopology topology{{{0, 1}, {2, 3}}};
+    PartitionedFigureArray<double> partitioned(4, false, topology);
+    partitioned.pushBatch(figures);
+    EXPECT_EQ(partitioned.getSize(), figures.getSize());
+    EXPECT_EQ(partitioned.getShardNode(1), 1u);
+    EXPECT_EQ(partitioned.getShardSize(3), 250u);
+
+    double area = 0.0;
+    BoundingBox<double> world = boundingBox(*figures[0]);
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        area += figures[i]->area();
+        world.expand(boundingBox(*figures[i]));
+    }
+    EXPECT_NEAR(partitioned.totalArea(), area, 1e-9 * area);
+    BoundingBox<double> merged = partitioned.boundingBox();
+    EXPECT_EQ(merged.minX, world.minX);
+    EXPECT_EQ(merged.maxY, world.maxY);
+
+    BoundingBox<double> query{-100.0, -100.0, 100.0, 100.0};
+    size_t expected = 0;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        expected += boundingBox(*figures[i]).intersects(query);
+    }
+    std::vector<PartitionedFigureArray<double>::Location> found = partitioned.rangeQuery(query);
+    EXPECT_EQ(found.size(), expected);
+    for (const auto& location : found) {
+        EXPECT_TRUE(boundingBox(*partitioned.figure(location)).intersects(query));
+    }
+
+    size_t squares = partitioned.count(FigureKind::Square);
+    partitioned.remove({0, 0});
+    EXPECT_EQ(partitioned.getSize(), figures.getSize() - 1);
+    EXPECT_EQ(partitioned.figure({0, 0})->area(), figures[1]->area());
+    EXPECT_LE(partitioned.count(FigureKind::Square), squares);
+    EXPECT_THROW(partitioned.remove({4, 0}), std::out_of_range);
+}
+
+TEST(PartitionedArrayTest, ConcurrentQueriesShareWorkers) {
+    Array<std::shared_ptr<Figure<double>>> figures = makeScatteredFigures(400);
+    PartitionedFigureArray<double> partitioned(4, false, NumaTopology{{{0, 1}, {2, 3}}});
+    partitioned.pushBatch(figures);
+    double area = partitioned.totalArea();
+    size_t squares = partitioned.count(FigureKind::Square);
+
+    std::vector<std::thread> threads;
+    std::atomic<int> mismatches{0};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 200; ++i) {
+                bool ok = t % 2 ? partitioned.count(FigureKind::Square) == squares
+                                : partitioned.totalArea() == area;
+                mismatches += !ok;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(mismatches.load(), 0);
+}
+
+TEST(PartitionedArrayTest, PushBackRoundRobinOnThisMachine) {
+    Array<std::shared_ptr<Figure<double>>> figures = makeScatteredFigures(100);
+    PartitionedFigureArray<double> partitioned(3);
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        PartitionedFigureArray<double>::Location location = partitioned.pushBack(*figures[i]);
+        EXPECT_EQ(location.shard, i % 3);
+        EXPECT_EQ(location.index, i / 3);
+    }
+    EXPECT_EQ(partitioned.getShardSize(0), 34u);
+    EXPECT_EQ(partitioned.figure({2, 5})->area(), figures[17]->area());
+    partitioned.clear();
+    EXPECT_TRUE(partitioned.isEmpty());
+    EXPECT_THROW(partitioned.boundingBox(), std::logic_error);
+}
+
+TileSummary bruteForceSummary(const Array<std::shared_ptr<Figure<double>>>& figures, const BoundingBox<double>& viewport) {
+    TileSummary result;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        if (!viewport.contains(figures[i]->Center())) {
+            continue;
+        }
+        BoundingBox<double> box = boundingBox(*figures[i]);
+        if (result.count == 0) {
+            result.box = box;
+        } else {
+            result.box.expand(box);
+        }
+        ++result.count;
+        result.area += figures[i]->area();
+    }
+    return result;
+}
+
+TEST(TilePyramidTest, AggregateMatchesBruteForce) {
+    Array<std::shared_ptr<Figure<double>>> figures = makeScatteredFigures(2000);
+    TilePyramid<double> pyramid(BoundingBox<double>{-500.0, -500.0, 500.0, 500.0}, 6);
+    pyramid.build(figures);
+    EXPECT_EQ(pyramid.total().count, figures.getSize());
+
+    const BoundingBox<double> viewports[] = {
+        {-123.4, -77.7, 250.0, 31.0},
+        {-1e9, -1e9, 1e9, 1e9},
+        {600.0, 600.0, 700.0, 700.0},
+        {-2000.0, -10.0, -400.0, 10.0},
+    };
+    for (const BoundingBox<double>& viewport : viewports) {
+        TileSummary expected = bruteForceSummary(figures, viewport);
+        TileSummary actual = pyramid.aggregate(viewport);
+        EXPECT_EQ(actual.count, expected.count);
+        EXPECT_NEAR(actual.area, expected.area, 1e-9 * (1.0 + expected.area));
+        if (expected.count > 0) {
+            EXPECT_EQ(actual.box.minX, expected.box.minX);
+            EXPECT_EQ(actual.box.maxY, expected.box.maxY);
+        }
+    }
+}
+
+TEST(TilePyramidTest, QueryOutsideWorldSeesClampedCentroids) {
+    TilePyramid<double> pyramid(BoundingBox<double>{0.0, 0.0, 100.0, 100.0}, 4);
+    Square<double> offWorld(Point<double>(-52, 9), Point<double>(-48, 9), Point<double>(-48, 13), Point<double>(-52, 13));
+    Square<double> inside(Point<double>(50, 50), Point<double>(51, 50), Point<double>(51, 51), Point<double>(50, 51));
+    pyramid.add(offWorld);
+    pyramid.add(inside);
+
+    BoundingBox<double> viewport{-60.0, 0.0, -40.0, 20.0};
+    EXPECT_EQ(pyramid.aggregate(viewport).count, 1u);
+    for (size_t level = 0; level < pyramid.getLevelCount(); ++level) {
+        std::vector<TileSummary> visible = pyramid.query(viewport, level);
+        ASSERT_EQ(visible.size(), 1u) << level;
+        EXPECT_EQ(visible[0].x, 0u);
+        EXPECT_EQ(visible[0].count, level == 0 ? 2u : 1u);
+        EXPECT_EQ(visible[0].box.minX, -52.0);
+    }
+    EXPECT_TRUE(pyramid.query(BoundingBox<double>{200.0, 200.0, 300.0, 300.0}, 3).empty());
+}
+
+TEST(TilePyramidTest, IncrementalUpdatesMatchRebuild) {
+    Array<std::shared_ptr<Figure<double>>> figures = makeScatteredFigures(500);
+    BoundingBox<double> world{-500.0, -500.0, 500.0, 500.0};
+    TilePyramid<double> incremental(world, 5);
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        incremental.add(*figures[i]);
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT_TRUE(incremental.remove(*figures[0]));
+        figures.remove(0);
+    }
+    EXPECT_FALSE(incremental.remove(Square<double>(Point<double>(0, 0), Point<double>(1e-3, 0),
+                                                   Point<double>(1e-3, 1e-3), Point<double>(0, 1e-3))));
+
+    TilePyramid<double> rebuilt(world, 5);
+    rebuilt.build(figures);
+    for (size_t level = 0; level < 5; ++level) {
+        std::vector<TileSummary> a = incremental.query(world, level);
+        std::vector<TileSummary> b = rebuilt.query(world, level);
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            EXPECT_EQ(a[i].x, b[i].x);
+            EXPECT_EQ(a[i].count, b[i].count);
+            EXPECT_NEAR(a[i].area, b[i].area, 1e-9 * (1.0 + b[i].area));
+            EXPECT_EQ(a[i].box.maxX, b[i].box.maxX);
+        }
+    }
+    BoundingBox<double> zoomed{0.0, 0.0, 31.25, 31.25};
+    EXPECT_EQ(incremental.levelFor(zoomed, 1), 4u);
+    EXPECT_LE(incremental.query(zoomed, 4).size(), 4u);
+}
+
+TEST(PolygonTest, AreaAndCenter) {
+    Polygon<double> triangle{Point<double>(0, 0), Point<double>(4, 0), Point<double>(0, 3)};
+    EXPECT_EQ(triangle.getVertexCount(), 3u);
+    EXPECT_DOUBLE_EQ(triangle.area(), 6.0);
+    EXPECT_NEAR(triangle.Center().x, 4.0 / 3.0, 1e-12);
+    EXPECT_NEAR(triangle.Center().y, 1.0, 1e-12);
+
+    Polygon<double> pentagon{Point<double>(0, 0), Point<double>(2, 0), Point<double>(3, 2),
+                             Point<double>(1, 4), Point<double>(-1, 2)};
+    EXPECT_DOUBLE_EQ(pentagon.area(), 10.0);
+    EXPECT_DOUBLE_EQ(static_cast<double>(pentagon), 10.0);
+
+    EXPECT_THROW((Polygon<double>{Point<double>(0, 0), Point<double>(1, 1), Point<double>(2, 2)}),
+                 std::invalid_argument);
+    EXPECT_THROW((Polygon<double>{Point<double>(0, 0), Point<double>(1, 1)}), std::invalid_argument);
+}
+
+TEST(PolygonTest, PoolBatchKernelsMatchPerPolygon) {
+    auto pool = std::make_shared<VertexPool<double>>();
+    std::mt19937 rng(38);
+    std::uniform_real_distribution<double> radius(1.0, 10.0);
+    for (size_t p = 0; p < 200; ++p) {
+        size_t n = 3 + p % 9;
+        std::vector<Point<double>> points(n);
+        for (size_t k = 0; k < n; ++k) {
+            double angle = 2.0 * 3.14159265358979323846 * static_cast<double>(k) / static_cast<double>(n);
+            double r = radius(rng);
+            points[k] = Point<double>(100.0 * static_cast<double>(p) + r * std::cos(angle), r * std::sin(angle));
+        }
+        Polygon<double> polygon(pool, points);
+        EXPECT_EQ(polygon.getId(), p);
+    }
+    std::vector<double> areas;
+    std::vector<Point<double>> centers;
+    pool->areas(areas);
+    pool->centers(centers);
+    ASSERT_EQ(areas.size(), 200u);
+    ASSERT_EQ(centers.size(), 200u);
+    for (size_t p = 0; p < 200; ++p) {
+        EXPECT_NEAR(areas[p], pool->area(p), 1e-9 * areas[p]);
+        EXPECT_DOUBLE_EQ(centers[p].x, pool->center(p).x);
+        EXPECT_DOUBLE_EQ(centers[p].y, pool->center(p).y);
+    }
+}
+
+TEST(PolygonTest, MixesWithQuadrilaterals) {
+    auto pool = std::make_shared<VertexPool<double>>();
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.pushBack(std::make_shared<Square<double>>(Point<double>(0, 0), Point<double>(2, 0),
+                                                      Point<double>(2, 2), Point<double>(0, 2)));
+    const Point<double> triangle[] = {Point<double>(0, 0), Point<double>(4, 0), Point<double>(0, 3)};
+    figures.pushBack(std::make_shared<Polygon<double>>(pool, triangle));
+    figures.pushBack(std::make_shared<Rectangle<double>>(Point<double>(0, 0), Point<double>(3, 0),
+                                                         Point<double>(3, 1), Point<double>(0, 1)));
+    double total = 0.0;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        total += static_cast<double>(*figures[i]);
+    }
+    EXPECT_DOUBLE_EQ(total, 13.0);
+    EXPECT_EQ(figureKind(*figures[1]), FigureKind::Polygon);
+
+    std::shared_ptr<Figure<double>> copy = figures[1]->clone();
+    EXPECT_EQ(static_cast<Polygon<double>&>(*copy).getPool(), pool);
+
+    AggregateArray<double> aggregate;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        aggregate.pushBack(figures[i]);
+    }
+    EXPECT_EQ(aggregate.count(FigureKind::Polygon), 1u);
+    EXPECT_DOUBLE_EQ(aggregate.totalArea(), 13.0);
+
+    CompactFigureStore<float> store(0.0, 0.0, 1.0);
+    EXPECT_THROW(store.pushBack(*figures[1]), std::invalid_argument);
+}
+
+TEST(PolygonTest, RejectedPolygonsStayOutOfPool) {
+    auto pool = std::make_shared<VertexPool<double>>();
+    const Point<double> good[] = {Point<double>(0, 0), Point<double>(2, 0), Point<double>(0, 2)};
+    const Point<double> collinear[] = {Point<double>(0, 0), Point<double>(1, 1), Point<double>(2, 2)};
+    Polygon<double> kept(pool, good);
+    EXPECT_THROW(Polygon<double>(pool, collinear), std::invalid_argument);
+    EXPECT_THROW(Polygon<double>(pool, std::span<const Point<double>>(good, 2)), std::invalid_argument);
+    EXPECT_EQ(pool->getPolygonCount(), 1u);
+    std::vector<double> areas;
+    pool->areas(areas);
+    EXPECT_EQ(areas, std::vector<double>{2.0});
+
+    std::istringstream spaced("\t 2 0 0 1 1");
+    Polygon<double> read;
+    try {
+        read.Read(spaced);
+        FAIL();
+    } catch (const ParseError& err) {
+        EXPECT_EQ(err.position(), 2u);
+    }
+    std::istringstream badVertex("3  0 0 1 0 1 y");
+    try {
+        read.Read(badVertex);
+        FAIL();
+    } catch (const ParseError& err) {
+        EXPECT_EQ(err.position(), 13u);
+    }
+}
+
+TEST(PolygonTest, NonConvexRejectedByConvexAlgorithms) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.pushBack(std::make_shared<Square<double>>(Point<double>(0, 0), Point<double>(4, 0),
+                                                      Point<double>(4, 4), Point<double>(0, 4)));
+    // Буква L: площадь и центр считаются, а отсечение и объединение ее не принимают.
+    auto lShape = std::make_shared<Polygon<double>>(std::initializer_list<Point<double>>{
+        {0, 0}, {3, 0}, {3, 1}, {1, 1}, {1, 3}, {0, 3}});
+    EXPECT_DOUBLE_EQ(lShape->area(), 5.0);
+    EXPECT_FALSE(isConvex(toContour(*lShape)));
+    EXPECT_TRUE(isConvex(toContour(*figures[0])));
+    EXPECT_THROW(intersectionArea(*figures[0], *lShape), std::invalid_argument);
+    figures.pushBack(lShape);
+    EXPECT_THROW(unionArea(figures), std::invalid_argument);
+    EXPECT_THROW(findIntersections(figures), std::invalid_argument);
+
+    // Пятиконечная звезда обходит центр дважды, хотя все ее повороты в одну сторону.
+    Contour star;
+    for (int k = 0; k < 5; ++k) {
+        double angle = 2.0 * std::numbers::pi * (2 * k) / 5.0;
+        star.emplace_back(std::cos(angle), std::sin(angle));
+    }
+    EXPECT_FALSE(isConvex(star));
+}
+
+TEST(PolygonTest, TextFormatRoundTrip) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    figures.pushBack(std::make_shared<Polygon<double>>(
+        std::initializer_list<Point<double>>{Point<double>(0, 0), Point<double>(2, 0), Point<double>(3, 2),
+                                             Point<double>(1, 4), Point<double>(-1, 2)}));
+    figures.pushBack(std::make_shared<Square<double>>(Point<double>(0, 0), Point<double>(1, 0),
+                                                      Point<double>(1, 1), Point<double>(0, 1)));
+    std::ostringstream out;
+    writeFigures(out, figures);
+    EXPECT_EQ(out.str().substr(0, 4), "P 5 ");
+
+    Array<std::shared_ptr<Figure<double>>> parsed = parseFigures<double>(out.str());
+    std::istringstream in(out.str());
+    Array<std::shared_ptr<Figure<double>>> read = readFigures<double>(in);
+    for (const Array<std::shared_ptr<Figure<double>>>* result : {&parsed, &read}) {
+        ASSERT_EQ(result->getSize(), 2u);
+        EXPECT_EQ(figureKind(*(*result)[0]), FigureKind::Polygon);
+        EXPECT_EQ((*result)[0]->getVertexCount(), 5u);
+        EXPECT_DOUBLE_EQ((*result)[0]->area(), 10.0);
+        EXPECT_EQ(figureKind(*(*result)[1]), FigureKind::Square);
+    }
+
+    EXPECT_THROW(parseFigures<double>("P 2 0 0 1 1"), ParseError);
+    EXPECT_THROW(parseFigures<double>("P 3 0 0 1 1 2 2"), ParseError);
+    EXPECT_THROW(parseFigures<double>("P 4 0 0 1 0 1"), ParseError);
+
+    Polygon<double> polygon;
+    std::istringstream bad("3 0 0 1 x 0 1");
+    EXPECT_THROW(polygon.Read(bad), ParseError);
+    EXPECT_TRUE(bad.fail());
+    std::istringstream good("3 0 0 4 0 0 3");
+    polygon.Read(good);
+    EXPECT_DOUBLE_EQ(polygon.area(), 6.0);
+}
+
+// Значения вида m * 2^e с e от -20 до 30: точная сумма помещается в __int128 в единицах 2^-20.
+std::vector<double> makeWideRangeValues(size_t n, unsigned seed, __int128& exactScaled) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int64_t> mantissa(-(int64_t(1) << 40), int64_t(1) << 40);
+    std::uniform_int_distribution<int> exponent(-20, 30);
+    std::vector<double> values(n);
+    exactScaled = 0;
+    for (double& v : values) {
+        int64_t m = mantissa(rng);
+        int e = exponent(rng);
+        v = std::ldexp(static_cast<double>(m), e);
+        exactScaled += static_cast<__int128>(m) << (e + 20);
+    }
+    return values;
+}
+
+TEST(SummationTest, ModesStayWithinErrorBounds) {
+    __int128 exactScaled;
+    std::vector<double> values = makeWideRangeValues(100000, 39, exactScaled);
+    double exact = std::ldexp(static_cast<double>(exactScaled), -20);
+    double absSum = 0.0;
+    for (double v : values) {
+        absSum += std::abs(v);
+    }
+    const double eps = std::numeric_limits<double>::epsilon();
+    double n = static_cast<double>(values.size());
+
+    EXPECT_EQ(sum(values, SummationMode::Exact), exact);
+    EXPECT_LE(std::abs(sum(values, SummationMode::Naive) - exact), (n - 1) * eps * absSum);
+    EXPECT_LE(std::abs(sum(values, SummationMode::Pairwise) - exact), (std::log2(n / 128) + 34) * eps * absSum);
+    EXPECT_LE(std::abs(sum(values, SummationMode::Neumaier) - exact), 2 * eps * std::abs(exact) + n * eps * eps * absSum);
+
+    ExactSum streamed;
+    PairwiseSum pairwise;
+    NeumaierSum neumaier;
+    for (double v : values) {
+        streamed.add(v);
+        pairwise.add(v);
+        neumaier.add(v);
+    }
+    EXPECT_EQ(streamed.value(), exact);
+    EXPECT_LE(std::abs(pairwise.value() - exact), (std::log2(n / 128) + 34) * eps * absSum);
+    EXPECT_LE(std::abs(neumaier.value() - exact), 2 * eps * std::abs(exact) + n * eps * eps * absSum);
+}
+
+TEST(SummationTest, ExactSurvivesCancellation) {
+    std::vector<double> values = {1e300, 1.0, -1e300, 1e-300, std::numeric_limits<double>::denorm_min(), -1.0};
+    EXPECT_EQ(sum(values, SummationMode::Exact), 1e-300);
+    EXPECT_NE(sum(values, SummationMode::Naive), 1e-300);
+
+    // 2^53 + 1 + 1: наивная сумма теряет обе единицы, точная округляет 2^53 + 2 без потерь.
+    std::vector<double> ties = {9007199254740992.0, 1.0, 1.0};
+    EXPECT_EQ(sum(ties, SummationMode::Exact), 9007199254740994.0);
+    EXPECT_EQ(sum(std::vector<double>{-0.5, -0.25}, SummationMode::Exact), -0.75);
+    EXPECT_EQ(sum(std::vector<double>{}, SummationMode::Exact), 0.0);
+    EXPECT_TRUE(std::isinf(sum(std::vector<double>{1.0, std::numeric_limits<double>::infinity()}, SummationMode::Exact)));
+}
+
+TEST(SummationTest, SumAreasAndShiftedShoelace) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    // Единичные квадраты далеко от начала координат: старая формула теряла здесь все знаки.
+    for (int i = 0; i < 1000; ++i) {
+        double x = 1e9 + i, y = 1e9;
+        figures.pushBack(std::make_shared<Square<double>>(Point<double>(x, y), Point<double>(x + 1, y),
+                                                          Point<double>(x + 1, y + 1), Point<double>(x, y + 1)));
+    }
+    EXPECT_EQ(figures[0]->area(), 1.0);
+    for (SummationMode mode : {SummationMode::Naive, SummationMode::Neumaier, SummationMode::Pairwise, SummationMode::Exact}) {
+        EXPECT_EQ(sumAreas(figures, mode), 1000.0);
+    }
+    Polygon<double> triangle{Point<double>(1e9, 1e9), Point<double>(1e9 + 4, 1e9), Point<double>(1e9, 1e9 + 3)};
+    EXPECT_EQ(triangle.area(), 6.0);
+}
+
+TEST(WorkloadTest, GeneratorIsDeterministicAndCoversSpecialCases) {
+    WorkloadOptions options;
+    options.degenerateShare = 0.1;
+    options.hugeShare = 0.1;
+    FigureGenerator<double> a(40, options), b(40, options);
+    size_t degenerate = 0, huge = 0, rotated = 0;
+    size_t kinds[FigureKindCount] = {};
+    for (int i = 0; i < 3000; ++i) {
+        std::shared_ptr<Figure<double>> fa = a.next();
+        std::shared_ptr<Figure<double>> fb = b.next();
+        ASSERT_EQ(figureKind(*fa), figureKind(*fb));
+        for (size_t v = 0; v < 4; ++v) {
+            ASSERT_EQ(fa->getVertex(v).x, fb->getVertex(v).x);
+            ASSERT_EQ(fa->getVertex(v).y, fb->getVertex(v).y);
+        }
+        EXPECT_GE(fa->area(), 1e-9);
+        ++kinds[static_cast<size_t>(figureKind(*fa))];
+        degenerate += fa->area() < 1e-8;
+        huge += std::abs(fa->Center().x) > 1e6;
+        rotated += fa->getVertex(0).y != fa->getVertex(1).y;
+    }
+    EXPECT_GT(degenerate, 100u);
+    EXPECT_GT(huge, 100u);
+    EXPECT_GT(rotated, 300u);
+    EXPECT_GT(kinds[static_cast<size_t>(FigureKind::Square)], 800u);
+    EXPECT_GT(kinds[static_cast<size_t>(FigureKind::Trapezoid)], 800u);
+}
+
+TEST(WorkloadTest, TraceRoundTripsAndReplays) {
+    TraceMix mix;
+    mix.initial = 200;
+    std::vector<TraceEvent<double>> trace = makeTrace<double>(2000, 7, mix);
+    ASSERT_EQ(trace.size(), 2200u);
+    std::ostringstream first;
+    writeTrace(first, trace);
+    std::ostringstream again;
+    writeTrace(again, makeTrace<double>(2000, 7, mix));
+    EXPECT_EQ(first.str(), again.str());
+
+    std::vector<TraceEvent<double>> parsed = parseTrace<double>(first.str());
+    std::ostringstream second;
+    writeTrace(second, parsed);
+    EXPECT_EQ(first.str(), second.str());
+
+    size_t expectedSize = 0;
+    for (const TraceEvent<double>& event : trace) {
+        expectedSize += event.op == TraceOp::Add;
+        expectedSize -= event.op == TraceOp::Remove;
+    }
+    AggregateReplayTarget<double> original, replayed;
+    ReplayReport a = replayTrace(trace, original);
+    ReplayReport b = replayTrace(parsed, replayed);
+    EXPECT_EQ(original.getFigures().getSize(), expectedSize);
+    EXPECT_EQ(a.checksum, b.checksum);
+    EXPECT_EQ(a.all.getCount(), trace.size());
+    EXPECT_GT(a.byOp[static_cast<size_t>(TraceOp::Range)].getCount(), 0u);
+
+    EXPECT_THROW(parseTrace<double>("T\nX 1\n"), ParseError);
+    try {
+        parseTrace<double>("T\nA S 0 0 1 0 1 1 0 oops\n");
+        FAIL();
+    } catch (const ParseError& err) {
+        EXPECT_EQ(err.position(), 20u);
+    }
+}
+
+TEST(WorkloadTest, HistogramPercentilesWithinBucketPrecision) {
+    LatencyHistogram histogram;
+    std::mt19937_64 rng(3);
+    std::lognormal_distribution<double> latency(8.0, 1.5);
+    std::vector<uint64_t> values(100000);
+    for (uint64_t& v : values) {
+        v = static_cast<uint64_t>(latency(rng));
+        histogram.record(v);
+    }
+    std::sort(values.begin(), values.end());
+    for (double q : {0.5, 0.99, 0.999}) {
+        uint64_t exact = values[static_cast<size_t>(std::ceil(q * values.size())) - 1];
+        uint64_t approx = histogram.percentile(q);
+        EXPECT_GE(approx, exact);
+        EXPECT_LE(static_cast<double>(approx), static_cast<double>(exact) * (1.0 + 1.0 / 64) + 1);
+    }
+    EXPECT_EQ(histogram.percentile(1.0), values.back());
+    EXPECT_EQ(histogram.getMin(), values.front());
+    EXPECT_EQ(LatencyHistogram().percentile(0.5), 0u);
+}
+
+TEST(FigureServerTest, ExecutesBatchesOverUnixSocket) {
+    std::filesystem::path socketPath = std::filesystem::temp_directory_path() / "laba4_server_test.sock";
+    SharedFigureStore<double> store;
+    FigureServer<double> server(ServerAddress::parse("unix:" + socketPath.string()), store, 2);
+    FigureClient client(server.getAddress());
+
+    RequestBatch batch;
+    Array<std::shared_ptr<Figure<double>>> figures = makeScatteredFigures(50);
+    double area = 0.0;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        batch.add(*figures[i]);
+        area += figures[i]->area();
+    }
+    const Point<double> collinear[4] = {Point<double>(0, 0), Point<double>(1, 1), Point<double>(2, 2), Point<double>(3, 3)};
+    batch.add(FigureKind::Square, collinear);
+    batch.total();
+    batch.range(BoundingBox<double>{-1e9, -1e9, 1e9, 1e9});
+    batch.remove(1000);
+    batch.remove(0);
+    std::vector<ServerResponse> responses = client.call(batch);
+    ASSERT_EQ(responses.size(), 55u);
+    EXPECT_EQ(responses[49].count, 49u);
+    EXPECT_EQ(responses[50].status, ServerStatus::Error);
+    EXPECT_EQ(responses[50].error, "точки колинеарны");
+    EXPECT_NEAR(responses[51].value, area, 1e-9 * area);
+    EXPECT_EQ(responses[52].count, 50u);
+    EXPECT_EQ(responses[53].status, ServerStatus::Error);
+    EXPECT_EQ(responses[54].count, 49u);
+    EXPECT_EQ(store.getSize(), 49u);
+
+    // Нарушение протокола закрывает соединение, сервер продолжает работать.
+    FigureClient broken(server.getAddress());
+    const char garbage[] = {5, 0, 0, 0, 1, 0, 0, 0, 9};
+    detail::sendAll(broken.getDescriptor(), garbage, sizeof(garbage));
+    RequestBatch empty;
+    EXPECT_THROW(broken.receive(empty), std::runtime_error);
+    RequestBatch total;
+    total.total();
+    EXPECT_EQ(client.call(total).size(), 1u);
+}
+
+TEST(FigureServerTest, RejectsNonFiniteCoordinates) {
+    std::filesystem::path socketPath = std::filesystem::temp_directory_path() / "laba4_nan_test.sock";
+    SharedFigureStore<double> store;
+    FigureServer<double> server(ServerAddress::parse("unix:" + socketPath.string()), store, 1);
+    FigureClient client(server.getAddress());
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const Point<double> square[4] = {Point<double>(0, 0), Point<double>(2, 0), Point<double>(2, 2), Point<double>(0, 2)};
+    const Point<double> broken[4] = {Point<double>(0, 0), Point<double>(nan, 0), Point<double>(2, 2), Point<double>(0, 2)};
+    const Point<double> infinite[4] = {Point<double>(0, 0), Point<double>(2, 0),
+                                       Point<double>(2, std::numeric_limits<double>::infinity()), Point<double>(0, 2)};
+    RequestBatch batch;
+    batch.add(FigureKind::Square, square);
+    batch.add(FigureKind::Square, broken);
+    batch.add(FigureKind::Rectangle, infinite);
+    batch.total();
+    std::vector<ServerResponse> responses = client.call(batch);
+    ASSERT_EQ(responses.size(), 4u);
+    EXPECT_EQ(responses[0].status, ServerStatus::Ok);
+    EXPECT_EQ(responses[1].status, ServerStatus::Error);
+    EXPECT_EQ(responses[1].error, "координаты должны быть конечными");
+    EXPECT_EQ(responses[2].status, ServerStatus::Error);
+    EXPECT_DOUBLE_EQ(responses[3].value, 4.0);
+    EXPECT_EQ(store.getSize(), 1u);
+}
+
+TEST(FigureServerTest, StopsReadingWhileResponsesPileUp) {
+    std::filesystem::path socketPath = std::filesystem::temp_directory_path() / "laba4_backpressure_test.sock";
+    SharedFigureStore<double> store;
+    FigureServer<double> server(ServerAddress::parse("unix:" + socketPath.string()), store, 1);
+    FigureClient client(server.getAddress());
+
+    // Клиент шлет кадры Total, не читая ответы (17 байт на кадр из 9 байт).
+    RequestBatch total;
+    total.total();
+    const std::vector<char>& frame = total.frame();
+    const size_t frameCount = 400000;
+    std::vector<char> requests;
+    for (size_t i = 0; i < frameCount; ++i) {
+        requests.insert(requests.end(), frame.begin(), frame.end());
+    }
+    size_t sent = 0;
+    for (int idle = 0; idle < 20 && sent < requests.size();) {
+        ssize_t written = ::send(client.getDescriptor(), requests.data() + sent, requests.size() - sent,
+                                 MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (written > 0) {
+            sent += static_cast<size_t>(written);
+            idle = 0;
+        } else {
+            ASSERT_TRUE(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+            ++idle;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    EXPECT_LT(sent, requests.size());
+    EXPECT_LT(server.getFrameCount(), frameCount / 2);
+
+    // Когда клиент начинает читать, сервер догоняет и отвечает на все кадры.
+    const size_t responseBytes = frameCount * 17;
+    size_t received = 0;
+    std::thread reader([&] {
+        std::vector<char> buffer(64 * 1024);
+        while (received < responseBytes) {
+            ssize_t got = ::recv(client.getDescriptor(), buffer.data(), buffer.size(), 0);
+            if (got <= 0) {
+                return;
+            }
+            received += static_cast<size_t>(got);
+        }
+    });
+    detail::sendAll(client.getDescriptor(), requests.data() + sent, requests.size() - sent);
+    reader.join();
+    EXPECT_EQ(received, responseBytes);
+    EXPECT_EQ(server.getFrameCount(), frameCount);
+}
+
+TEST(FigureServerTest, ServesConcurrentTcpClients) {
+    SharedFigureStore<double> store;
+    FigureServer<double> server(ServerAddress::parse("tcp:0"), store, 2);
+    ASSERT_NE(server.getAddress().port, 0);
+    LoadReport report = runServerLoad(server.getAddress(), 4, 200, 8);
+    EXPECT_EQ(report.requests, 800u);
+    EXPECT_EQ(report.commands, 6400u);
+    EXPECT_EQ(report.latency.getCount(), 800u);
+    EXPECT_EQ(server.getFrameCount(), 800u);
+    server.stop();
+    EXPECT_THROW(FigureClient client(server.getAddress()), std::system_error);
+}
+
+TEST(ChunkedArrayTest, GrowsByBlocksAndKeepsAddresses) {
+    ChunkedArray<int, 8> arr;
+    arr.pushBack(0);
+    int* first = &arr[0];
+    for (int i = 1; i < 100; ++i) {
+        arr.pushBack(i);
+    }
+    EXPECT_EQ(first, &arr[0]);
+    EXPECT_EQ(*first, 0);
+    EXPECT_EQ(arr.getSize(), 100u);
+    EXPECT_EQ(arr.getBlockCount(), 13u);
+    EXPECT_EQ(arr.getCapacity(), 104u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(arr[i], i);
+    }
+    EXPECT_THROW(arr[100], std::out_of_range);
+}
+
+TEST(ChunkedArrayTest, InsertAndRemoveAcrossBlocks) {
+    ChunkedArray<std::shared_ptr<Figure<double>>, 4> arr;
+    for (int i = 0; i < 10; ++i) {
+        arr.pushBack(std::make_shared<Square<double>>(Point<double>(0, 0), Point<double>(i + 1, 0),
+                                                      Point<double>(i + 1, i + 1), Point<double>(0, i + 1)));
+    }
+    arr.remove(2);
+    EXPECT_EQ(arr.getSize(), 9u);
+    EXPECT_NEAR(arr[2]->area(), 16.0, 1e-9);
+    EXPECT_NEAR(arr[8]->area(), 100.0, 1e-9);
+    arr.insert(0, arr[8]);
+    EXPECT_NEAR(arr[0]->area(), 100.0, 1e-9);
+    EXPECT_NEAR(arr[4]->area(), 25.0, 1e-9);
+    EXPECT_THROW(arr.insert(11, nullptr), std::out_of_range);
+    EXPECT_THROW(arr.remove(10), std::out_of_range);
+
+    size_t seen = 0;
+    arr.forEachBlock([&seen](const std::shared_ptr<Figure<double>>*, size_t count) { seen += count; });
+    EXPECT_EQ(seen, 10u);
+
+    ChunkedArray<std::shared_ptr<Figure<double>>, 4> moved(std::move(arr));
+    EXPECT_EQ(moved.getSize(), 10u);
+    EXPECT_TRUE(arr.isEmpty());
+    moved.clear();
+    EXPECT_TRUE(moved.isEmpty());
+    EXPECT_EQ(moved.getCapacity(), 12u);
+}
+
+TEST(ChunkedArrayTest, BlockIndexSpansManyDirectories) {
+    // Блок на элемент: 1000 блоков раскладываются по каталогам 1, 2, 4, ... 512.
+    ChunkedArray<int, 1> arr;
+    std::vector<int*> addresses;
+    for (int i = 0; i < 1000; ++i) {
+        arr.pushBack(i);
+        addresses.push_back(&arr[i]);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(&arr[i], addresses[i]);
+        EXPECT_EQ(arr[i], i);
+    }
+    EXPECT_EQ(arr.getBlockCount(), 1000u);
+    EXPECT_EQ(arr.memoryUsage(), sizeof(arr) + 1023 * sizeof(int*) + 1000 * sizeof(int));
+
+    ChunkedArray<int, 1> reserved(5);
+    EXPECT_EQ(reserved.getCapacity(), 5u);
+    reserved.pushBack(42);
+    reserved = std::move(arr);
+    EXPECT_EQ(reserved.getSize(), 1000u);
+    EXPECT_EQ(reserved[999], 999);
+    EXPECT_EQ(arr.getCapacity(), 0u);
+}
+
+TEST(ArrayTest, RangeAccessAndReduce) {
+    Array<int> arr;
+    for (int i = 1; i <= 10; ++i) {
+        arr.pushBack(i);
+    }
+    int total = 0;
+    for (int value : arr) {
+        total += value;
+    }
+    EXPECT_EQ(total, 55);
+    EXPECT_EQ(arr.span().size(), 10u);
+    EXPECT_EQ(arr.span()[9], 10);
+    EXPECT_EQ(arr.atUnchecked(4), 5);
+
+    arr.forEach([](int& value) { value *= 2; });
+    EXPECT_EQ(arr[9], 20);
+    EXPECT_EQ(arr.transformReduce(0, std::plus<>(), [](int value) { return value; }), 110);
+    EXPECT_EQ(arr.transformReduce(1, [](int a, int b) { return std::max(a, b); }, [](int value) { return value; }), 20);
+
+    Array<int> small;
+    small.pushBack(3);
+    EXPECT_EQ(small.transformReduce(7, std::plus<>(), [](int value) { return value * value; }), 16);
+    Array<int> empty;
+    EXPECT_EQ(empty.transformReduce(5, std::plus<>(), [](int value) { return value; }), 5);
+    EXPECT_EQ(empty.begin(), empty.end());
+}
+
+TEST(FigureBatchTest, MaskMatchesConstructors) {
+    std::mt19937 rng(44);
+    std::uniform_real_distribution<double> coord(-50.0, 50.0);
+    const size_t rows = 150;
+    std::vector<double> xs(4 * rows), ys(4 * rows);
+    for (size_t r = 0; r < rows; ++r) {
+        double x = coord(rng), y = coord(rng), w = 1.0 + r % 7;
+        double px[4] = {x, x + w, x + w, x}, py[4] = {y, y, y + w, y + w};
+        if (r % 10 == 3) {
+            py[2] = py[3] = y;
+        }
+        if (r % 10 == 7) {
+            px[1] = px[2] = px[3] = x;
+            py[1] = py[2] = py[3] = y;
+        }
+        std::copy(px, px + 4, xs.begin() + 4 * r);
+        std::copy(py, py + 4, ys.begin() + 4 * r);
+    }
+
+    Array<std::shared_ptr<Figure<double>>> out;
+    BatchMask invalid = Rectangle<double>::makeBatch(xs, ys, out);
+    ASSERT_EQ(invalid.getSize(), rows);
+    EXPECT_EQ(invalid.count(), 30u);
+    EXPECT_EQ(out.getSize(), rows - 30);
+    size_t next = 0;
+    for (size_t r = 0; r < rows; ++r) {
+        Point<double> p[4];
+        for (size_t k = 0; k < 4; ++k) {
+            p[k] = Point<double>(xs[4 * r + k], ys[4 * r + k]);
+        }
+        bool rejected = false;
+        try {
+            Rectangle<double> single(p[0], p[1], p[2], p[3]);
+            ASSERT_LT(next, out.getSize());
+            EXPECT_EQ(out[next]->area(), single.area());
+            EXPECT_EQ(out[next]->getVertex(2).x, p[2].x);
+            EXPECT_NE(dynamic_cast<Rectangle<double>*>(out[next].get()), nullptr);
+            ++next;
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        EXPECT_EQ(invalid.test(r), rejected) << r;
+    }
+    EXPECT_EQ(next, out.getSize());
+    EXPECT_THROW(invalid.test(rows), std::out_of_range);
+}
+
+TEST(FigureBatchTest, AppendsToCollectionAndChecksSizes) {
+    std::vector<float> xs = {0, 2, 2, 0, 0, 3, 2.25f, 0.75f};
+    std::vector<float> ys = {0, 0, 2, 2, 0, 0, 1, 1};
+    Array<std::shared_ptr<Figure<float>>> out;
+    out.pushBack(std::make_shared<Square<float>>(Point<float>(0, 0), Point<float>(1, 0), Point<float>(1, 1), Point<float>(0, 1)));
+    EXPECT_EQ(Square<float>::makeBatch(std::span<const float>(xs.data(), 4), std::span<const float>(ys.data(), 4), out).count(), 0u);
+    EXPECT_EQ(Trapezoid<float>::makeBatch(std::span<const float>(xs.data() + 4, 4), std::span<const float>(ys.data() + 4, 4), out).count(), 0u);
+    ASSERT_EQ(out.getSize(), 3u);
+    EXPECT_FLOAT_EQ(out[1]->area(), 4.0f);
+    EXPECT_FLOAT_EQ(out[2]->area(), 2.25f);
+
+    std::vector<float> odd(6), fewer(4);
+    EXPECT_THROW(Square<float>::makeBatch(odd, odd, out), std::invalid_argument);
+    EXPECT_THROW(Square<float>::makeBatch(std::span<const float>(xs), fewer, out), std::invalid_argument);
+    EXPECT_EQ(Square<float>::makeBatch(std::span<const float>(), std::span<const float>(), out).getSize(), 0u);
+    EXPECT_EQ(out.getSize(), 3u);
+}
+
+TEST(FigureQueryTest, FusedQueryMatchesLoop) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    for (int i = 0; i < 30; ++i) {
+        double x = i * 3.0, w = 1.0 + i % 4;
+        Point<double> a(x, 0), b(x + w, 0), c(x + 0.75 * w, 2), d(x + 0.25 * w, 2);
+        if (i % 3 == 0) {
+            figures.pushBack(std::make_shared<Trapezoid<double>>(a, b, c, d));
+        } else {
+            figures.pushBack(std::make_shared<Rectangle<double>>(a, b, Point<double>(x + w, 2), Point<double>(x, 2)));
+        }
+    }
+
+    size_t expectedCount = 0;
+    double cx = 0.0, cy = 0.0, area = 0.0;
+    for (size_t i = 0; i < figures.getSize(); ++i) {
+        if (dynamic_cast<const Trapezoid<double>*>(figures[i].get()) && figures[i]->area() > 3.0) {
+            ++expectedCount;
+            cx += figures[i]->Center().x * 2.0 + 10.0;
+            cy += figures[i]->Center().y * 2.0 - 1.0;
+            area += figures[i]->area() * 4.0;
+        }
+    }
+    ASSERT_GT(expectedCount, 0u);
+
+    auto selected = query(figures)
+                        .ofType<Trapezoid<double>>()
+                        .filter([](const Trapezoid<double>& t) { return t.area() > 3.0; })
+                        .transform(2.0, 0.0, 0.0)
+                        .translate(10.0, -1.0);
+    EXPECT_EQ(selected.count(), expectedCount);
+    Point<double> centers = selected.sum([](const auto& t) { return t.Center(); });
+    EXPECT_NEAR(centers.x, cx, 1e-9);
+    EXPECT_NEAR(centers.y, cy, 1e-9);
+    EXPECT_NEAR(selected.sum([](const auto& t) { return t.area(); }), area, 1e-9);
+    TransformedFigure<double> first = *selected.begin();
+    EXPECT_GT(first.source().area(), 3.0);
+    EXPECT_DOUBLE_EQ(first.getVertex(2).x, first.source().getVertex(2).x * 2.0 + 10.0);
+    EXPECT_DOUBLE_EQ(first.getVertex(2).y, 3.0);
+    EXPECT_EQ(query(figures).count(), 30u);
+    EXPECT_EQ(query(figures).reduce(size_t(0), [](size_t n, const Figure<double>& f) { return n + f.getVertexCount(); }), 120u);
+}
+
+TEST(FigureQueryTest, ComposesWithStdRanges) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    for (int i = 1; i <= 5; ++i) {
+        figures.pushBack(std::make_shared<Square<double>>(Point<double>(0, 0), Point<double>(i, 0), Point<double>(i, i),
+                                                          Point<double>(0, i)));
+    }
+    auto areas = query(figures).map([](const Figure<double>& f) { return f.area(); });
+    static_assert(std::ranges::view<decltype(areas)>);
+    EXPECT_EQ(std::ranges::distance(areas), 5);
+    double firstTwo = 0.0;
+    for (double a : areas | std::views::take(2)) {
+        firstTwo += a;
+    }
+    EXPECT_DOUBLE_EQ(firstTwo, 5.0);
+    EXPECT_DOUBLE_EQ(*std::ranges::max_element(areas), 25.0);
+    EXPECT_DOUBLE_EQ(areas.sum(), 55.0);
+    EXPECT_EQ(query(figures).ofType<Rectangle<double>>().count(), 0u);
+}
+
+TEST(SlotMapTest, HandlesSurviveRemovalAndDetectStale) {
+    SlotMap<std::shared_ptr<Figure<double>>> map;
+    std::vector<SlotHandle> handles;
+    for (int i = 1; i <= 6; ++i) {
+        handles.push_back(map.insert(std::make_shared<Square<double>>(Point<double>(0, 0), Point<double>(i, 0),
+                                                                      Point<double>(i, i), Point<double>(0, i))));
+    }
+    EXPECT_TRUE(map.remove(handles[1]));
+    EXPECT_FALSE(map.remove(handles[1]));
+    EXPECT_FALSE(map.contains(handles[1]));
+    EXPECT_EQ(map.find(handles[1]), nullptr);
+    EXPECT_THROW(map[handles[1]], std::invalid_argument);
+    EXPECT_FALSE(map.contains(SlotHandle{}));
+    for (size_t i : {0u, 2u, 3u, 4u, 5u}) {
+        EXPECT_NEAR(map[handles[i]]->area(), double((i + 1) * (i + 1)), 1e-9);
+    }
+
+    // Освободившийся слот переиспользуется с новым поколением.
+    SlotHandle reused = map.insert(nullptr);
+    EXPECT_EQ(reused.index, handles[1].index);
+    EXPECT_NE(reused.generation, handles[1].generation);
+    EXPECT_FALSE(map.contains(handles[1]));
+    EXPECT_EQ(map[reused], nullptr);
+    EXPECT_EQ(map.getSize(), 6u);
+    EXPECT_EQ(map.getSlotCount(), 6u);
+
+    size_t visited = 0;
+    for (size_t p = 0; p < map.getSize(); ++p) {
+        EXPECT_EQ(map.find(map.handleAt(p)), &map.span()[p]);
+        ++visited;
+    }
+    EXPECT_EQ(visited, 6u);
+    EXPECT_THROW(map.handleAt(6), std::out_of_range);
+
+    map.clear();
+    EXPECT_TRUE(map.isEmpty());
+    EXPECT_FALSE(map.contains(handles[0]));
+    EXPECT_FALSE(map.contains(reused));
+}
+
+TEST(SlotMapTest, ChurnMatchesReferenceModel) {
+    SlotMap<int> map;
+    std::vector<std::pair<SlotHandle, int>> live;
+    std::vector<SlotHandle> dead;
+    std::mt19937 rng(46);
+    for (int step = 0; step < 20000; ++step) {
+        if (live.empty() || rng() % 3 != 0) {
+            live.emplace_back(map.insert(step), step);
+        } else {
+            size_t victim = rng() % live.size();
+            ASSERT_TRUE(map.remove(live[victim].first));
+            dead.push_back(live[victim].first);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+    }
+    ASSERT_EQ(map.getSize(), live.size());
+    for (const auto& [handle, value] : live) {
+        ASSERT_EQ(map[handle], value);
+    }
+    for (const SlotHandle& handle : dead) {
+        ASSERT_FALSE(map.contains(handle));
+    }
+    long long expected = 0, actual = 0;
+    for (const auto& entry : live) {
+        expected += entry.second;
+    }
+    for (int value : map) {
+        actual += value;
+    }
+    EXPECT_EQ(actual, expected);
+    EXPECT_LE(map.getSlotCount(), live.size() + dead.size());
+}
+
+TEST(ShmStoreTest, ReaderSeesPublishedFigures) {
+    const std::string segment = "/laba4_test_" + std::to_string(getpid());
+    ShmFigureStore store(segment, 4);
+    store.pushBack(Square<double>(Point<double>(0, 0), Point<double>(2, 0), Point<double>(2, 2), Point<double>(0, 2)));
+    store.pushBack(Trapezoid<float>(Point<float>(10, 0), Point<float>(14, 0), Point<float>(13, 2), Point<float>(11, 2)));
+
+    ShmFigureView view(segment);
+    ASSERT_EQ(view.getSize(), 2u);
+    EXPECT_DOUBLE_EQ(view.area(0), 4.0);
+    EXPECT_DOUBLE_EQ(view.area(1), 6.0);
+    EXPECT_DOUBLE_EQ(view.center(1).x, 12.0);
+    EXPECT_DOUBLE_EQ(view.box(1).maxX, 14.0);
+    EXPECT_EQ(view.kind(1), FigureKind::Trapezoid);
+    EXPECT_DOUBLE_EQ(view.totalArea(), 10.0);
+    EXPECT_EQ(view.countIntersecting(BoundingBox<double>{1, 1, 11, 1}), 2u);
+    EXPECT_THROW(view.area(2), std::out_of_range);
+
+    store.batch([](ShmFigureStore& s) {
+        s.remove(0);
+        s.set(0, Rectangle<double>(Point<double>(0, 0), Point<double>(3, 0), Point<double>(3, 1), Point<double>(0, 1)));
+    });
+    EXPECT_EQ(view.getSize(), 1u);
+    EXPECT_DOUBLE_EQ(view.totalArea(), 3.0);
+    EXPECT_EQ(view.getVersion(), store.getVersion());
+
+    Polygon<double> pentagon{Point<double>(0, 0), Point<double>(2, 0), Point<double>(3, 1), Point<double>(1, 3), Point<double>(-1, 1)};
+    EXPECT_THROW(store.pushBack(pentagon), std::invalid_argument);
+    store.pushBack(Square<double>(Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1)));
+    store.pushBack(Square<double>(Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1)));
+    store.pushBack(Square<double>(Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1)));
+    EXPECT_THROW(store.pushBack(pentagon), std::invalid_argument);
+    EXPECT_THROW(store.pushBack(Square<double>(Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1))),
+                 std::length_error);
+    EXPECT_THROW(ShmFigureView("/laba4_missing_segment"), std::system_error);
+    EXPECT_THROW(ShmFigureStore("no_slash", 1), std::invalid_argument);
+}
+
+TEST(ShmStoreTest, ReaderProcessesNeverSeeTornVersions) {
+    // Писатель переписывает все записи квадратами одной стороны за пакет,
+    // дочерние процессы проверяют, что видят записи только одной версии.
+    const std::string segment = "/laba4_stress_" + std::to_string(getpid());
+    const size_t figures = 256;
+    ShmFigureStore store(segment, figures);
+    auto square = [](size_t i, double side) {
+        double x = static_cast<double>(i) * 100.0;
+        return Square<double>(Point<double>(x, 0), Point<double>(x + side, 0), Point<double>(x + side, side), Point<double>(x, side));
+    };
+    for (size_t i = 0; i < figures; ++i) {
+        store.pushBack(square(i, 1.0));
+    }
+
+    std::vector<pid_t> readers;
+    for (int r = 0; r < 2; ++r) {
+        pid_t pid = fork();
+        ASSERT_GE(pid, 0);
+        if (pid == 0) {
+            int status = 0;
+            try {
+                ShmFigureView view(segment);
+                uint64_t lastVersion = 0;
+                for (int iteration = 0; iteration < 20000 && status == 0; ++iteration) {
+                    struct Check {
+                        bool consistent;
+                        double side;
+                    };
+                    Check check = view.read([](std::span<const ShmFigureRecord> all) {
+                        double side = all[0].xs[1] - all[0].xs[0];
+                        bool consistent = all.size() == 256;
+                        for (const ShmFigureRecord& record : all) {
+                            consistent = consistent && record.area == side * side && record.maxY == side &&
+                                         record.centerY == side / 2.0 && record.xs[1] - record.xs[0] == side;
+                        }
+                        return Check{consistent, side};
+                    });
+                    uint64_t version = view.getVersion();
+                    if (!check.consistent || version < lastVersion) {
+                        status = 1;
+                    }
+                    lastVersion = version;
+                }
+            } catch (...) {
+                status = 2;
+            }
+            _exit(status);
+        }
+        readers.push_back(pid);
+    }
+
+    for (int round = 0; round < 3000; ++round) {
+        double side = 1.0 + round % 50;
+        store.batch([&](ShmFigureStore& s) {
+            for (size_t i = 0; i < figures; ++i) {
+                s.set(i, square(i, side));
+            }
+        });
+    }
+    for (pid_t pid : readers) {
+        int status = -1;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+    }
+}
+
+TEST(ShmStoreTest, DeadOrBusyWriterDoesNotHangReaders) {
+    const std::string segment = "/laba4_dead_" + std::to_string(getpid());
+    auto unit = Square<double>(Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1));
+
+    // Писатель завершается посреди пакета и оставляет нечетный счетчик.
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        ShmFigureStore dying(segment, 4);
+        dying.pushBack(unit);
+        dying.batch([](ShmFigureStore&) { _exit(0); });
+        _exit(1);
+    }
+    int status = -1;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    {
+        ShmFigureView orphan(segment);
+        EXPECT_THROW(orphan.totalArea(), std::runtime_error);
+    }
+
+    // Брошенный сегмент можно пересоздать, а занятый живым писателем — нет.
+    ShmFigureStore store(segment, 4);
+    store.pushBack(unit);
+    EXPECT_THROW(ShmFigureStore(segment, 4), std::runtime_error);
+    ShmFigureView view(segment);
+    EXPECT_DOUBLE_EQ(view.totalArea(), 1.0);
+
+    // Живой писатель, застрявший в пакете, ограничен временем чтения.
+    view.setReadTimeout(std::chrono::milliseconds(50));
+    store.batch([&](ShmFigureStore&) { EXPECT_THROW(view.totalArea(), std::runtime_error); });
+    EXPECT_DOUBLE_EQ(view.totalArea(), 1.0);
+}
+
+TEST(ShmStoreTest, ConcurrentWritersTakeOverAbandonedSegmentOnce) {
+    const std::string segment = "/laba4_takeover_" + std::to_string(getpid());
+    auto unit = Square<double>(Point<double>(0, 0), Point<double>(1, 0), Point<double>(1, 1), Point<double>(0, 1));
+
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        ShmFigureStore abandoned(segment, 4);
+        _exit(0);
+    }
+    int status = -1;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+
+    // Несколько писателей одновременно заменяют брошенный сегмент: выжить должен ровно один,
+    // и имя должно указывать на его сегмент.
+    int attempted[2];
+    int release[2];
+    ASSERT_EQ(pipe(attempted), 0);
+    ASSERT_EQ(pipe(release), 0);
+    const int writers = 8;
+    std::vector<pid_t> children;
+    for (int w = 0; w < writers; ++w) {
+        pid_t child = fork();
+        ASSERT_GE(child, 0);
+        if (child == 0) {
+            close(attempted[0]);
+            close(release[1]);
+            char byte = 0;
+            try {
+                {
+                    ShmFigureStore store(segment, 4);
+                    store.pushBack(unit);
+                    (void)!write(attempted[1], &byte, 1);
+                    (void)!read(release[0], &byte, 1);
+                }
+                _exit(0);
+            } catch (const std::runtime_error&) {
+                (void)!write(attempted[1], &byte, 1);
+                _exit(2);
+            }
+        }
+        children.push_back(child);
+    }
+    close(attempted[1]);
+    close(release[0]);
+    char byte;
+    for (int w = 0; w < writers; ++w) {
+        ASSERT_EQ(read(attempted[0], &byte, 1), 1);
+    }
+    {
+        ShmFigureView view(segment);
+        EXPECT_DOUBLE_EQ(view.totalArea(), 1.0);
+    }
+    close(release[1]);
+    close(attempted[0]);
+    int winners = 0;
+    for (pid_t child : children) {
+        ASSERT_EQ(waitpid(child, &status, 0), child);
+        ASSERT_TRUE(WIFEXITED(status));
+        winners += WEXITSTATUS(status) == 0;
+    }
+    EXPECT_EQ(winners, 1);
+}
+
+TEST(TraceTest, RingKeepsNewestSpansAndCountsDropped) {
+    Tracer tracer;
+    {
+        TraceSpan span("disabled", tracer);
+    }
+    EXPECT_EQ(tracer.getEventCount(), 0u);
+    EXPECT_EQ(tracer.getThreadCount(), 0u);
+
+    tracer.enable(4);
+    const char* names[] = {"a", "b", "c", "d", "e", "f"};
+    for (const char* name : names) {
+        TraceSpan span(name, tracer);
+    }
+    EXPECT_EQ(tracer.getEventCount(), 4u);
+    EXPECT_EQ(tracer.getDroppedCount(), 2u);
+
+    std::ostringstream out;
+    tracer.writeChromeTrace(out);
+    std::string json = out.str();
+    EXPECT_EQ(json.find("\"name\":\"b\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"c\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_LT(json.find("\"name\":\"c\""), json.find("\"name\":\"f\""));
+
+    tracer.disable();
+    {
+        TraceSpan span("after", tracer);
+    }
+    EXPECT_EQ(tracer.getEventCount(), 4u);
+}
+
+TEST(TraceTest, ThreadsWriteSeparateRings) {
+    Tracer tracer;
+    tracer.enable(64);
+    {
+        TraceSpan outer("main", tracer);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 3; ++t) {
+            threads.emplace_back([&tracer] {
+                for (int i = 0; i < 10; ++i) {
+                    TraceSpan span("worker", tracer);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+    EXPECT_EQ(tracer.getThreadCount(), 4u);
+    EXPECT_EQ(tracer.getEventCount(), 31u);
+    EXPECT_EQ(tracer.getDroppedCount(), 0u);
+
+    std::ostringstream out;
+    tracer.writeChromeTrace(out);
+    std::string json = out.str();
+    for (int tid = 1; tid <= 4; ++tid) {
+        EXPECT_NE(json.find("\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(tid)), std::string::npos);
+    }
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.substr(json.size() - 3), "]}\n");
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
 }
\ No newline at end of file
@@ -0,0 +1,308 @@
+#ifndef TILE_PYRAMID_H
+#define TILE_PYRAMID_H
+
+#include "figure.h"
+#include "array.h"
+#include "bounding_box.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// Сводка по тайлу: число фигур, их суммарная площадь и общий ограничивающий прямоугольник.
+struct TileSummary {
+    size_t level = 0;
+    size_t x = 0;
+    size_t y = 0;
+    size_t count = 0;
+    double area = 0.0;
+    BoundingBox<double> box{0.0, 0.0, 0.0, 0.0};
+};
+
+// Пирамида тайлов (квадродерево) над центрами фигур для масштабируемых видов.
+//
+// Мир [world] делится на уровни: на уровне l 2^l x 2^l тайлов, последний уровень —
+// листья. Фигура попадает в лист по своему Center() (центры вне мира прижимаются
+// к краевым тайлам). Лист хранит центр, площадь и прямоугольник каждой фигуры,
+// остальные тайлы — только сводку по четырем детям. Добавление дополняет сводки
+// на пути от листа к корню за O(levels); удаление пересчитывает лист (прямоугольник
+// не уменьшить вычитанием) и его предков за O(размер листа + levels).
+// Запрос тайлов окна стоит столько, сколько тайлов видно, а не сколько фигур в коллекции.
+template<Scalar T>
+class TilePyramid {
+private:
+    struct Entry {
+        Point<double> center;
+        double area;
+        BoundingBox<double> box;
+    };
+
+    struct Tile {
+        size_t count = 0;
+        double area = 0.0;
+        BoundingBox<double> box{0.0, 0.0, 0.0, 0.0};
+    };
+
+    BoundingBox<double> world;
+    size_t levels;
+    std::vector<std::vector<Tile>> tiles;
+    std::vector<std::vector<Entry>> leaves;
+
+    size_t side(size_t level) const { return size_t(1) << level; }
+
+    size_t cell(double value, double low, double high, size_t level) const {
+        double t = (value - low) / (high - low) * static_cast<double>(side(level));
+        if (!(t > 0.0)) {
+            return 0;
+        }
+        return std::min(side(level) - 1, static_cast<size_t>(t));
+    }
+
+    size_t cellX(double x, size_t level) const { return cell(x, world.minX, world.maxX, level); }
+    size_t cellY(double y, size_t level) const { return cell(y, world.minY, world.maxY, level); }
+
+    static void merge(Tile& target, size_t count, double area, const BoundingBox<double>& box) {
+        if (count == 0) {
+            return;
+        }
+        if (target.count == 0) {
+            target.box = box;
+        } else {
+            target.box.expand(box);
+        }
+        target.count += count;
+        target.area += area;
+    }
+
+    static Entry makeEntry(const Figure<T>& figure) {
+        Point<T> center = figure.Center();
+        BoundingBox<T> box = boundingBox(figure);
+        return Entry{Point<double>(static_cast<double>(center.x), static_cast<double>(center.y)),
+                     static_cast<double>(figure.area()),
+                     BoundingBox<double>{static_cast<double>(box.minX), static_cast<double>(box.minY),
+                                         static_cast<double>(box.maxX), static_cast<double>(box.maxY)}};
+    }
+
+    void rebuildLeaf(size_t x, size_t y) {
+        size_t leafLevel = levels - 1;
+        Tile leaf;
+        for (const Entry& entry : leaves[y * side(leafLevel) + x]) {
+            merge(leaf, 1, entry.area, entry.box);
+        }
+        tiles[leafLevel][y * side(leafLevel) + x] = leaf;
+    }
+
+    void rebuildParent(size_t level, size_t x, size_t y) {
+        Tile parent;
+        for (size_t dy = 0; dy < 2; ++dy) {
+            for (size_t dx = 0; dx < 2; ++dx) {
+                const Tile& child = tiles[level + 1][(2 * y + dy) * side(level + 1) + 2 * x + dx];
+                merge(parent, child.count, child.area, child.box);
+            }
+        }
+        tiles[level][y * side(level) + x] = parent;
+    }
+
+    // Пересчитывает лист и всех его предков.
+    void refresh(size_t x, size_t y) {
+        rebuildLeaf(x, y);
+        for (size_t level = levels - 1; level > 0; --level) {
+            x /= 2;
+            y /= 2;
+            rebuildParent(level - 1, x, y);
+        }
+    }
+
+    TileSummary summary(size_t level, size_t x, size_t y) const {
+        const Tile& tile = tiles[level][y * side(level) + x];
+        return TileSummary{level, x, y, tile.count, tile.area, tile.box};
+    }
+
+    BoundingBox<double> tileBounds(size_t level, size_t x, size_t y) const {
+        double width = (world.maxX - world.minX) / static_cast<double>(side(level));
+        double height = (world.maxY - world.minY) / static_cast<double>(side(level));
+        return BoundingBox<double>{world.minX + width * static_cast<double>(x), world.minY + height * static_cast<double>(y),
+                                   world.minX + width * static_cast<double>(x + 1),
+                                   world.minY + height * static_cast<double>(y + 1)};
+    }
+
+    void aggregate(size_t level, size_t x, size_t y, const BoundingBox<double>& viewport, TileSummary& result) const {
+        const Tile& tile = tiles[level][y * side(level) + x];
+        if (tile.count == 0) {
+            return;
+        }
+        // Краевые тайлы собирают и прижатые центры вне мира, поэтому их границы
+        // со стороны края мира уходят в бесконечность.
+        BoundingBox<double> bounds = tileBounds(level, x, y);
+        const double infinity = std::numeric_limits<double>::infinity();
+        if (x == 0) {
+            bounds.minX = -infinity;
+        }
+        if (y == 0) {
+            bounds.minY = -infinity;
+        }
+        if (x + 1 == side(level)) {
+            bounds.maxX = infinity;
+        }
+        if (y + 1 == side(level)) {
+            bounds.maxY = infinity;
+        }
+        if (!bounds.intersects(viewport)) {
+            return;
+        }
+        if (viewport.minX <= bounds.minX && bounds.maxX <= viewport.maxX &&
+            viewport.minY <= bounds.minY && bounds.maxY <= viewport.maxY) {
+            mergeSummary(result, TileSummary{0, 0, 0, tile.count, tile.area, tile.box});
+            return;
+        }
+        if (level + 1 == levels) {
+            for (const Entry& entry : leaves[y * side(level) + x]) {
+                if (viewport.contains(entry.center)) {
+                    mergeSummary(result, TileSummary{0, 0, 0, 1, entry.area, entry.box});
+                }
+            }
+            return;
+        }
+        for (size_t dy = 0; dy < 2; ++dy) {
+            for (size_t dx = 0; dx < 2; ++dx) {
+                aggregate(level + 1, 2 * x + dx, 2 * y + dy, viewport, result);
+            }
+        }
+    }
+
+    static void mergeSummary(TileSummary& target, const TileSummary& part) {
+        if (part.count == 0) {
+            return;
+        }
+        if (target.count == 0) {
+            target.box = part.box;
+        } else {
+            target.box.expand(part.box);
+        }
+        target.count += part.count;
+        target.area += part.area;
+    }
+
+public:
+    TilePyramid(const BoundingBox<double>& worldBounds, size_t levelCount = 8)
+        : world(worldBounds), levels(levelCount) {
+        if (levels == 0 || levels > 15) {
+            throw std::invalid_argument("число уровней должно быть от 1 до 15");
+        }
+        if (!(world.maxX > world.minX) || !(world.maxY > world.minY)) {
+            throw std::invalid_argument("пустая область мира");
+        }
+        tiles.resize(levels);
+        for (size_t level = 0; level < levels; ++level) {
+            tiles[level].resize(side(level) * side(level));
+        }
+        leaves.resize(side(levels - 1) * side(levels - 1));
+    }
+
+    void add(const Figure<T>& figure) {
+        Entry entry = makeEntry(figure);
+        size_t x = cellX(entry.center.x, levels - 1);
+        size_t y = cellY(entry.center.y, levels - 1);
+        leaves[y * side(levels - 1) + x].push_back(entry);
+        // При добавлении сводки только растут, поэтому пересчет из детей не нужен.
+        for (size_t level = levels; level > 0; --level) {
+            merge(tiles[level - 1][y * side(level - 1) + x], 1, entry.area, entry.box);
+            x /= 2;
+            y /= 2;
+        }
+    }
+
+    // Удаляет фигуру с теми же центром, площадью и прямоугольником; false, если такой нет.
+    bool remove(const Figure<T>& figure) {
+        Entry entry = makeEntry(figure);
+        size_t x = cellX(entry.center.x, levels - 1);
+        size_t y = cellY(entry.center.y, levels - 1);
+        std::vector<Entry>& leaf = leaves[y * side(levels - 1) + x];
+        auto found = std::find_if(leaf.begin(), leaf.end(), [&entry](const Entry& e) {
+            return e.center.x == entry.center.x && e.center.y == entry.center.y && e.area == entry.area &&
+                   e.box.minX == entry.box.minX && e.box.minY == entry.box.minY &&
+                   e.box.maxX == entry.box.maxX && e.box.maxY == entry.box.maxY;
+        });
+        if (found == leaf.end()) {
+            return false;
+        }
+        *found = leaf.back();
+        leaf.pop_back();
+        refresh(x, y);
+        return true;
+    }
+
+    // Полное построение: раскладка по листьям и один проход снизу вверх, O(n + число тайлов).
+    void build(const Array<std::shared_ptr<Figure<T>>>& figures) {
+        clear();
+        size_t leafSide = side(levels - 1);
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            Entry entry = makeEntry(*figures[i]);
+            leaves[cellY(entry.center.y, levels - 1) * leafSide + cellX(entry.center.x, levels - 1)].push_back(entry);
+        }
+        for (size_t y = 0; y < leafSide; ++y) {
+            for (size_t x = 0; x < leafSide; ++x) {
+                rebuildLeaf(x, y);
+            }
+        }
+        for (size_t level = levels - 1; level > 0; --level) {
+            for (size_t y = 0; y < side(level - 1); ++y) {
+                for (size_t x = 0; x < side(level - 1); ++x) {
+                    rebuildParent(level - 1, x, y);
+                }
+            }
+        }
+    }
+
+    void clear() {
+        for (std::vector<Tile>& level : tiles) {
+            std::fill(level.begin(), level.end(), Tile());
+        }
+        for (std::vector<Entry>& leaf : leaves) {
+            leaf.clear();
+        }
+    }
+
+    // Уровень, на котором окно накрывает примерно tilesAcross тайлов по ширине.
+    size_t levelFor(const BoundingBox<double>& viewport, size_t tilesAcross = 32) const {
+        double ratio = (world.maxX - world.minX) / std::max(viewport.maxX - viewport.minX, 1e-300);
+        double level = std::log2(std::max(1.0, ratio * static_cast<double>(tilesAcross)));
+        return std::min(levels - 1, static_cast<size_t>(level));
+    }
+
+    // Непустые тайлы уровня level, пересекающие окно: время пропорционально числу тайлов окна.
+    // Краевые тайлы, как и в aggregate, продолжаются за край мира: окно вне мира видит
+    // тайлы с прижатыми к ним центрами.
+    std::vector<TileSummary> query(const BoundingBox<double>& viewport, size_t level) const {
+        if (level >= levels) {
+            throw std::out_of_range("Index out of range");
+        }
+        std::vector<TileSummary> visible;
+        size_t x0 = cellX(viewport.minX, level), x1 = cellX(viewport.maxX, level);
+        size_t y0 = cellY(viewport.minY, level), y1 = cellY(viewport.maxY, level);
+        for (size_t y = y0; y <= y1; ++y) {
+            for (size_t x = x0; x <= x1; ++x) {
+                if (tiles[level][y * side(level) + x].count > 0) {
+                    visible.push_back(summary(level, x, y));
+                }
+            }
+        }
+        return visible;
+    }
+
+    // Точная сводка по фигурам, чьи центры лежат в окне: целиком покрытые тайлы берутся
+    // готовыми, перебираются только фигуры листьев на границе окна.
+    TileSummary aggregate(const BoundingBox<double>& viewport) const {
+        TileSummary result;
+        aggregate(0, 0, 0, viewport, result);
+        return result;
+    }
+
+    TileSummary total() const { return summary(0, 0, 0); }
+    size_t getLevelCount() const { return levels; }
+    const BoundingBox<double>& getWorld() const { return world; }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,219 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Завершенный спан: имя (строковый литерал, не копируется), начало и длительность в нс.
+struct SpanRecord {
+    const char* name;
+    uint64_t start;
+    uint64_t duration;
+};
+
+// Кольцевой буфер спанов одного потока. Пишет только поток-владелец, без блокировок;
+// при переполнении затираются самые старые спаны. Снимок, снятый во время записи
+// владельцем, может содержать затираемую в этот момент запись.
+class SpanRing {
+private:
+    std::unique_ptr<SpanRecord[]> records;
+    size_t mask;
+    std::atomic<uint64_t> written{0};
+    std::thread::id owner;
+    uint32_t threadIndex;
+
+public:
+    SpanRing(size_t capacity, std::thread::id ownerThread, uint32_t index)
+        : records(std::make_unique<SpanRecord[]>(capacity)), mask(capacity - 1), owner(ownerThread), threadIndex(index) {}
+
+    void push(const SpanRecord& record) {
+        uint64_t n = written.load(std::memory_order_relaxed);
+        records[n & mask] = record;
+        written.store(n + 1, std::memory_order_release);
+    }
+
+    // Сохранившиеся спаны от старых к новым.
+    std::vector<SpanRecord> snapshot() const {
+        uint64_t n = written.load(std::memory_order_acquire);
+        uint64_t kept = std::min<uint64_t>(n, mask + 1);
+        std::vector<SpanRecord> result;
+        result.reserve(kept);
+        for (uint64_t i = n - kept; i < n; ++i) {
+            result.push_back(records[i & mask]);
+        }
+        return result;
+    }
+
+    uint64_t getWritten() const { return written.load(std::memory_order_acquire); }
+    uint64_t getDropped() const { return getWritten() - std::min<uint64_t>(getWritten(), mask + 1); }
+    std::thread::id getOwner() const { return owner; }
+    uint32_t getThreadIndex() const { return threadIndex; }
+};
+
+// Сборщик спанов: у каждого потока свой SpanRing, который создается при первом спане
+// и живет до разрушения сборщика (и после завершения потока). Выключенный сборщик
+// стоит спану одной атомарной загрузки.
+class Tracer {
+private:
+    // Кэш кольца текущего потока; id сборщиков не повторяются, поэтому кэш
+    // разрушенного сборщика не совпадет ни с одним живым.
+    struct ThreadCache {
+        uint64_t tracerId = 0;
+        SpanRing* ring = nullptr;
+    };
+
+    static std::atomic<uint64_t>& nextId() {
+        static std::atomic<uint64_t> id{1};
+        return id;
+    }
+
+    uint64_t id;
+    std::atomic<bool> enabled{false};
+    size_t ringCapacity = 1 << 16;
+    std::chrono::steady_clock::time_point origin;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<SpanRing>> rings;
+
+    SpanRing& ring() {
+        thread_local ThreadCache cache;
+        if (cache.tracerId != id) {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::thread::id self = std::this_thread::get_id();
+            auto found = std::find_if(rings.begin(), rings.end(),
+                                      [self](const std::unique_ptr<SpanRing>& r) { return r->getOwner() == self; });
+            if (found == rings.end()) {
+                rings.push_back(std::make_unique<SpanRing>(ringCapacity, self, static_cast<uint32_t>(rings.size() + 1)));
+                found = rings.end() - 1;
+            }
+            cache = ThreadCache{id, found->get()};
+        }
+        return *cache.ring;
+    }
+
+public:
+    Tracer() : id(nextId().fetch_add(1)), origin(std::chrono::steady_clock::now()) {}
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    // Сборщик, в который пишут спаны программы по умолчанию.
+    static Tracer& global() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    // capacity — спанов на поток, округляется вверх до степени двойки; действует на новые кольца.
+    void enable(size_t capacity = 1 << 16) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ringCapacity = 1;
+            while (ringCapacity < capacity) {
+                ringCapacity *= 2;
+            }
+        }
+        enabled.store(true, std::memory_order_release);
+    }
+
+    void disable() { enabled.store(false, std::memory_order_release); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    uint64_t now() const {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count());
+    }
+
+    void record(const char* name, uint64_t start, uint64_t end) {
+        ring().push(SpanRecord{name, start, end - start});
+    }
+
+    uint64_t getEventCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t total = 0;
+        for (const std::unique_ptr<SpanRing>& r : rings) {
+            total += r->getWritten() - r->getDropped();
+        }
+        return total;
+    }
+
+    uint64_t getDroppedCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t total = 0;
+        for (const std::unique_ptr<SpanRing>& r : rings) {
+            total += r->getDropped();
+        }
+        return total;
+    }
+
+    size_t getThreadCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return rings.size();
+    }
+
+    // Спаны в формате Chrome trace event (JSON, открывается в Perfetto и chrome://tracing):
+    // по событию "X" на спан, время в микросекундах от создания сборщика.
+    void writeChromeTrace(std::ostream& outS) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        outS << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        auto separator = [&outS, &first] {
+            outS << (first ? "\n" : ",\n");
+            first = false;
+        };
+        auto micros = [](uint64_t ns) { return static_cast<double>(ns) / 1e3; };
+        std::ios::fmtflags flags = outS.flags();
+        std::streamsize precision = outS.precision();
+        outS.setf(std::ios::fixed);
+        outS.precision(3);
+        for (const std::unique_ptr<SpanRing>& r : rings) {
+            separator();
+            outS << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << r->getThreadIndex()
+                 << ",\"args\":{\"name\":\"thread " << r->getThreadIndex() << "\"}}";
+            for (const SpanRecord& span : r->snapshot()) {
+                separator();
+                outS << "{\"name\":\"";
+                for (const char* c = span.name; *c; ++c) {
+                    if (*c == '"' || *c == '\\') {
+                        outS << '\\';
+                    }
+                    outS << *c;
+                }
+                outS << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << r->getThreadIndex() << ",\"ts\":" << micros(span.start)
+                     << ",\"dur\":" << micros(span.duration) << "}";
+            }
+        }
+        outS << "\n]}\n";
+        outS.flags(flags);
+        outS.precision(precision);
+    }
+};
+
+// Спан от создания до разрушения объекта. Если сборщик выключен в момент создания,
+// спан ничего не пишет.
+class TraceSpan {
+private:
+    Tracer* tracer;
+    const char* name;
+    uint64_t start;
+
+public:
+    explicit TraceSpan(const char* spanName, Tracer& target = Tracer::global())
+        : tracer(target.isEnabled() ? &target : nullptr), name(spanName), start(tracer ? tracer->now() : 0) {}
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    ~TraceSpan() {
+        if (tracer) {
+            tracer->record(name, start, tracer->now());
+        }
+    }
+};
+
+#endif
\ No newline at end of file
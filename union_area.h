@@ -0,0 +1,133 @@
+#ifndef UNION_AREA_H
+#define UNION_AREA_H
+
+#include "figure.h"
+#include "array.h"
+#include "bounding_box.h"
+#include "intersection.h"
+#include "parallel.h"
+#include "summation.h"
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace detail {
+
+inline int sign(double value) {
+    return (value > 0.0) - (value < 0.0);
+}
+
+// Параметр точки p на отрезке a + t * (b - a), p лежит на прямой ab.
+inline double lineParameter(const Point<double>& a, const Point<double>& b, const Point<double>& p) {
+    return b.x != a.x ? (p.x - a.x) / (b.x - a.x) : (p.y - a.y) / (b.y - a.y);
+}
+
+}
+
+// Площадь объединения выпуклых фигур (перекрытия считаются один раз); невыпуклая
+// фигура отвергается с std::invalid_argument.
+//
+// Площадь считается по формуле Грина как сумма A × B / 2 по тем частям ребер AB,
+// которые не покрыты другими фигурами. Ребро сравнивается только с фигурами,
+// чьи ограничивающие прямоугольники пересекают прямоугольник его фигуры
+// (кандидаты берутся из сеточной широкой фазы), поэтому при локальных
+// перекрытиях время почти линейно. Совпадающие сонаправленные ребра учитываются
+// у фигуры с меньшим индексом, так что дубликаты не удваивают площадь.
+template<Scalar T>
+double unionArea(const Array<std::shared_ptr<Figure<T>>>& figures, size_t threads = defaultThreadCount()) {
+    size_t n = figures.getSize();
+    std::vector<Contour> contours(n);
+    std::vector<BoundingBox<T>> boxes(n);
+    for (size_t i = 0; i < n; ++i) {
+        contours[i] = toConvexContour(*figures[i]);
+        boxes[i] = boundingBox(*figures[i]);
+    }
+
+    // Списки соседей в формате CSR.
+    std::vector<std::pair<size_t, size_t>> pairs = candidatePairs(boxes, threads);
+    std::vector<size_t> start(n + 1, 0);
+    for (const std::pair<size_t, size_t>& p : pairs) {
+        ++start[p.first + 1];
+        ++start[p.second + 1];
+    }
+    for (size_t i = 1; i <= n; ++i) {
+        start[i] += start[i - 1];
+    }
+    std::vector<size_t> neighbours(start.back());
+    std::vector<size_t> fill(start.begin(), start.end() - 1);
+    for (const std::pair<size_t, size_t>& p : pairs) {
+        neighbours[fill[p.first]++] = p.second;
+        neighbours[fill[p.second]++] = p.first;
+    }
+
+    // Формула Грина инвариантна к сдвигу для замкнутой границы; сдвиг к общей точке
+    // уменьшает потерю точности на больших координатах.
+    Point<double> origin = n > 0 ? contours[0][0] : Point<double>();
+
+    std::vector<NeumaierSum> partial(std::max<size_t>(threads, 1));
+    parallelFor(n, threads, [&](size_t begin, size_t end, size_t part) {
+        std::vector<std::pair<double, int>> segments;
+        for (size_t i = begin; i < end; ++i) {
+            const Contour& poly = contours[i];
+            for (size_t v = 0; v < poly.size(); ++v) {
+                const Point<double>& a = poly[v];
+                const Point<double>& b = poly[(v + 1) % poly.size()];
+                segments.assign({{0.0, 0}, {1.0, 0}});
+                double edgeMinX = std::min(a.x, b.x), edgeMaxX = std::max(a.x, b.x);
+                double edgeMinY = std::min(a.y, b.y), edgeMaxY = std::max(a.y, b.y);
+
+                for (size_t k = start[i]; k < start[i + 1]; ++k) {
+                    size_t j = neighbours[k];
+                    const BoundingBox<T>& box = boxes[j];
+                    if (edgeMaxX < static_cast<double>(box.minX) || static_cast<double>(box.maxX) < edgeMinX ||
+                        edgeMaxY < static_cast<double>(box.minY) || static_cast<double>(box.maxY) < edgeMinY) {
+                        continue;
+                    }
+                    const Contour& other = contours[j];
+                    for (size_t u = 0; u < other.size(); ++u) {
+                        const Point<double>& c = other[u];
+                        const Point<double>& d = other[(u + 1) % other.size()];
+                        int sc = detail::sign(crossProduct(a, b, c));
+                        int sd = detail::sign(crossProduct(a, b, d));
+                        if (sc != sd) {
+                            double sa = crossProduct(c, d, a);
+                            double sb = crossProduct(c, d, b);
+                            if (std::min(sc, sd) < 0) {
+                                segments.emplace_back(sa / (sa - sb), detail::sign(static_cast<double>(sc - sd)));
+                            }
+                        } else if (sc == 0 && j < i &&
+                                   (b.x - a.x) * (d.x - c.x) + (b.y - a.y) * (d.y - c.y) > 0.0) {
+                            segments.emplace_back(detail::lineParameter(a, b, c), 1);
+                            segments.emplace_back(detail::lineParameter(a, b, d), -1);
+                        }
+                    }
+                }
+
+                std::sort(segments.begin(), segments.end());
+                for (std::pair<double, int>& s : segments) {
+                    s.first = std::clamp(s.first, 0.0, 1.0);
+                }
+                double uncovered = 0.0;
+                int depth = segments[0].second;
+                for (size_t s = 1; s < segments.size(); ++s) {
+                    if (depth == 0) {
+                        uncovered += segments[s].first - segments[s - 1].first;
+                    }
+                    depth += segments[s].second;
+                }
+                double ax = a.x - origin.x, ay = a.y - origin.y;
+                double bx = b.x - origin.x, by = b.y - origin.y;
+                partial[part].add((ax * by - ay * bx) * uncovered);
+            }
+        }
+    });
+
+    NeumaierSum total;
+    for (const NeumaierSum& sum : partial) {
+        total.add(sum.value());
+    }
+    return total.value() / 2.0;
+}
+
+#endif
\ No newline at end of file
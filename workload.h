@@ -0,0 +1,449 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "figure.h"
+#include "array.h"
+#include "square.h"
+#include "rectangle.h"
+#include "trapez.h"
+#include "figure_kind.h"
+#include "figure_io.h"
+#include "figure_parser.h"
+#include "bounding_box.h"
+#include "aggregate_array.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+// Доли особых случаев среди сгенерированных фигур.
+struct WorkloadOptions {
+    double extent = 1000.0;          // центры обычных фигур в [-extent, extent]
+    double minSide = 0.1;
+    double maxSide = 10.0;
+    double rotatedShare = 0.25;      // повернуты на случайный угол
+    double degenerateShare = 0.02;   // площадь в 1.5..10 раз больше порога 1e-9
+    double hugeShare = 0.02;         // центры в [-hugeExtent, hugeExtent]
+    double hugeExtent = 1e12;
+};
+
+// Детерминированный генератор корректных квадратов, прямоугольников и трапеций:
+// одно и то же зерно дает одну и ту же последовательность на любой платформе
+// (используются только mt19937_64, собственные преобразования в числа и операции,
+// которые IEEE 754 округляет однозначно; std::cos и std::sin к ним не относятся).
+// Компилятор не должен сливать умножение со сложением (FMA): там, где это включено
+// по умолчанию, нужен -ffp-contract=off.
+template<std::floating_point T>
+class FigureGenerator {
+private:
+    std::mt19937_64 rng;
+    WorkloadOptions options;
+
+    double uniform(double low, double high) {
+        // Старшие 53 бита в [0, 1): в отличие от uniform_real_distribution, не зависит от стандартной библиотеки.
+        double unit = static_cast<double>(rng() >> 11) * 0x1.0p-53;
+        return low + (high - low) * unit;
+    }
+
+    // Вершины в локальных координатах (против часовой стрелки) для заданной площади или сторон.
+    void shape(FigureKind kind, bool degenerate, double (&local)[4][2]) {
+        double w, h;
+        if (degenerate) {
+            double area = 1e-9 * uniform(1.5, 10.0);
+            // Тонкие фигуры: одна сторона обычная, другая крошечная (у квадрата обе крошечные).
+            w = kind == FigureKind::Square ? std::sqrt(area) : uniform(options.minSide, options.maxSide);
+            h = kind == FigureKind::Square ? w : area / w;
+            if (kind == FigureKind::Trapezoid) {
+                h *= 2.0 / 1.5;
+            }
+        } else {
+            w = uniform(options.minSide, options.maxSide);
+            h = kind == FigureKind::Square ? w : uniform(options.minSide, options.maxSide);
+        }
+        double top = kind == FigureKind::Trapezoid ? w * 0.5 : w;
+        double shift = kind == FigureKind::Trapezoid ? w * uniform(0.0, 0.5) : 0.0;
+        double points[4][2] = {{0.0, 0.0}, {w, 0.0}, {shift + top, h}, {shift, h}};
+        for (int i = 0; i < 4; ++i) {
+            local[i][0] = points[i][0] - w / 2;
+            local[i][1] = points[i][1] - h / 2;
+        }
+    }
+
+public:
+    explicit FigureGenerator(uint64_t seed, WorkloadOptions opts = {}) : rng(seed), options(opts) {}
+
+    std::shared_ptr<Figure<T>> next(FigureKind kind) {
+        if (kind == FigureKind::Polygon) {
+            throw std::invalid_argument("генератор строит только четырехугольники");
+        }
+        // Округление особых случаев изредка дает площадь ниже порога; тогда фигура
+        // просто генерируется заново из того же потока чисел.
+        while (true) {
+            double roll = uniform(0.0, 1.0);
+            bool degenerate = roll < options.degenerateShare;
+            bool huge = !degenerate && roll < options.degenerateShare + options.hugeShare;
+            double extent = huge ? options.hugeExtent : options.extent;
+            double cx = uniform(-extent, extent), cy = uniform(-extent, extent);
+            // Поворот задается рационально через t = tg(угол / 2): cos = (1 - t^2) / (1 + t^2),
+            // sin = 2t / (1 + t^2). t из [-1, 1] дает углы от -90 до 90 градусов, второе
+            // значение того же числа из (1, 3] — противоположные им.
+            double c = 1.0, s = 0.0;
+            if (uniform(0.0, 1.0) < options.rotatedShare) {
+                double t = uniform(-1.0, 3.0);
+                double sign = t > 1.0 ? -1.0 : 1.0;
+                t = t > 1.0 ? t - 2.0 : t;
+                c = sign * (1.0 - t * t) / (1.0 + t * t);
+                s = sign * 2.0 * t / (1.0 + t * t);
+            }
+            double local[4][2];
+            shape(kind, degenerate, local);
+            Point<T> p[4];
+            for (int i = 0; i < 4; ++i) {
+                p[i] = Point<T>(static_cast<T>(cx + c * local[i][0] - s * local[i][1]),
+                                static_cast<T>(cy + s * local[i][0] + c * local[i][1]));
+            }
+            try {
+                return makeFigure(kind, p);
+            } catch (const std::invalid_argument&) {
+            }
+        }
+    }
+
+    std::shared_ptr<Figure<T>> next() {
+        return next(static_cast<FigureKind>(rng() % 3));
+    }
+
+    Array<std::shared_ptr<Figure<T>>> generate(size_t count) {
+        Array<std::shared_ptr<Figure<T>>> figures(count);
+        for (size_t i = 0; i < count; ++i) {
+            figures.pushBack(next());
+        }
+        return figures;
+    }
+
+    uint64_t random() { return rng(); }
+    double random(double low, double high) { return uniform(low, high); }
+};
+
+enum class TraceOp : uint8_t {
+    Add,
+    Remove,
+    Total,
+    Range
+};
+
+constexpr size_t TraceOpCount = 4;
+
+inline const char* traceOpName(TraceOp op) {
+    switch (op) {
+        case TraceOp::Add:
+            return "add";
+        case TraceOp::Remove:
+            return "remove";
+        case TraceOp::Total:
+            return "total";
+        case TraceOp::Range:
+            return "range";
+    }
+    return "?";
+}
+
+template<Scalar T>
+struct TraceEvent {
+    TraceOp op;
+    std::shared_ptr<Figure<T>> figure;   // для Add
+    size_t index = 0;                     // для Remove
+    BoundingBox<T> box{T(0), T(0), T(0), T(0)};   // для Range
+};
+
+// Смесь операций трассы (доли нормируются) и начальное заполнение.
+struct TraceMix {
+    size_t initial = 0;
+    double add = 0.4;
+    double remove = 0.2;
+    double total = 0.2;
+    double range = 0.2;
+    double rangeSide = 100.0;
+};
+
+// Трасса из initial добавлений и ops операций по смеси mix. Индексы удаления
+// рассчитаны на воспроизведение с начала трассы на пустой коллекции;
+// удаление из пустой коллекции заменяется добавлением.
+template<std::floating_point T>
+std::vector<TraceEvent<T>> makeTrace(size_t ops, uint64_t seed, TraceMix mix = {}, WorkloadOptions options = {}) {
+    FigureGenerator<T> generator(seed, options);
+    std::vector<TraceEvent<T>> trace;
+    trace.reserve(mix.initial + ops);
+    size_t size = 0;
+    for (size_t i = 0; i < mix.initial; ++i) {
+        trace.push_back(TraceEvent<T>{TraceOp::Add, generator.next()});
+        ++size;
+    }
+    double weights = mix.add + mix.remove + mix.total + mix.range;
+    if (!(weights > 0.0)) {
+        throw std::invalid_argument("пустая смесь операций");
+    }
+    for (size_t i = 0; i < ops; ++i) {
+        double roll = generator.random(0.0, weights);
+        TraceEvent<T> event{TraceOp::Add, nullptr};
+        if (roll < mix.add + mix.remove && roll >= mix.add && size > 0) {
+            event.op = TraceOp::Remove;
+            event.index = static_cast<size_t>(generator.random() % size);
+            --size;
+        } else if (roll >= mix.add + mix.remove && roll < mix.add + mix.remove + mix.total) {
+            event.op = TraceOp::Total;
+        } else if (roll >= mix.add + mix.remove + mix.total) {
+            event.op = TraceOp::Range;
+            double x = generator.random(-options.extent, options.extent);
+            double y = generator.random(-options.extent, options.extent);
+            event.box = BoundingBox<T>{static_cast<T>(x), static_cast<T>(y), static_cast<T>(x + mix.rangeSide),
+                                       static_cast<T>(y + mix.rangeSide)};
+        } else {
+            event.figure = generator.next();
+            ++size;
+        }
+        trace.push_back(std::move(event));
+    }
+    return trace;
+}
+
+// Текстовый формат трассы: по операции на строку —
+// "A <фигура в формате figure_io>", "D <индекс>", "T", "Q minX minY maxX maxY".
+template<Scalar T>
+void writeTrace(std::ostream& outS, const std::vector<TraceEvent<T>>& trace) {
+    std::streamsize oldPrecision = outS.precision(std::numeric_limits<T>::max_digits10);
+    for (const TraceEvent<T>& event : trace) {
+        switch (event.op) {
+            case TraceOp::Add:
+                outS << "A ";
+                writeFigure(outS, *event.figure);
+                break;
+            case TraceOp::Remove:
+                outS << "D " << event.index << '\n';
+                break;
+            case TraceOp::Total:
+                outS << "T\n";
+                break;
+            case TraceOp::Range:
+                outS << "Q " << event.box.minX << ' ' << event.box.minY << ' ' << event.box.maxX << ' '
+                     << event.box.maxY << '\n';
+                break;
+        }
+    }
+    outS.precision(oldPrecision);
+}
+
+template<Scalar T>
+std::vector<TraceEvent<T>> parseTrace(std::string_view text) {
+    std::vector<TraceEvent<T>> trace;
+    size_t pos = 0;
+    skipSpaces(text, pos);
+    while (pos < text.size()) {
+        size_t opPosition = pos;
+        char op = text[pos++];
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        TraceEvent<T> event{TraceOp::Add, nullptr};
+        switch (op) {
+            case 'A': {
+                Array<std::shared_ptr<Figure<T>>> figures;
+                try {
+                    figures = parseFigures<T>(text.substr(pos, end - pos));
+                } catch (const ParseError& err) {
+                    throw ParseError(err.reason(), pos + err.position());
+                }
+                if (figures.getSize() != 1) {
+                    throw ParseError("ожидалась одна фигура", opPosition);
+                }
+                event.figure = figures[0];
+                pos = end;
+                break;
+            }
+            case 'D':
+                event.op = TraceOp::Remove;
+                event.index = parseNumber<size_t>(text, pos);
+                break;
+            case 'T':
+                event.op = TraceOp::Total;
+                break;
+            case 'Q':
+                event.op = TraceOp::Range;
+                event.box.minX = parseNumber<T>(text, pos);
+                event.box.minY = parseNumber<T>(text, pos);
+                event.box.maxX = parseNumber<T>(text, pos);
+                event.box.maxY = parseNumber<T>(text, pos);
+                break;
+            default:
+                throw ParseError("неизвестная операция трассы", opPosition);
+        }
+        trace.push_back(std::move(event));
+        skipSpaces(text, pos);
+    }
+    return trace;
+}
+
+// Гистограмма задержек в наносекундах с логарифмически-линейными корзинами:
+// значения до 64 хранятся точно, дальше каждая октава делится на 64 корзины,
+// так что процентиль отличается от точного не больше чем на 1/64.
+class LatencyHistogram {
+private:
+    static constexpr size_t SubBuckets = 64;
+    static constexpr size_t Octaves = 58;
+
+    std::array<uint64_t, SubBuckets * (Octaves + 1)> buckets{};
+    uint64_t count = 0;
+    uint64_t minValue = std::numeric_limits<uint64_t>::max();
+    uint64_t maxValue = 0;
+    double sum = 0.0;
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < SubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        size_t shift = static_cast<size_t>(std::bit_width(value)) - 7;
+        return SubBuckets * (shift + 1) + static_cast<size_t>((value >> shift) - SubBuckets);
+    }
+
+    // Верхняя граница корзины: процентиль не занижается.
+    static uint64_t bucketHigh(size_t bucket) {
+        if (bucket < SubBuckets) {
+            return bucket;
+        }
+        size_t shift = bucket / SubBuckets - 1;
+        uint64_t base = SubBuckets + bucket % SubBuckets;
+        return ((base + 1) << shift) - 1;
+    }
+
+public:
+    void record(uint64_t nanoseconds) {
+        ++buckets[bucketOf(nanoseconds)];
+        ++count;
+        minValue = std::min(minValue, nanoseconds);
+        maxValue = std::max(maxValue, nanoseconds);
+        sum += static_cast<double>(nanoseconds);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+        sum += other.sum;
+    }
+
+    // Значение, не меньше которого не более доли 1 - q записей; q от 0 до 1.
+    uint64_t percentile(double q) const {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return std::clamp(bucketHigh(i), minValue, maxValue);
+            }
+        }
+        return maxValue;
+    }
+
+    uint64_t getCount() const { return count; }
+    uint64_t getMin() const { return count ? minValue : 0; }
+    uint64_t getMax() const { return maxValue; }
+    double getMean() const { return count ? sum / static_cast<double>(count) : 0.0; }
+};
+
+// Строка отчета: число операций, p50/p99/p999 и максимум в микросекундах.
+inline void printLatency(std::ostream& outS, const char* name, const LatencyHistogram& histogram) {
+    outS << "  " << name << ": " << histogram.getCount() << " ops, p50 " << histogram.percentile(0.5) / 1e3
+         << " us, p99 " << histogram.percentile(0.99) / 1e3 << " us, p999 " << histogram.percentile(0.999) / 1e3
+         << " us, max " << histogram.getMax() / 1e3 << " us\n";
+}
+
+template<typename Target, typename T>
+concept ReplayTarget = requires(Target& target, std::shared_ptr<Figure<T>> figure, size_t index,
+                                const BoundingBox<T>& box) {
+    target.add(figure);
+    target.remove(index);
+    { target.total() } -> std::convertible_to<double>;
+    { target.range(box) } -> std::convertible_to<size_t>;
+};
+
+// Цель воспроизведения по умолчанию: коллекция с поддерживаемыми агрегатами;
+// запрос окна — перебор прямоугольников всех фигур.
+template<Scalar T>
+class AggregateReplayTarget {
+private:
+    AggregateArray<T> figures;
+
+public:
+    void add(std::shared_ptr<Figure<T>> figure) { figures.pushBack(std::move(figure)); }
+    void remove(size_t index) { figures.remove(index); }
+    double total() const { return figures.totalArea(); }
+
+    size_t range(const BoundingBox<T>& box) const {
+        size_t found = 0;
+        for (size_t i = 0; i < figures.getSize(); ++i) {
+            found += boundingBox(*figures[i]).intersects(box);
+        }
+        return found;
+    }
+
+    const AggregateArray<T>& getFigures() const { return figures; }
+};
+
+struct ReplayReport {
+    std::array<LatencyHistogram, TraceOpCount> byOp;
+    LatencyHistogram all;
+    double seconds = 0.0;
+    double checksum = 0.0;   // сумма результатов запросов, чтобы их нельзя было выбросить
+};
+
+// Воспроизводит трассу подряд без пауз, замеряя каждую операцию отдельно.
+template<Scalar T, typename Target>
+    requires ReplayTarget<Target, T>
+ReplayReport replayTrace(const std::vector<TraceEvent<T>>& trace, Target& target) {
+    using Clock = std::chrono::steady_clock;
+    ReplayReport report;
+    Clock::time_point begin = Clock::now();
+    for (const TraceEvent<T>& event : trace) {
+        Clock::time_point start = Clock::now();
+        switch (event.op) {
+            case TraceOp::Add:
+                target.add(event.figure);
+                break;
+            case TraceOp::Remove:
+                target.remove(event.index);
+                break;
+            case TraceOp::Total:
+                report.checksum += target.total();
+                break;
+            case TraceOp::Range:
+                report.checksum += static_cast<double>(target.range(event.box));
+                break;
+        }
+        uint64_t elapsed = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        report.byOp[static_cast<size_t>(event.op)].record(elapsed);
+        report.all.record(elapsed);
+    }
+    report.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    return report;
+}
+
+#endif
\ No newline at end of file